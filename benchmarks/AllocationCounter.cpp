@@ -0,0 +1,67 @@
+/**
+ * Hermes - A RPC for IOT
+ * Copyright (C) 2023  Eduard Sargsyan and Andrey Ovodov
+ * 
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ * 
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ * 
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#include "BenchHelpers.h"
+
+#include <atomic>
+#include <new>
+#include <stdlib.h>
+
+/**
+ * Counts every heap allocation in the benchmark binary, so benchmarks can
+ * check that steady state traffic does not allocate.
+*/
+static std::atomic<uint64_t> s_allocations { 0 };
+
+uint64_t hermes::bench::allocationCount()
+{
+    return s_allocations.load(std::memory_order_relaxed);
+}
+
+void* operator new(size_t size)
+{
+    s_allocations.fetch_add(1, std::memory_order_relaxed);
+    if (void* p = malloc(size ? size : 1))
+        return p;
+    throw std::bad_alloc();
+}
+
+void* operator new[](size_t size)
+{
+    return ::operator new(size);
+}
+
+void operator delete(void* p) noexcept
+{
+    free(p);
+}
+
+void operator delete[](void* p) noexcept
+{
+    free(p);
+}
+
+void operator delete(void* p, size_t) noexcept
+{
+    free(p);
+}
+
+void operator delete[](void* p, size_t) noexcept
+{
+    free(p);
+}
@@ -0,0 +1,182 @@
+/**
+ * Hermes - A RPC for IOT
+ * Copyright (C) 2023  Eduard Sargsyan and Andrey Ovodov
+ * 
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ * 
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ * 
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#ifndef HM_BENCH_HELPERS_H
+#define HM_BENCH_HELPERS_H
+
+#include <hermes/EasySlave.h>
+#include <hermes/EasySlaveProperty.h>
+#include <hermes/InMemoryIO.h>
+#include <hermes/Message.h>
+#include <hermes/MessageBuilder.h>
+
+#include <benchmark/benchmark.h>
+
+#include <algorithm>
+#include <chrono>
+#include <memory>
+#include <stdio.h>
+#include <vector>
+
+namespace hermes
+{
+namespace bench
+{
+    static const byte_t kSerial[HERMES_SERIAL_LENGTH] = { 'B', 'E', 'N', 'C', 'H', '0', '0', '1' };
+    static const byte_t kToken[HERMES_TOKEN_LENGTH] = { 0 };
+
+    /**
+     * @return Number of operator new calls made by the process so far.
+    */
+    uint64_t allocationCount();
+
+    /**
+     * Collects per-operation wall clock latencies and reports p50/p99 as
+     * benchmark counters (in microseconds), together with heap allocations
+     * per operation. Only the last Capacity samples are kept, so recording
+     * does not allocate.
+    */
+    class LatencyRecorder
+    {
+    public:
+        using clock_t = std::chrono::steady_clock;
+        static constexpr size_t Capacity = 1 << 16;
+
+        LatencyRecorder()
+            : m_samples(Capacity)
+            , m_allocations(allocationCount())
+        {}
+
+        inline void start() { m_start = clock_t::now(); }
+
+        inline void stop()
+        {
+            m_samples[m_count++ % Capacity] = std::chrono::duration<double, std::micro>(clock_t::now() - m_start).count();
+        }
+
+        void report(benchmark::State& state)
+        {
+            const uint64_t allocations = allocationCount() - m_allocations;
+            state.SetItemsProcessed(state.iterations());
+            if (state.iterations() > 0)
+                state.counters["allocs_per_op"] = double(allocations) / state.iterations();
+            if (m_count == 0)
+                return;
+            m_samples.resize(std::min(m_count, Capacity));
+            state.counters["p50_us"] = percentile(0.50);
+            state.counters["p99_us"] = percentile(0.99);
+        }
+
+    private:
+        double percentile(double p)
+        {
+            size_t idx = static_cast<size_t>(p * (m_samples.size() - 1));
+            std::nth_element(m_samples.begin(), m_samples.begin() + idx, m_samples.end());
+            return m_samples[idx];
+        }
+
+    private:
+        std::vector<double> m_samples;
+        size_t m_count = 0;
+        uint64_t m_allocations;
+        clock_t::time_point m_start;
+    };
+
+    /**
+     * Owns N integer properties named "property_<i>" for BenchSlave.
+    */
+    template<uint8_t N>
+    struct PropertyStorage
+    {
+        PropertyStorage()
+        {
+            for (int i = 0; i < N; ++i) {
+                char name[HERMES_PROPERTY_NAME_MAX_LENGTH];
+                snprintf(name, sizeof(name), "property_%d", i);
+                owned[i].reset(new CachedSlaveProperty<int32_t>(name, i));
+                ptrs[i] = owned[i].get();
+            }
+        }
+
+        std::unique_ptr<CachedSlaveProperty<int32_t>> owned[N];
+        SlaveProperty* ptrs[N];
+    };
+
+    /**
+     * EasySlave with N integer properties which exposes the dispatch path.
+    */
+    template<uint8_t N>
+    class BenchSlave : private PropertyStorage<N>, public EasySlave<N>
+    {
+    public:
+        explicit BenchSlave(IO* io)
+            : PropertyStorage<N>()
+            , EasySlave<N>(this->ptrs, io, kSerial, kToken)
+        {}
+
+        using DummySlave::handleCommandRequest;
+    };
+
+    /**
+     * Two InMemoryIO endpoints connected back to back.
+    */
+    struct InMemoryPair
+    {
+        InMemoryPair()
+            : master(m_toSlave, m_toMaster, m_mx, 4096)
+            , slave(m_toMaster, m_toSlave, m_mx, 4096)
+        {}
+
+    private:
+        std::vector<byte_t> m_toSlave;
+        std::vector<byte_t> m_toMaster;
+        std::mutex m_mx;
+
+    public:
+        InMemoryIO master;
+        InMemoryIO slave;
+    };
+
+    inline Message commandRequest(Command cmd)
+    {
+        Message req;
+        memset(&req, 0, sizeof(req));
+        MessageBuilder::setSerial(req, kSerial);
+        MessageBuilder::setToken(req, kToken);
+        req.type = MessageType::Command;
+        req.payload.command.command = cmd;
+        req.payloadLength = sizeof(CommandData);
+        return req;
+    }
+
+    inline Message getRequest(const char* name)
+    {
+        Message req = commandRequest(Command::Get);
+        strncpy(req.payload.command.data.get.name, name, HERMES_PROPERTY_NAME_MAX_LENGTH - 1);
+        return req;
+    }
+
+    /**
+     * Creates a connected pair of TCP sockets over 127.0.0.1.
+     * @return false if any of the socket calls failed.
+    */
+    bool tcpLoopbackPair(int& masterFd, int& slaveFd);
+} // namespace bench
+} // namespace hermes
+
+#endif // HM_BENCH_HELPERS_H
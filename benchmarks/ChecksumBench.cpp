@@ -0,0 +1,38 @@
+/**
+ * Hermes - A RPC for IOT
+ * Copyright (C) 2023  Eduard Sargsyan and Andrey Ovodov
+ * 
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ * 
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ * 
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#include "BenchHelpers.h"
+
+#include <hermes/Crc32c.h>
+
+using namespace hermes;
+
+template<uint32_t (*Crc)(const byte_t*, size_t, uint32_t)>
+static void BM_Crc32c(benchmark::State& state)
+{
+    std::vector<byte_t> data(state.range(0));
+    for (size_t i = 0; i < data.size(); ++i)
+        data[i] = static_cast<byte_t>(i * 31);
+
+    for (auto _ : state) {
+        benchmark::DoNotOptimize(Crc(data.data(), data.size(), 0));
+    }
+    state.SetBytesProcessed(state.iterations() * data.size());
+}
+BENCHMARK_TEMPLATE(BM_Crc32c, crc32c)->Arg(sizeof(Message))->Arg(4096);
+BENCHMARK_TEMPLATE(BM_Crc32c, crc32cPortable)->Arg(sizeof(Message))->Arg(4096);
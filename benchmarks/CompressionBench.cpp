@@ -0,0 +1,62 @@
+/**
+ * Hermes - A RPC for IOT
+ * Copyright (C) 2023  Eduard Sargsyan and Andrey Ovodov
+ * 
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ * 
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ * 
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#include "BenchHelpers.h"
+
+#include <hermes/Compression.h>
+
+using namespace hermes;
+using namespace hermes::bench;
+
+namespace
+{
+    Message stringResponse()
+    {
+        Message msg = getRequest("model_name");
+        msg.payload.command.data.value.type = ValueType::String;
+        strcpy(msg.payload.command.data.value.value.S, "ACME SuperSensor 3000 rev.B");
+        return msg;
+    }
+} // namespace
+
+static void BM_LzCompress(benchmark::State& state)
+{
+    const Message msg = stringResponse();
+    byte_t out[lzBound(sizeof(Message))];
+    size_t length = 0;
+    for (auto _ : state) {
+        length = lzCompress(reinterpret_cast<const byte_t*>(&msg), sizeof(msg), out, sizeof(out));
+        benchmark::DoNotOptimize(out);
+    }
+    state.SetBytesProcessed(state.iterations() * sizeof(msg));
+    state.counters["ratio"] = double(sizeof(msg)) / double(length);
+}
+BENCHMARK(BM_LzCompress);
+
+static void BM_LzDecompress(benchmark::State& state)
+{
+    const Message msg = stringResponse();
+    byte_t packed[lzBound(sizeof(Message))];
+    const size_t length = lzCompress(reinterpret_cast<const byte_t*>(&msg), sizeof(msg), packed, sizeof(packed));
+    Message out;
+    for (auto _ : state) {
+        benchmark::DoNotOptimize(lzDecompress(packed, length, reinterpret_cast<byte_t*>(&out), sizeof(out)));
+    }
+    state.SetBytesProcessed(state.iterations() * sizeof(msg));
+}
+BENCHMARK(BM_LzDecompress);
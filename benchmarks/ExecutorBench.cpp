@@ -0,0 +1,75 @@
+/**
+ * Hermes - A RPC for IOT
+ * Copyright (C) 2023  Eduard Sargsyan and Andrey Ovodov
+ * 
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ * 
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ * 
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#include "BenchHelpers.h"
+
+#include <hermes/WorkStealingPool.h>
+
+#include <atomic>
+
+using namespace hermes;
+
+namespace
+{
+    // Stand-in for a user callback doing a bit of work
+    void callbackWork(std::atomic<uint64_t>& sink)
+    {
+        uint64_t x = 0;
+        for (int i = 0; i < 256; ++i)
+            x += i * 2654435761u;
+        sink.fetch_add(x, std::memory_order_relaxed);
+    }
+} // namespace
+
+/**
+ * Callbacks of range(1) slaves posted from one reader thread onto a pool of
+ * range(0) workers.
+*/
+static void BM_WorkStealingPoolCallbacks(benchmark::State& state)
+{
+    WorkStealingPool pool(static_cast<unsigned>(state.range(0)));
+    const size_t slaves = static_cast<size_t>(state.range(1));
+    std::vector<int> keys(slaves);
+    std::atomic<uint64_t> sink { 0 };
+    size_t next = 0;
+
+    for (auto _ : state) {
+        for (int i = 0; i < 1000; ++i) {
+            pool.post(&keys[next], [&sink]() { callbackWork(sink); });
+            next = (next + 1) % slaves;
+        }
+        pool.wait();
+    }
+    state.SetItemsProcessed(state.iterations() * 1000);
+    state.counters["stolen"] = static_cast<double>(pool.stats().stolen);
+}
+BENCHMARK(BM_WorkStealingPoolCallbacks)->Args({ 1, 64 })->Args({ 4, 64 })->Args({ 4, 1 })->UseRealTime();
+
+/**
+ * Same callbacks run inline on the reading thread
+*/
+static void BM_InlineCallbacks(benchmark::State& state)
+{
+    std::atomic<uint64_t> sink { 0 };
+    for (auto _ : state) {
+        for (int i = 0; i < 1000; ++i)
+            callbackWork(sink);
+    }
+    state.SetItemsProcessed(state.iterations() * 1000);
+}
+BENCHMARK(BM_InlineCallbacks)->UseRealTime();
@@ -0,0 +1,130 @@
+/**
+ * Hermes - A RPC for IOT
+ * Copyright (C) 2023  Eduard Sargsyan and Andrey Ovodov
+ * 
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ * 
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ * 
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#include "BenchHelpers.h"
+
+using namespace hermes;
+using namespace hermes::bench;
+
+static void BM_MessageBuilder_Handshake(benchmark::State& state)
+{
+    for (auto _ : state) {
+        Message msg = MessageBuilder::handshake(kSerial, 1, 0, 0, kToken);
+        benchmark::DoNotOptimize(msg);
+    }
+    state.SetItemsProcessed(state.iterations());
+}
+BENCHMARK(BM_MessageBuilder_Handshake);
+
+static void BM_MessageBuilder_GetRequest(benchmark::State& state)
+{
+    for (auto _ : state) {
+        Message msg = getRequest("property_0");
+        benchmark::DoNotOptimize(msg);
+    }
+    state.SetItemsProcessed(state.iterations());
+}
+BENCHMARK(BM_MessageBuilder_GetRequest);
+
+static void BM_MessageBuilder_Error(benchmark::State& state)
+{
+    Message msg = commandRequest(Command::Get);
+    for (auto _ : state) {
+        MessageBuilder::setError(msg, ErrorType::Unsupported, "Property does not exists");
+        benchmark::DoNotOptimize(msg);
+    }
+    state.SetItemsProcessed(state.iterations());
+}
+BENCHMARK(BM_MessageBuilder_Error);
+
+/**
+ * Parse a Get response from its wire representation and format the value,
+ * which is what a master does for every polled property.
+*/
+static void BM_Message_ParseGetResponse(benchmark::State& state)
+{
+    Message rsp = getRequest("property_0");
+    rsp.payload.command.data.value.type = static_cast<ValueType>(state.range(0));
+    switch (rsp.payload.command.data.value.type) {
+    case ValueType::Boolean: rsp.payload.command.data.value.value.B = 1; break;
+    case ValueType::Integer: rsp.payload.command.data.value.value.I = -123456; break;
+    case ValueType::UnsignedInteger: rsp.payload.command.data.value.value.U = 123456; break;
+    case ValueType::String: strcpy(rsp.payload.command.data.value.value.S, "AquaboxBase Dosator"); break;
+    case ValueType::Float: rsp.payload.command.data.value.value.F = { 3145, 1000 }; break;
+    }
+
+    byte_t wire[sizeof(Message)];
+    memcpy(wire, &rsp, sizeof(Message));
+
+    char str[HERMES_STRING_LENGTH];
+    for (auto _ : state) {
+        Message msg;
+        memcpy(&msg, wire, sizeof(Message));
+        if (msg.type == MessageType::Command && msg.payload.command.command == Command::Get)
+            benchmark::DoNotOptimize(vd2str(msg.payload.command.data.value, str));
+        benchmark::ClobberMemory();
+    }
+    state.SetItemsProcessed(state.iterations());
+}
+BENCHMARK(BM_Message_ParseGetResponse)
+    ->ArgName("type")
+    ->Arg(ValueType::Boolean)
+    ->Arg(ValueType::Integer)
+    ->Arg(ValueType::UnsignedInteger)
+    ->Arg(ValueType::String)
+    ->Arg(ValueType::Float);
+
+/**
+ * Format a batch of values of mixed types into one buffer, as an exporter
+ * of telemetry does.
+*/
+static void BM_Value_FormatBatch(benchmark::State& state)
+{
+    ValueData values[256] = {};
+    for (size_t i = 0; i < 256; ++i) {
+        values[i].type = static_cast<ValueType>(i % 5);
+        switch (values[i].type) {
+        case ValueType::Boolean: values[i].value.B = i & 1; break;
+        case ValueType::Integer: values[i].value.I = -int32_t(i * 7919); break;
+        case ValueType::UnsignedInteger: values[i].value.U = uint32_t(i * 104729); break;
+        case ValueType::String: strcpy(values[i].value.S, "AquaboxBase Dosator"); break;
+        case ValueType::Float: values[i].value.F = { int32_t(i * 3145), 1000 }; break;
+        }
+    }
+
+    char buffer[256 * 24];
+    for (auto _ : state) {
+        char* end;
+        benchmark::DoNotOptimize(formatValues(buffer, buffer + sizeof(buffer), values, 256, '\n', end));
+        benchmark::ClobberMemory();
+    }
+    state.SetItemsProcessed(state.iterations() * 256);
+}
+BENCHMARK(BM_Value_FormatBatch);
+
+static void BM_Value_ParseFloat(benchmark::State& state)
+{
+    const char str[] = "-1234.567";
+    for (auto _ : state) {
+        FloatValue value;
+        benchmark::DoNotOptimize(parseFloat(str, str + sizeof(str) - 1, value));
+        benchmark::DoNotOptimize(value);
+    }
+    state.SetItemsProcessed(state.iterations());
+}
+BENCHMARK(BM_Value_ParseFloat);
@@ -0,0 +1,78 @@
+/**
+ * Hermes - A RPC for IOT
+ * Copyright (C) 2023  Eduard Sargsyan and Andrey Ovodov
+ * 
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ * 
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ * 
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#include "BenchHelpers.h"
+
+using namespace hermes;
+using namespace hermes::bench;
+
+/**
+ * Cost of DummySlave::handleCommandRequest for every command a master sends
+ * in the steady state, without any IO involved.
+*/
+static void BM_DummySlave_HandleCommandRequest(benchmark::State& state)
+{
+    BenchSlave<8> slave(nullptr);
+    const Command cmd = static_cast<Command>(state.range(0));
+
+    Message req = commandRequest(cmd);
+    if (cmd == Command::Get || cmd == Command::Set) {
+        req = getRequest("property_7");
+        req.payload.command.command = cmd;
+        req.payload.command.data.set.type = ValueType::Integer;
+        req.payload.command.data.set.value.I = 42;
+    }
+    else if (cmd == Command::GetPropertyName) {
+        req.payload.command.data.index = 7;
+    }
+
+    Message rsp;
+    for (auto _ : state) {
+        benchmark::DoNotOptimize(slave.handleCommandRequest(&req, &rsp));
+        benchmark::ClobberMemory();
+    }
+    state.SetLabel(cmd2str(cmd));
+    state.SetItemsProcessed(state.iterations());
+}
+BENCHMARK(BM_DummySlave_HandleCommandRequest)
+    ->ArgName("cmd")
+    ->Arg(static_cast<int>(Command::GetPropertiesCount))
+    ->Arg(static_cast<int>(Command::GetPropertyName))
+    ->Arg(static_cast<int>(Command::Get))
+    ->Arg(static_cast<int>(Command::Set));
+
+/**
+ * Worst case (last property) lookup by name for different property counts.
+*/
+template<uint8_t N>
+static void BM_EasySlave_PropertyIndex(benchmark::State& state)
+{
+    BenchSlave<N> slave(nullptr);
+    char name[HERMES_PROPERTY_NAME_MAX_LENGTH];
+    snprintf(name, sizeof(name), "property_%d", N - 1);
+
+    for (auto _ : state) {
+        benchmark::DoNotOptimize(slave.propertyIndex(name));
+    }
+    state.SetItemsProcessed(state.iterations());
+}
+BENCHMARK_TEMPLATE(BM_EasySlave_PropertyIndex, 1);
+BENCHMARK_TEMPLATE(BM_EasySlave_PropertyIndex, 8);
+BENCHMARK_TEMPLATE(BM_EasySlave_PropertyIndex, 32);
+BENCHMARK_TEMPLATE(BM_EasySlave_PropertyIndex, 128);
+BENCHMARK_TEMPLATE(BM_EasySlave_PropertyIndex, 255);
@@ -0,0 +1,63 @@
+/**
+ * Hermes - A RPC for IOT
+ * Copyright (C) 2023  Eduard Sargsyan and Andrey Ovodov
+ * 
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ * 
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ * 
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#include "BenchHelpers.h"
+
+#include <hermes/TelemetryCollector.h>
+
+using namespace hermes;
+using namespace hermes::bench;
+
+namespace
+{
+    class NullSink: public TelemetrySink
+    {
+    public:
+        bool write(const byte_t* data, size_t length) override
+        {
+            benchmark::DoNotOptimize(data);
+            bytes += length;
+            return true;
+        }
+
+        size_t bytes = 0;
+    };
+} // namespace
+
+/**
+ * Collect integer samples of 100 slaves with the default batch, blocks go to
+ * a sink which drops them.
+*/
+static void BM_Telemetry_Add(benchmark::State& state)
+{
+    NullSink sink;
+    TelemetryCollector collector(&sink);
+    serial_t serial(kSerial);
+    ValueData value = {};
+    value.type = ValueType::Integer;
+    uint64_t timestamp = 0;
+    for (auto _ : state) {
+        serial.data[0] = uint8_t(timestamp % 100);
+        value.value.I = int32_t(timestamp);
+        benchmark::DoNotOptimize(collector.add(serial, uint8_t(timestamp % 8), timestamp, value));
+        ++timestamp;
+    }
+    state.SetItemsProcessed(state.iterations());
+    state.counters["bytes/sample"] = double(sink.bytes) / double(timestamp);
+}
+BENCHMARK(BM_Telemetry_Add);
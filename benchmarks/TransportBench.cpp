@@ -0,0 +1,197 @@
+/**
+ * Hermes - A RPC for IOT
+ * Copyright (C) 2023  Eduard Sargsyan and Andrey Ovodov
+ * 
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ * 
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ * 
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#include "BenchHelpers.h"
+
+#include <hermes/FramedIO.h>
+#include <hermes/SizedFrameIO.h>
+#include <hermes/SlaveDescriptor.h>
+#include <hermes/UnixTCPSocketIO.h>
+
+#include <arpa/inet.h>
+#include <netinet/in.h>
+#include <netinet/tcp.h>
+#include <sys/socket.h>
+#include <unistd.h>
+#include <thread>
+
+using namespace hermes;
+using namespace hermes::bench;
+
+bool hermes::bench::tcpLoopbackPair(int& masterFd, int& slaveFd)
+{
+    int listenFd = socket(AF_INET, SOCK_STREAM, 0);
+    if (listenFd < 0)
+        return false;
+
+    struct sockaddr_in addr;
+    memset(&addr, 0, sizeof(addr));
+    addr.sin_family = AF_INET;
+    addr.sin_addr.s_addr = htonl(INADDR_LOOPBACK);
+    addr.sin_port = 0;
+    socklen_t len = sizeof(addr);
+
+    bool ok = bind(listenFd, (struct sockaddr*)&addr, sizeof(addr)) == 0
+           && listen(listenFd, 1) == 0
+           && getsockname(listenFd, (struct sockaddr*)&addr, &len) == 0;
+
+    slaveFd = ok ? socket(AF_INET, SOCK_STREAM, 0) : -1;
+    ok = ok && slaveFd >= 0 && connect(slaveFd, (struct sockaddr*)&addr, sizeof(addr)) == 0;
+    masterFd = ok ? accept(listenFd, nullptr, nullptr) : -1;
+    ok = ok && masterFd >= 0;
+    ::close(listenFd);
+
+    if (ok) {
+        const int one = 1;
+        setsockopt(masterFd, IPPROTO_TCP, TCP_NODELAY, &one, sizeof(one));
+        setsockopt(slaveFd, IPPROTO_TCP, TCP_NODELAY, &one, sizeof(one));
+    }
+    return ok;
+}
+
+/**
+ * Full request/response over InMemoryIO: the master writes a request, the
+ * slave reads, dispatches and replies, and the master reads the reply.
+ * Both sides are pumped on the calling thread since InMemoryIO::wait sleeps.
+*/
+static void BM_InMemoryIO_RoundTrip(benchmark::State& state)
+{
+    InMemoryPair link;
+    BenchSlave<8> slave(&link.slave);
+    const Command cmd = static_cast<Command>(state.range(0));
+    const Message req = cmd == Command::Get ? getRequest("property_7") : commandRequest(cmd);
+
+    IO& master = link.master;
+    LatencyRecorder latency;
+    Message rsp;
+    for (auto _ : state) {
+        latency.start();
+        master.write(req);
+        slave.processNextMessage();
+        master.read(rsp);
+        latency.stop();
+        benchmark::DoNotOptimize(rsp);
+    }
+    state.SetLabel(cmd2str(cmd));
+    latency.report(state);
+}
+BENCHMARK(BM_InMemoryIO_RoundTrip)
+    ->ArgName("cmd")
+    ->Arg(static_cast<int>(Command::GetPropertiesCount))
+    ->Arg(static_cast<int>(Command::Get));
+
+/**
+ * Same as BM_InMemoryIO_RoundTrip but with small frames on the wire.
+*/
+static void BM_SizedFrameIO_RoundTrip(benchmark::State& state)
+{
+    using SmallTraits = MessageTraits<HERMES_SERIAL_LENGTH, HERMES_TOKEN_LENGTH, 16, 16, 16>;
+
+    InMemoryPair link;
+    SizedFrameIO<SmallTraits> master(&link.master);
+    SizedFrameIO<SmallTraits> slaveIo(&link.slave);
+    BenchSlave<8> slave(&slaveIo);
+    const Message req = getRequest("property_7");
+
+    LatencyRecorder latency;
+    Message rsp;
+    for (auto _ : state) {
+        latency.start();
+        master.IO::write(req);
+        slave.processNextMessage();
+        master.IO::read(rsp);
+        latency.stop();
+        benchmark::DoNotOptimize(rsp);
+    }
+    state.counters["frame_bytes"] = sizeof(BasicMessage<SmallTraits>);
+    latency.report(state);
+}
+BENCHMARK(BM_SizedFrameIO_RoundTrip);
+
+/**
+ * Same as BM_InMemoryIO_RoundTrip with CRC32C protected frames.
+*/
+static void BM_FramedIO_RoundTrip(benchmark::State& state)
+{
+    InMemoryPair link;
+    FramedIO master(&link.master);
+    FramedIO slaveIo(&link.slave);
+    BenchSlave<8> slave(&slaveIo);
+    const Message req = getRequest("property_7");
+
+    LatencyRecorder latency;
+    Message rsp;
+    for (auto _ : state) {
+        latency.start();
+        master.IO::write(req);
+        slave.processNextMessage();
+        master.IO::read(rsp);
+        latency.stop();
+        benchmark::DoNotOptimize(rsp);
+    }
+    latency.report(state);
+}
+BENCHMARK(BM_FramedIO_RoundTrip);
+
+/**
+ * SlaveDescriptor talking to a slave thread over a loopback TCP connection,
+ * one round trip per request. Command::GetRoutesCount is never answered from
+ * the schema; Command::Get looks the name up on the wire only the first time.
+*/
+static void BM_UnixTCPSocketIO_RoundTrip(benchmark::State& state)
+{
+    int masterFd = -1, slaveFd = -1;
+    if (!tcpLoopbackPair(masterFd, slaveFd)) {
+        state.SkipWithError("Can't create loopback connection");
+        return;
+    }
+
+    UnixTCPSocketIO masterIo(masterFd);
+    UnixTCPSocketIO slaveIo(slaveFd);
+    BenchSlave<8> slave(&slaveIo);
+    std::thread slaveThread([&slave, &slaveIo]() {
+        while (slaveIo.good())
+            slave.loop();
+    });
+
+    serial_t serial(kSerial);
+    SlaveDescriptor descriptor(&masterIo, serial);
+    const Command cmd = static_cast<Command>(state.range(0));
+
+    LatencyRecorder latency;
+    ValueData vd;
+    for (auto _ : state) {
+        latency.start();
+        if (cmd == Command::Get)
+            benchmark::DoNotOptimize(descriptor.get(7, vd));
+        else
+            benchmark::DoNotOptimize(descriptor.routesCount());
+        latency.stop();
+    }
+
+    descriptor.close();
+    slaveThread.join();
+
+    state.SetLabel(cmd2str(cmd));
+    latency.report(state);
+}
+BENCHMARK(BM_UnixTCPSocketIO_RoundTrip)
+    ->ArgName("cmd")
+    ->Arg(static_cast<int>(Command::GetRoutesCount))
+    ->Arg(static_cast<int>(Command::Get))
+    ->UseRealTime();
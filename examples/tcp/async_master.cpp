@@ -0,0 +1,101 @@
+/**
+ * Hermes - A RPC for IOT
+ * Copyright (C) 2023  Eduard Sargsyan and Andrey Ovodov
+ * 
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ * 
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ * 
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#include <iostream>
+#include <sys/socket.h>
+#include <arpa/inet.h>
+#include <unistd.h>
+#include <string.h>
+
+#include <hermes/Master.h>
+#include <hermes/AsyncSlaveDescriptor.h>
+#include <hermes/UnixTCPSocketIO.h>
+
+// Same as tcp_master, but all slaves are served by two threads
+hermes::AsyncExecutor executor(2);
+
+hermes::Master master(nullptr);
+
+bool accept_all(const hermes::serial_t& serial, hermes::token_t& token)
+{
+    (void) serial;
+    for(int i = 0; i < HERMES_TOKEN_LENGTH; ++i) token.data[i] = rand();
+    return true;
+}
+
+hermes::Task<void> talk(hermes::AsyncSlaveDescriptor* slave)
+{
+    const uint8_t count = co_await slave->propertiesCount();
+    std::cout << "Properties count " << (int) count << std::endl;
+    for (uint8_t i = 0; i < count; ++i)
+    {
+        hermes::ValueData vd;
+        if (co_await slave->get(i, vd))
+            std::cout << "\t\t\t" << vd.name << " = " << hermes::vd2str(vd) << std::endl;
+        else
+            std::cout << "\t\t\t*** CANT'T GET VALUE FOR PROPERTY " << (int) i << "!!!***" << std::endl;
+    }
+    delete slave;
+}
+
+void new_slave(hermes::SlaveDescriptor* slave)
+{
+    executor.spawn(talk(new hermes::AsyncSlaveDescriptor(executor, *slave)));
+}
+
+int main(int argc, char** argv)
+{
+    master.setAuthenticator(accept_all);
+    master.setOnNewSlaveCallback(new_slave);
+
+    unsigned int port = 1311;
+    if (argc < 2 || sscanf(argv[1], "%u", &port) != 1)
+    {
+        std::cerr << "Usage: " << argv[0] << " <port num>" << std::endl;
+        return -1;
+    }
+
+    int sockfd = socket(AF_INET, SOCK_STREAM, 0);
+    const int reuse = 1;
+    setsockopt(sockfd, SOL_SOCKET, SO_REUSEADDR, &reuse, sizeof(int));
+
+    struct sockaddr_in servaddr;
+    bzero(&servaddr, sizeof(servaddr));
+    servaddr.sin_family = AF_INET;
+    servaddr.sin_addr.s_addr = htonl(INADDR_ANY);
+    servaddr.sin_port = htons(port);
+
+    if (bind(sockfd, (struct sockaddr*)&servaddr, sizeof(servaddr)) != 0 || listen(sockfd, 128) != 0)
+    {
+        std::cerr << "Error: " << strerror(errno) << std::endl;
+        return -1;
+    }
+
+    std::cout << "Listening on " << port << "..." << std::endl;
+
+    int clientfd = 0;
+    while ((clientfd = accept(sockfd, nullptr, nullptr)) >= 0)
+    {
+        hermes::UnixTCPSocketIO *io = new hermes::UnixTCPSocketIO(clientfd);
+        if (!master.accept(io))
+            delete io;
+    }
+
+    ::close(sockfd);
+    return 0;
+}
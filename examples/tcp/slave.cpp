@@ -17,6 +17,8 @@
 */
 
 #include <iostream>
+#include <memory>
+#include <unistd.h>
 #include <sys/socket.h>
 #include <sys/types.h>
 #include <arpa/inet.h>
@@ -34,6 +36,19 @@ hermes::CachedSlaveProperty<float> remain2("Channel_2_remain", 2.74);
 hermes::byte_t token[HERMES_TOKEN_LENGTH];
 hermes::byte_t serial[HERMES_SERIAL_LENGTH];
 
+int connectTo(const struct sockaddr_in& addr)
+{
+    int fd = socket(AF_INET, SOCK_STREAM, 0);
+    if (fd < 0)
+        return -1;
+
+    if (connect(fd, (const struct sockaddr *)&addr, sizeof(addr)) < 0)
+    {
+        ::close(fd);
+        return -1;
+    }
+    return fd;
+}
 
 int main(int argc, char** argv)
 {
@@ -45,12 +60,6 @@ int main(int argc, char** argv)
         return 1;
     }
 
-    if((socket_fd = socket(AF_INET, SOCK_STREAM, 0)) < 0)
-    {
-        printf("\n Error : Could not create socket \n");
-        return 1;
-    }
-
     std::string host = argv[1];
     host = host.substr(0, host.find_last_of(':'));
     int port = std::atoi(argv[1] + host.size() + 1);
@@ -80,7 +89,7 @@ int main(int argc, char** argv)
         return 1;
     } 
 
-    if(connect(socket_fd, (struct sockaddr *)&addr, sizeof(addr)) < 0)
+    if((socket_fd = connectTo(addr)) < 0)
     {
        std::cerr << "Error: " << strerror(errno) << std::endl;
        return 1;
@@ -97,31 +106,41 @@ int main(int argc, char** argv)
     }
 */
     hermes::SlaveProperty* props[] = { &model, &remain1, &remain2 };
-    hermes::UnixTCPSocketIO io(socket_fd);
-
-
     srand(time(NULL));
 
     *(reinterpret_cast<uint32_t*>(serial)) = rand();
 
-    hermes::EasySlave<3> slave( props, &io, serial, token);
+    std::unique_ptr<hermes::UnixTCPSocketIO> io(new hermes::UnixTCPSocketIO(socket_fd));
+    hermes::EasySlave<3> slave( props, io.get(), serial, token);
 
+    // Busy master drops the connection after RetryLater, the slave keeps
+    // its backoff over reconnects
+    bool shaken = slave.handshake();
+    while (!shaken && slave.retries() > 0)
+    {
+        io->close();
+        if ((socket_fd = connectTo(addr)) < 0)
+            break;
+        io.reset(new hermes::UnixTCPSocketIO(socket_fd));
+        slave.setIO(io.get());
+        shaken = slave.handshake();
+    }
 
-    if(!slave.handshake())
+    if(!shaken)
     {
         std::cerr << "Handshake failed!" << std::endl;
     } else {
         std::cout << "Handshake succeeded" << std::endl;
     }
 
-    while (io.good())
+    while (io->good())
     {
         slave.loop();
     }
 
     if (errno == 0)
-        io.close();
+        io->close();
     else
         std::cerr << "Error: " << strerror(errno) << std::endl;
     return errno;
-}
\ No newline at end of file
+}
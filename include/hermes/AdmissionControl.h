@@ -0,0 +1,123 @@
+/**
+ * Hermes - A RPC for IOT
+ * Copyright (C) 2023  Eduard Sargsyan and Andrey Ovodov
+ * 
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ * 
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ * 
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#ifndef HM_ADMISSION_CONTROL_H
+#define HM_ADMISSION_CONTROL_H
+
+#include <hermes/Types.h>
+
+#ifdef HAS_STD_MUTEX
+#include <mutex>
+#endif // HAS_STD_MUTEX
+
+#include <vector>
+
+namespace hermes
+{
+    /**
+     * Limits of handshakes master takes at once, zero disables a limit
+    */
+    struct AdmissionLimits
+    {
+        /// @brief Slaves being onboarded, from handshake until their new slave
+        /// callback returns or HERMES_ADMISSION_TIMEOUT_MS passes
+        uint16_t maxConcurrent = 0;
+
+        /// @brief Handshakes per second on average
+        uint16_t rate = 0;
+
+        /// @brief Handshakes admitted at once after a quiet period, at least 1
+        uint16_t burst = 1;
+
+        /// @brief Shortest backoff suggested to deferred slaves
+        uint16_t retryAfterMs = HERMES_RETRY_AFTER_MS;
+    };
+
+    struct AdmissionStats
+    {
+        uint32_t admitted = 0;
+
+        /// @brief Handshakes answered with RetryLater
+        uint32_t deferred = 0;
+
+        uint16_t peakConcurrent = 0;
+    };
+
+    /**
+     * Token bucket and concurrency limit for handshakes. Deferred slaves get
+     * a backoff long enough for the slaves deferred before them to be served,
+     * so a reconnect storm is spread over time instead of being retried at
+     * once. Slaves are told apart by serial, so a retrying slave is counted
+     * once, and forgotten if they do not come back in time.
+    */
+    class AdmissionControl
+    {
+    public:
+        explicit AdmissionControl(const AdmissionLimits& limits = AdmissionLimits());
+
+        void setLimits(const AdmissionLimits& limits);
+
+        /**
+         * Take a handshake if limits allow, done() should follow if it did.
+         * @param now Milliseconds from any fixed point
+         * @param serial Slave asking for the handshake
+         * @param retryAfterMs Suggested backoff if handshake is deferred
+         * @return false to answer RetryLater
+        */
+        bool admit(uint32_t now, const serial_t& serial, uint16_t& retryAfterMs);
+
+        /**
+         * Slave admitted by admit() is onboarded.
+        */
+        void done(const serial_t& serial);
+
+        inline const AdmissionStats& stats() const { return m_stats; }
+
+    private:
+        struct Entry
+        {
+            serial_t serial;
+
+            /// @brief Time the entry is forgotten at
+            uint32_t expires;
+        };
+
+        void refill(uint32_t now);
+        uint16_t backoff() const;
+
+    private:
+        AdmissionLimits m_limits;
+        AdmissionStats m_stats;
+
+        /// @brief Admitted slaves which are not done yet
+        std::vector<Entry> m_pending;
+
+        /// @brief Bucket level in thousandths of a handshake
+        uint32_t m_tokens = 0;
+        uint32_t m_lastRefill = 0;
+        bool m_started = false;
+
+        /// @brief Slaves deferred and not admitted since, they will retry
+        std::vector<Entry> m_deferred;
+        #ifdef HAS_STD_MUTEX
+        std::mutex m_mx;
+        #endif // HAS_STD_MUTEX
+    };
+} // namespace hermes
+
+#endif // HM_ADMISSION_CONTROL_H
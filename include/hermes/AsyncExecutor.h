@@ -0,0 +1,192 @@
+/**
+ * Hermes - A RPC for IOT
+ * Copyright (C) 2023  Eduard Sargsyan and Andrey Ovodov
+ * 
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ * 
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ * 
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#ifndef HM_ASYNC_EXECUTOR_H
+#define HM_ASYNC_EXECUTOR_H
+
+#include <hermes/Config.h>
+
+#ifdef HM_HAS_COROUTINES
+
+#include <hermes/IO.h>
+#include <hermes/Task.h>
+
+#ifdef HAS_LINUX_HEADERS
+#include <poll.h>
+#endif // HAS_LINUX_HEADERS
+
+#include <chrono>
+#include <condition_variable>
+#include <deque>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+namespace hermes
+{
+    class AsyncExecutor;
+
+    namespace detail
+    {
+        /**
+         * Coroutine owning a spawned task, destroys itself on completion
+        */
+        struct SpawnedTask
+        {
+            struct promise_type
+            {
+                inline SpawnedTask get_return_object() { return { std::coroutine_handle<promise_type>::from_promise(*this) }; }
+                inline std::suspend_always initial_suspend() const noexcept { return {}; }
+                inline std::suspend_never final_suspend() const noexcept { return {}; }
+                inline void return_void() const noexcept {}
+                inline void unhandled_exception() const noexcept { std::terminate(); }
+            };
+
+            std::coroutine_handle<promise_type> handle;
+        };
+    } // namespace detail
+
+    /**
+     * Runs coroutines on a few threads. Coroutines waiting for data are
+     * parked until their IO has enough bytes available, so no thread is
+     * blocked on a read. Parked IOs are checked when their descriptor
+     * becomes readable, IOs without descriptor are checked every
+     * HERMES_ASYNC_TICK_MS, backing off up to HERMES_ASYNC_MAX_TICK_MS while
+     * nothing is ready.
+     * @note IO has to report incoming data with available() without being
+     *       read, which is true for sockets and serial ports.
+    */
+    class AsyncExecutor
+    {
+    public:
+        /**
+         * Awaitable which resumes when IO has enough bytes to read
+        */
+        struct ReadableAwaiter
+        {
+            inline bool await_ready() const { return !io->good() || io->available() >= length; }
+            inline void await_suspend(std::coroutine_handle<> h) { executor->watch(io, length, h); }
+
+            /**
+             * @return false if IO failed or HERMES_ASYNC_TIMEOUT_MS elapsed
+            */
+            inline bool await_resume() const { return io->good() && io->available() >= length; }
+
+            AsyncExecutor* executor;
+            IO* io;
+            buffer_length_t length;
+        };
+
+        /**
+         * @param threads Count of threads running coroutines
+        */
+        explicit AsyncExecutor(unsigned threads = 1);
+        ~AsyncExecutor();
+
+        AsyncExecutor(const AsyncExecutor&) = delete;
+        const AsyncExecutor& operator = (const AsyncExecutor&) = delete;
+
+        /**
+         * Start the task on the executor, it is owned by the executor
+        */
+        void spawn(Task<void> task);
+
+        /**
+         * Resume the coroutine on one of executor's threads
+        */
+        void schedule(std::coroutine_handle<> h);
+
+        /**
+         * @code
+         * if (co_await executor.readable(io, sizeof(Message)))
+         *     io->read(msg);
+         * @endcode
+        */
+        inline ReadableAwaiter readable(IO* io, buffer_length_t length) { return { this, io, length }; }
+
+        /**
+         * Block until all spawned tasks are done
+        */
+        void wait();
+
+        /**
+         * Stop and join threads. Suspended coroutines are not resumed anymore.
+        */
+        void stop();
+
+    private:
+        struct Waiter
+        {
+            IO* io;
+            buffer_length_t length;
+            std::chrono::steady_clock::time_point deadline;
+            std::coroutine_handle<> handle;
+        };
+
+        void watch(IO* io, buffer_length_t length, std::coroutine_handle<> h);
+        void worker();
+
+        /**
+         * Move waiters with data, failed IO or expired deadline to ready queue
+         * @note Has to be called with m_mx locked
+        */
+        bool pollWaiters();
+
+        /**
+         * Sleep until a descriptor of a waiter is readable, a waiter is added
+         * or the tick elapses. Unlocks m_mx while sleeping.
+        */
+        void sleepWaiters(std::unique_lock<std::mutex>& lock);
+
+        /**
+         * Interrupt poll() of sleepWaiters(), waiting on m_cv ends by tick
+         * @note Has to be called with m_mx locked
+        */
+        void wakePoller();
+
+        static detail::SpawnedTask run(Task<void> task, AsyncExecutor* executor);
+        void finished();
+
+    private:
+        std::deque<std::coroutine_handle<>> m_ready;
+        std::vector<Waiter> m_waiters;
+        std::vector<std::thread> m_threads;
+        std::mutex m_mx;
+        std::condition_variable m_cv;
+        std::condition_variable m_done;
+        size_t m_tasks = 0;
+        bool m_polling = false;
+        bool m_stop = false;
+
+        /// @brief Current wait between checks of waiters, in milliseconds
+        int m_tick = HERMES_ASYNC_TICK_MS;
+
+        /// @brief Last sleep ended by readable data which was not enough
+        bool m_partial = false;
+
+        #ifdef HAS_LINUX_HEADERS
+        /// @brief Pipe written by wakePoller()
+        int m_wake[2] = { -1, -1 };
+        std::vector<pollfd> m_fds;
+        #endif // HAS_LINUX_HEADERS
+    };
+} // namespace hermes
+
+#endif // HM_HAS_COROUTINES
+
+#endif // HM_ASYNC_EXECUTOR_H
@@ -0,0 +1,139 @@
+/**
+ * Hermes - A RPC for IOT
+ * Copyright (C) 2023  Eduard Sargsyan and Andrey Ovodov
+ * 
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ * 
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ * 
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#ifndef HM_ASYNC_SLAVE_DESCRIPTOR_H
+#define HM_ASYNC_SLAVE_DESCRIPTOR_H
+
+#include <hermes/Config.h>
+
+#ifdef HM_HAS_COROUTINES
+
+#include <hermes/AsyncExecutor.h>
+#include <hermes/Message.h>
+#include <hermes/SlaveDescriptor.h>
+
+#include <string>
+
+namespace hermes
+{
+    /**
+     * Coroutine counterpart of SlaveDescriptor. Requests suspend instead of
+     * blocking while waiting for the response, so many slaves can be served
+     * by a few executor threads. Property names, count and types are
+     * requested once, like SlaveDescriptor does.
+     * @code
+     * Task<void> dump(AsyncSlaveDescriptor& slave)
+     * {
+     *     const uint8_t count = co_await slave.propertiesCount();
+     *     for (uint8_t i = 0; i < count; ++i) {
+     *         ValueData vd;
+     *         if (co_await slave.get(i, vd))
+     *             printf("%s = %s\n", vd.name, vd2str(vd));
+     *     }
+     * }
+     * @endcode
+     * @note Requests to one slave have to be awaited one by one. They do not
+     *       take the request lock of the SlaveDescriptor they were created
+     *       from, as a coroutine may resume on another thread. Do not use the
+     *       SlaveDescriptor, including its poll(), while requests are awaited.
+    */
+    class AsyncSlaveDescriptor
+    {
+    public:
+        /**
+         * @param executor Executor to park coroutines on while waiting
+         * @param io Communication channel
+         * @param serial Serial of the slave
+        */
+        AsyncSlaveDescriptor(AsyncExecutor& executor, IO* io, serial_t serial);
+
+        /**
+         * Talk to a slave accepted by Master. Names, count and types known
+         * from its schema are not requested again, gets are served from its
+         * cache, and values read and set are stored in its cache and journal
+         * like SlaveDescriptor does. Updates of subscriptions which come in
+         * while waiting for a response are passed to the slave descriptor,
+         * so its cache and update callback see them.
+        */
+        AsyncSlaveDescriptor(AsyncExecutor& executor, SlaveDescriptor& slave);
+
+        /**
+         * @see SlaveDescriptor::propertiesCount
+        */
+        Task<uint8_t> propertiesCount();
+
+        /**
+         * @see SlaveDescriptor::propertyName
+        */
+        Task<bool> propertyName(uint8_t index, char* name);
+
+        Task<std::string> propertyName(uint8_t index);
+
+        /**
+         * @see SlaveDescriptor::propertyIndex
+        */
+        Task<int8_t> propertyIndex(const char* name);
+
+        /**
+         * @see SlaveDescriptor::set
+        */
+        Task<bool> set(uint8_t property, const ValueData& value);
+
+        /**
+         * @see SlaveDescriptor::get
+        */
+        Task<bool> get(uint8_t property, ValueData& value);
+
+        inline const serial_t& serial() const { return m_serial; }
+
+        /**
+         * Property table learned from responses, the one of the slave
+         * descriptor if created from one.
+        */
+        inline const SlaveSchema& schema() const { return *m_schema; }
+
+    private:
+        Message command(Command cmd) const;
+
+        /**
+         * Hand a complete schema to the registry of the slave descriptor.
+        */
+        void learned();
+
+        /**
+         * Send request and wait for the response. Updates of subscriptions
+         * coming in before the response are handled by the slave descriptor,
+         * or skipped if there is none.
+         * @return Response or an error message
+        */
+        Task<Message> request(Message req);
+
+    private:
+        AsyncExecutor& m_executor;
+        SlaveDescriptor* m_slave = nullptr;
+        SlaveSchema m_ownSchema;
+        SlaveSchema* m_schema;
+        IO* m_io;
+        serial_t m_serial;
+        token_t m_token;
+    };
+} // namespace hermes
+
+#endif // HM_HAS_COROUTINES
+
+#endif // HM_ASYNC_SLAVE_DESCRIPTOR_H
@@ -24,21 +24,67 @@
 
 namespace hermes
 {
-    using GetValueData = ValueData;
-    using SetValueData = ValueData;
     using CountData = uint8_t;
     using IndexData = uint8_t;
-    using StringData = char[32];
 
-    union CommandData {
-        ValueData value;
-        SetValueData set;
-        GetValueData get;
+    /**
+     * Entry of a proxy's routing table
+    */
+    template<class Traits>
+    struct BasicRouteData
+    {
+        byte_t serial[Traits::SerialLength];
+        uint8_t hops;
+    } __attribute__((packed));
+
+    /**
+     * Conditions for a slave to send Update for a property
+    */
+    template<class Traits>
+    struct BasicSubscribeData
+    {
+        char name[Traits::PropertyNameLength];
+
+        /// @brief Change needed to send an update, zero sends any change
+        FloatValue deadband;
+
+        /// @brief Milliseconds to wait at least between updates
+        uint16_t minInterval;
+
+        /// @brief Milliseconds after which value is sent even if unchanged, 0 disables
+        uint16_t maxInterval;
+    } __attribute__((packed));
+
+    /**
+     * Acknowledgement of a GroupSet, summed up by proxies on the way back
+    */
+    struct GroupAckData
+    {
+        /// @brief Members which applied the value
+        uint16_t applied;
+
+        /// @brief Members which failed to apply the value
+        uint16_t failed;
+    } __attribute__((packed));
+
+    template<class Traits>
+    union BasicCommandData {
+        BasicValueData<Traits> value;
+        BasicValueData<Traits> set;
+        BasicValueData<Traits> get;
         CountData count;
         IndexData index;
-        StringData string;
+        char string[Traits::PropertyNameLength];
+        BasicRouteData<Traits> route;
+        GroupAckData ack;
+        BasicSubscribeData<Traits> subscribe;
     };
 
+    using GetValueData = ValueData;
+    using SetValueData = ValueData;
+    using SubscribeData = BasicSubscribeData<DefaultMessageTraits>;
+    using CommandData = BasicCommandData<DefaultMessageTraits>;
+
 } // namespace hermes
 
 #endif // HM_COMMAND_DATA_H
\ No newline at end of file
@@ -30,16 +30,25 @@ namespace hermes
         Get = 3,
         GetPropertiesCount = 4,
         GetPropertyName = 5,
-        PollEvents = 6
+        PollEvents = 6,
+        GetRoutesCount = 7,
+        GetRoute = 8,
+        GroupSet = 9,
+        Subscribe = 10,
+        Unsubscribe = 11,
+        Update = 12
     };
 
     const char* cmd2str(const Command& cmd);
 
-    struct CommandPayload
+    template<class Traits>
+    struct BasicCommandPayload
     {
         Command command; // 1
-        CommandData data;
+        BasicCommandData<Traits> data;
     } __attribute__((packed));
+
+    using CommandPayload = BasicCommandPayload<DefaultMessageTraits>;
 } // namespace hermes
 
 #endif // AB_PROTO_COMMAND_PAYLOAD_H
\ No newline at end of file
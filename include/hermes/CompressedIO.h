@@ -0,0 +1,141 @@
+/**
+ * Hermes - A RPC for IOT
+ * Copyright (C) 2023  Eduard Sargsyan and Andrey Ovodov
+ * 
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ * 
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ * 
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#ifndef HM_COMPRESSED_IO_H
+#define HM_COMPRESSED_IO_H
+
+#include <hermes/IO.h>
+#include <hermes/Message.h>
+#include <hermes/Compression.h>
+
+namespace hermes
+{
+    /**
+     * Header put in front of every message by CompressedIO once a codec is
+     * negotiated. Length is little endian.
+    */
+    struct CompressedHeader
+    {
+        /// @brief Codec the body is encoded with, None for a raw message
+        Codec codec;
+
+        /// @brief Body length
+        byte_t length[2];
+    } __attribute__((packed));
+
+    /**
+     * Counters of a CompressedIO
+    */
+    struct CompressionStats
+    {
+        uint32_t messagesSent = 0;
+
+        /// @brief Sent messages which were compressed
+        uint32_t compressed = 0;
+
+        /// @brief Bytes of sent messages and bytes really written for them
+        uint32_t bytesIn = 0;
+        uint32_t bytesOut = 0;
+
+        uint32_t messagesReceived = 0;
+
+        /// @brief Received messages which failed to decode
+        uint32_t errors = 0;
+    };
+
+    /**
+     * Channel which compresses messages with payloads of at least threshold
+     * bytes. It is transparent until CapCompression is negotiated at handshake
+     * (see DummySlave::handshake(), Master::accept()), so it can talk to
+     * peers without compression. After that every message is sent with a
+     * CompressedHeader, compressed if it gets shorter and raw otherwise.
+     * Put it over a FramedIO on noisy links, a corrupted body can not be
+     * resynchronized by CompressedIO itself.
+     * @note Carries whole messages once a codec is set, like SizedFrameIO.
+    */
+    class CompressedIO: public IO
+    {
+    public:
+        static constexpr buffer_length_t MaxBodyLength = lzBound(sizeof(Message));
+
+        /**
+         * @param io Underlying channel
+         * @param codec Codec to offer at handshake
+         * @param threshold Smallest payloadLength to compress
+        */
+        explicit CompressedIO(IO* io, Codec codec = Codec::Lz,
+                              uint16_t threshold = HERMES_COMPRESSION_THRESHOLD);
+
+        virtual void offer(HandshakePayload& handshake) const override;
+        virtual bool negotiate(const HandshakePayload& handshake) override;
+
+        /**
+         * @return Codec in use, None until negotiated
+        */
+        inline Codec codec() const { return m_codec; }
+
+        inline const CompressionStats& stats() const { return m_stats; }
+
+        virtual bool good() const override { return m_io->good(); }
+        virtual void flush() override;
+        virtual buffer_length_t available() const override;
+        virtual buffer_length_t wait(buffer_length_t length) override;
+        virtual buffer_length_t write(const byte_t* buf, buffer_length_t length) override;
+        virtual buffer_length_t read(byte_t* buf, buffer_length_t length) override;
+        virtual bool drain() override { return m_io->drain(); }
+        virtual int descriptor() const override { return m_io->descriptor(); }
+        virtual bool close() override { return m_io->close(); }
+
+    private:
+        /**
+         * Read and decode next message into m_in.
+        */
+        bool receive();
+
+        /**
+         * Encode and send m_out.
+        */
+        bool send();
+
+        inline size_t pending() const { return sizeof(Message) - m_inPos; }
+
+        static inline size_t bodyLength(const CompressedHeader& header)
+        { return header.length[0] | (header.length[1] << 8); }
+
+    private:
+        IO* m_io;
+        Codec m_supported;
+        Codec m_codec = Codec::None;
+        uint16_t m_threshold;
+        CompressionStats m_stats;
+
+        Message m_in;
+        size_t m_inPos = sizeof(Message);
+
+        /// @brief Header of the next message, read ahead by available()
+        mutable CompressedHeader m_header;
+        mutable bool m_hasHeader = false;
+
+        Message m_out;
+        size_t m_outPos = 0;
+
+        byte_t m_buffer[sizeof(CompressedHeader) + MaxBodyLength];
+    };
+} // namespace hermes
+
+#endif // HM_COMPRESSED_IO_H
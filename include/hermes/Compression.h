@@ -0,0 +1,62 @@
+/**
+ * Hermes - A RPC for IOT
+ * Copyright (C) 2023  Eduard Sargsyan and Andrey Ovodov
+ * 
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ * 
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ * 
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#ifndef HM_COMPRESSION_H
+#define HM_COMPRESSION_H
+
+#include <hermes/Types.h>
+#include <stddef.h>
+
+namespace hermes
+{
+    /**
+     * Small LZ77 block coder in the spirit of LZ4, meant for single frames.
+     * Sequences are a token (literal count, match length), literals and a 16
+     * bit offset of the match. It needs no heap, 512 bytes of stack to
+     * compress and none to decompress, so it is suitable for microcontrollers.
+     * Zero padding of fixed length strings and repeated names compress well.
+    */
+
+    /**
+     * @param length Input length
+     * @return Largest possible compressed length of length bytes
+    */
+    constexpr size_t lzBound(size_t length) { return length + length / 255 + 16; }
+
+    /**
+     * Compress a block.
+     * @param src Data to compress, at most 65535 bytes
+     * @param length Data length
+     * @param dst Output buffer
+     * @param capacity Output buffer size
+     * @return Compressed length, 0 if it does not fit into capacity
+    */
+    size_t lzCompress(const byte_t* src, size_t length, byte_t* dst, size_t capacity);
+
+    /**
+     * Decompress a block produced by lzCompress().
+     * @param src Compressed data
+     * @param length Compressed data length
+     * @param dst Output buffer
+     * @param capacity Output buffer size
+     * @return Decompressed length, 0 if data is corrupted or does not fit
+    */
+    size_t lzDecompress(const byte_t* src, size_t length, byte_t* dst, size_t capacity);
+} // namespace hermes
+
+#endif // HM_COMPRESSION_H
@@ -67,6 +67,20 @@
 								## __VA_ARGS__); \
 							} while(0)
 
+/**
+ * Coroutine based async API (AsyncSlaveDescriptor) needs C++20 coroutines and
+ * threads for its executor.
+ */
+#if defined(__cpp_impl_coroutine) && defined(HAS_STD_THREAD_H)
+#define HM_HAS_COROUTINES 1
+#endif
+
+/**
+ * Field sizes below define DefaultMessageTraits, i.e. the Message used by all
+ * endpoints. Use MessageTraits and SizedFrameIO to send differently sized
+ * frames over a particular channel.
+ */
+
 #ifndef HERMES_SERIAL_LENGTH
 #define HERMES_SERIAL_LENGTH 8
 #endif // HERMES_SERIAL_LENGTH
@@ -83,6 +97,98 @@
 #define HERMES_PROPERTY_NAME_MAX_LENGTH HERMES_STRING_LENGTH
 #endif // HERMES_PROPERTY_NAME_MAX_LENGTH
 
+#ifndef HERMES_MAX_ROUTES
+#define HERMES_MAX_ROUTES 16
+#endif // HERMES_MAX_ROUTES
+
+#ifndef HERMES_MAX_GROUPS
+#define HERMES_MAX_GROUPS 8
+#endif // HERMES_MAX_GROUPS
+
+#ifndef HERMES_MAX_SUBSCRIPTIONS
+#define HERMES_MAX_SUBSCRIPTIONS 4
+#endif // HERMES_MAX_SUBSCRIPTIONS
+
+#ifndef HERMES_SUBSCRIPTION_TICK_MS
+#define HERMES_SUBSCRIPTION_TICK_MS 10
+#endif // HERMES_SUBSCRIPTION_TICK_MS
+
+#ifndef HERMES_ASYNC_TICK_MS
+#define HERMES_ASYNC_TICK_MS 1
+#endif // HERMES_ASYNC_TICK_MS
+
+#ifndef HERMES_ASYNC_MAX_TICK_MS
+#define HERMES_ASYNC_MAX_TICK_MS 32
+#endif // HERMES_ASYNC_MAX_TICK_MS
+
+#ifndef HERMES_ASYNC_TIMEOUT_MS
+#define HERMES_ASYNC_TIMEOUT_MS 30000
+#endif // HERMES_ASYNC_TIMEOUT_MS
+
+#ifndef HERMES_EXECUTOR_CAPACITY
+#define HERMES_EXECUTOR_CAPACITY 1024
+#endif // HERMES_EXECUTOR_CAPACITY
+
+#ifndef HERMES_SEND_QUEUE_SIZE
+#define HERMES_SEND_QUEUE_SIZE 16
+#endif // HERMES_SEND_QUEUE_SIZE
+
+#ifndef HERMES_SEND_TIMEOUT_MS
+#define HERMES_SEND_TIMEOUT_MS 1000
+#endif // HERMES_SEND_TIMEOUT_MS
+
+#ifndef HERMES_LANE_MAX_BYPASS
+#define HERMES_LANE_MAX_BYPASS 8
+#endif // HERMES_LANE_MAX_BYPASS
+
+#ifndef HERMES_RETRY_AFTER_MS
+#define HERMES_RETRY_AFTER_MS 500
+#endif // HERMES_RETRY_AFTER_MS
+
+#ifndef HERMES_ADMISSION_TIMEOUT_MS
+#define HERMES_ADMISSION_TIMEOUT_MS 10000
+#endif // HERMES_ADMISSION_TIMEOUT_MS
+
+#ifndef HERMES_HANDSHAKE_BACKOFF_MS
+#define HERMES_HANDSHAKE_BACKOFF_MS 250
+#endif // HERMES_HANDSHAKE_BACKOFF_MS
+
+#ifndef HERMES_HANDSHAKE_BACKOFF_MAX_MS
+#define HERMES_HANDSHAKE_BACKOFF_MAX_MS 30000
+#endif // HERMES_HANDSHAKE_BACKOFF_MAX_MS
+
+#ifndef HERMES_MESSAGE_POOL_SIZE
+#define HERMES_MESSAGE_POOL_SIZE 4
+#endif // HERMES_MESSAGE_POOL_SIZE
+
+#ifndef HERMES_TELEMETRY_BATCH_SIZE
+#define HERMES_TELEMETRY_BATCH_SIZE 4096
+#endif // HERMES_TELEMETRY_BATCH_SIZE
+
+#ifndef HERMES_COMPRESSION_THRESHOLD
+#define HERMES_COMPRESSION_THRESHOLD 32
+#endif // HERMES_COMPRESSION_THRESHOLD
+
+#ifndef HERMES_JOURNAL_COMPACT_RECORDS
+#define HERMES_JOURNAL_COMPACT_RECORDS 65536
+#endif // HERMES_JOURNAL_COMPACT_RECORDS
+
+#ifndef HERMES_JOURNAL_GROW_BYTES
+#define HERMES_JOURNAL_GROW_BYTES (1 << 20)
+#endif // HERMES_JOURNAL_GROW_BYTES
+
+#ifndef HERMES_TCP_BUFFER_LENGTH
+#define HERMES_TCP_BUFFER_LENGTH 1024
+#endif // HERMES_TCP_BUFFER_LENGTH
+
+#ifndef HERMES_FRAME_MAX_LENGTH
+#define HERMES_FRAME_MAX_LENGTH 256
+#endif // HERMES_FRAME_MAX_LENGTH
+
+#ifndef HERMES_TCP_SOCK_WRITE_TIMEOUT_SEC
+#define HERMES_TCP_SOCK_WRITE_TIMEOUT_SEC 10
+#endif // HERMES_TCP_SOCK_WRITE_TIMEOUT_SEC
+
 #ifndef HERMES_TCP_SOCK_READ_TIMEOUT_SEC
 #define HERMES_TCP_SOCK_READ_TIMEOUT_SEC 300
 #endif // HERMES_TCP_SOCK_READ_TIMEOUT_SEC
@@ -0,0 +1,45 @@
+/**
+ * Hermes - A RPC for IOT
+ * Copyright (C) 2023  Eduard Sargsyan and Andrey Ovodov
+ * 
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ * 
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ * 
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#ifndef HM_CRC32C_H
+#define HM_CRC32C_H
+
+#include <hermes/Types.h>
+#include <stddef.h>
+
+namespace hermes
+{
+    /**
+     * CRC32C (Castagnoli). Uses the SSE4.2 crc32 instruction on x86-64 when
+     * the CPU supports it, the ARMv8 CRC extension when it is enabled at
+     * compile time, and slicing-by-8 tables otherwise.
+     * @param data Data to checksum
+     * @param length Data length
+     * @param crc Result of the previous call to checksum data in chunks
+     * @return Checksum, crc32c("123456789", 9) == 0xE3069283
+    */
+    uint32_t crc32c(const byte_t* data, size_t length, uint32_t crc = 0);
+
+    /**
+     * Table driven CRC32C, same result as crc32c().
+     * @see crc32c()
+    */
+    uint32_t crc32cPortable(const byte_t* data, size_t length, uint32_t crc = 0);
+} // namespace hermes
+
+#endif // HM_CRC32C_H
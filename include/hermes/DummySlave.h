@@ -22,11 +22,35 @@
 
 #include <hermes/Slave.h>
 #include <hermes/Message.h>
+#include <hermes/Group.h>
 
 namespace hermes
 {
     class IO;
+    class Router;
 
+    /**
+     * Property subscription of master, see Command::Subscribe
+    */
+    struct Subscription
+    {
+        uint8_t property;
+        float deadband;
+        uint16_t minInterval;
+        uint16_t maxInterval;
+
+        /// @brief Time of the last update in milliseconds
+        uint32_t lastSent;
+
+        /// @brief Value sent with the last update
+        ValueData last;
+    };
+
+    /**
+     * Slave side of the protocol over an IO. Responses and updates are
+     * written to the IO in the order they are made, give it a QueuedIO to
+     * send responses ahead of queued updates; loop() drains it.
+    */
     class DummySlave: public Slave
     {
     public:
@@ -39,26 +63,137 @@ namespace hermes
         DummySlave(IO* io, const byte_t* serial, const byte_t* token);
 
         /**
-         * Perform handshake with master
+         * Perform handshake with master. Features of the channel (IO::offer())
+         * which master supports too are enabled on it.
+         *
+         * If master answers RetryLater, which it follows by dropping the
+         * connection, waits for the longer of suggested and exponential
+         * backoff, with random jitter, and returns false. Reconnect, hand
+         * the new channel to setIO() and call it again, backoff keeps
+         * growing until a handshake succeeds.
          * @return Returns true if handshake succeeded.
          * @note This is an blocking method
+         * @see retries()
         */
         bool handshake();
         void loop();
 
+        /**
+         * Talk to master over a new channel, e.g. after reconnecting. Backoff
+         * of handshake() is kept, subscriptions are dropped, master makes
+         * them again for the new connection.
+        */
+        void setIO(IO* io);
+
+        /**
+         * @return Handshakes master told to retry later in a row, 0 after
+         *         one succeeded or was rejected
+        */
+        inline uint8_t retries() const { return m_retries; }
+
+        /**
+         * Hash of the property table sent at handshake, so master which
+         * knows the table does not ask for it again. Computed from
+         * propertiesCount(), propertyName() and propertyType() on every
+         * handshake.
+         * @see SchemaHasher
+        */
+        uint32_t schemaHash();
+
         /**
          * Process next incoming message from master.
         */
         bool processNextMessage();
 
+        /**
+         * Make this slave a proxy for downstream slaves. Frames addressed to
+         * serials in the router are forwarded, the routing table is advertised
+         * to master with GetRoutesCount/GetRoute commands.
+         * @param router Routing table, nullptr to disable routing
+        */
+        inline void setRouter(Router* router) { m_router = router; }
+
+        /**
+         * Apply Set frames addressed to the group.
+         * @return false if the slave is a member of too many groups
+        */
+        bool joinGroup(group_t group);
+
+        void leaveGroup(group_t group);
+
+        /**
+         * @return true if slave is a member of the group, every slave is a
+         *         member of BroadcastGroup
+        */
+        bool inGroup(group_t group) const;
+
+        /**
+         * Send Update for every subscription whose value changed by more than
+         * the deadband, or whose max interval elapsed. Updates are not sent
+         * more often than min interval of the subscription.
+         * @return Count of updates sent
+         * @note Called by loop(), call it periodically if loop() is not used.
+        */
+        uint8_t publish();
+
+        inline uint8_t subscriptionsCount() const { return m_subscriptionsCount; }
+
     protected:
         bool dispatch(Message* message, Message* response);
         bool handleCommandRequest(Message* msg, Message* response);
 
+        /**
+         * Pass a group frame downstream and apply it if this slave is a member.
+         * Every receiver of a GroupSet answers with exactly one acknowledgement
+         * with counts for itself and all slaves behind it, even if it is not a
+         * member, so proxies know how many answers to wait for.
+        */
+        bool handleGroupRequest(const Message& msg);
+
+        /**
+         * Read property with its name and type.
+        */
+        bool readProperty(uint8_t index, ValueData& value);
+
+        /**
+         * @return Milliseconds from any fixed point, used for subscriptions
+        */
+        virtual uint32_t millis();
+
+        /**
+         * Called by loop() when there are subscriptions and no frame to read.
+         * By default sleeps until a frame arrives or the time is up.
+         * @param ms Milliseconds until subscriptions are checked again
+        */
+        virtual void idle(uint32_t ms);
+
+        /**
+         * Sleep, used for handshake backoff.
+        */
+        virtual void delay(uint32_t ms);
+
+    private:
+        /**
+         * @return Jittered backoff before the next handshake attempt
+        */
+        uint32_t backoff(uint16_t suggested);
+
     protected:
         IO* m_io;
         const serial_t m_serial;
         token_t m_token;
+        Router* m_router = nullptr;
+        group_t m_groups[HERMES_MAX_GROUPS];
+        uint8_t m_groupsCount = 0;
+        Subscription m_subscriptions[HERMES_MAX_SUBSCRIPTIONS];
+        uint8_t m_subscriptionsCount = 0;
+
+        /// @brief Time when subscriptions are checked next
+        uint32_t m_nextPublish = 0;
+
+        /// @brief Handshakes deferred in a row
+        uint8_t m_retries = 0;
+        uint32_t m_seed;
     };
 
 } // namespace hermes
@@ -27,7 +27,11 @@ namespace hermes
 {
     struct SlaveProperty: public ValueData
     {
-        SlaveProperty(const char* name) { strncpy(this->name, name, strlen(name)); }
+        SlaveProperty(const char* name)
+        {
+            strncpy(this->name, name, HERMES_PROPERTY_NAME_MAX_LENGTH - 1);
+            this->name[HERMES_PROPERTY_NAME_MAX_LENGTH - 1] = '\0';
+        }
         virtual bool set(const ValueData& in) = 0;
         virtual bool get(ValueData& out) const = 0;
     };
@@ -39,16 +43,16 @@ namespace hermes
     };
 
     template<>
-    const ValueType BasicType<bool>::type = ValueType::Boolean;
+    inline const ValueType BasicType<bool>::type = ValueType::Boolean;
 
     template<>
-    const ValueType BasicType<int32_t>::type = ValueType::Integer;
+    inline const ValueType BasicType<int32_t>::type = ValueType::Integer;
 
     template<>
-    const ValueType BasicType<char*>::type = ValueType::String;
+    inline const ValueType BasicType<char*>::type = ValueType::String;
 
     template<>
-    const ValueType BasicType<float>::type = ValueType::Float;
+    inline const ValueType BasicType<float>::type = ValueType::Float;
 
     template<typename CachedT>
     struct CachedSlaveProperty : public SlaveProperty
@@ -87,7 +91,7 @@ namespace hermes
     };
 
     template<>
-    bool CachedSlaveProperty<bool>::set(const ValueData& in)
+    inline bool CachedSlaveProperty<bool>::set(const ValueData& in)
     {
         if (in.type != type)
             return false;
@@ -97,14 +101,14 @@ namespace hermes
     }
 
     template<>
-    bool CachedSlaveProperty<bool>::get(ValueData& out) const
+    inline bool CachedSlaveProperty<bool>::get(ValueData& out) const
     {
         out.value.B = value ? 1 : 0;
         return true;
     }
 
     template<>
-    bool CachedSlaveProperty<int32_t>::set(const ValueData& in)
+    inline bool CachedSlaveProperty<int32_t>::set(const ValueData& in)
     {
         if (in.type != type)
             return false;
@@ -114,56 +118,56 @@ namespace hermes
     }
 
     template<>
-    bool CachedSlaveProperty<int32_t>::get(ValueData& out) const
+    inline bool CachedSlaveProperty<int32_t>::get(ValueData& out) const
     {
         out.value.I = value;
         return true;
     }
 
+    /**
+     * String properties keep their value in ValueData::value.S of the
+     * property itself, so they never allocate.
+    */
     template<>
-    CachedSlaveProperty<char*>::CachedSlaveProperty(const char* name, char* val)
+    inline CachedSlaveProperty<char*>::CachedSlaveProperty(const char* name, char* val)
         : SlaveProperty(name)
     {
         type = ValueType::String;
-        value = new char[HERMES_STRING_LENGTH]; 
-        strcpy(value, val);
+        value = ValueData::value.S;
+        strncpy(value, val ? val : "", HERMES_STRING_LENGTH - 1);
+        value[HERMES_STRING_LENGTH - 1] = '\0';
     }
 
     template<>
-    const CachedSlaveProperty<char*>& CachedSlaveProperty<char*>::operator=(const CachedSlaveProperty<char*>& src)
+    inline const CachedSlaveProperty<char*>& CachedSlaveProperty<char*>::operator=(const CachedSlaveProperty<char*>& src)
     {
         type = ValueType::String;
         strcpy(name, src.name);
-        value = new char[HERMES_STRING_LENGTH];
+        value = ValueData::value.S;
         strcpy(value, src.value);
         return *this;
     }
 
     template<>
-    CachedSlaveProperty<char*>::~CachedSlaveProperty()
-    {
-        delete []value;
-    }
-
-    template<>
-    bool CachedSlaveProperty<char*>::set(const ValueData& in)
+    inline bool CachedSlaveProperty<char*>::set(const ValueData& in)
     {
         if (in.type != type)
             return false;
 
-        strcpy(value, in.value.S);
+        strncpy(value, in.value.S, HERMES_STRING_LENGTH - 1);
+        value[HERMES_STRING_LENGTH - 1] = '\0';
         return 0;
     }
 
     template<>
-    bool CachedSlaveProperty<char*>::get(ValueData& out) const
+    inline bool CachedSlaveProperty<char*>::get(ValueData& out) const
     {
         strcpy(out.value.S, value);
         return true;
     }
 
     template<>
-    bool CachedSlaveProperty<float>::get(ValueData& out) const
+    inline bool CachedSlaveProperty<float>::get(ValueData& out) const
     {
         out.value.F.V = value * 1000;
         out.value.F.Precision = 1000;
@@ -171,7 +175,7 @@ namespace hermes
     }
 
     template<>
-    bool CachedSlaveProperty<float>::set(const ValueData& in)
+    inline bool CachedSlaveProperty<float>::set(const ValueData& in)
     {
         if (in.type != type)
             return false;
@@ -21,6 +21,7 @@
 #define HM_ERROR_PAYLOAD_H
 
 #include <hermes/Types.h>
+#include <hermes/MessageTraits.h>
 
 namespace hermes
 {
@@ -33,11 +34,14 @@ namespace hermes
         Fail = 4
     };
 
-    struct ErrorPayload
+    template<class Traits>
+    struct BasicErrorPayload
     {
         ErrorType e;
-        char msg[100];
+        char msg[Traits::ErrorMessageLength];
     } __attribute__((packed));
+
+    using ErrorPayload = BasicErrorPayload<DefaultMessageTraits>;
 } // namespace hermes
 
 #endif // HM_ERROR_PAYLOAD_H
\ No newline at end of file
@@ -0,0 +1,58 @@
+/**
+ * Hermes - A RPC for IOT
+ * Copyright (C) 2023  Eduard Sargsyan and Andrey Ovodov
+ * 
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ * 
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ * 
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#ifndef HM_EXECUTOR_H
+#define HM_EXECUTOR_H
+
+#include <hermes/Config.h>
+
+#include <functional>
+
+namespace hermes
+{
+    /**
+     * Runs callbacks of Master and SlaveDescriptor away from the thread
+     * which read the message, see WorkStealingPool.
+    */
+    class Executor
+    {
+    public:
+        using job_t = std::function<void()>;
+
+        virtual ~Executor() = default;
+
+        /**
+         * Run job asynchronously. Jobs posted with the same key run one at a
+         * time in the order they were posted.
+         * @param key Ordering key, e.g. slave descriptor, nullptr if job can
+         *        run in any order
+         * @param job Job to run
+         * @return false if job was rejected
+        */
+        virtual bool post(const void* key, job_t job) = 0;
+
+        /**
+         * Block until jobs posted with key are done, e.g. before the object
+         * they use is destroyed.
+         * @param key Ordering key jobs were posted with
+        */
+        virtual void drain(const void* key) = 0;
+    };
+} // namespace hermes
+
+#endif // HM_EXECUTOR_H
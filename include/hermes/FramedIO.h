@@ -0,0 +1,144 @@
+/**
+ * Hermes - A RPC for IOT
+ * Copyright (C) 2023  Eduard Sargsyan and Andrey Ovodov
+ * 
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ * 
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ * 
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#ifndef HM_FRAMED_IO_H
+#define HM_FRAMED_IO_H
+
+#include <hermes/IO.h>
+#include <hermes/Message.h>
+
+namespace hermes
+{
+    /**
+     * Header put in front of every frame by FramedIO. Multibyte fields are
+     * little endian.
+    */
+    struct FrameHeader
+    {
+        /// @brief Start of frame marker, FramedIO::FrameStart
+        byte_t sof[2];
+
+        /// @brief CRC32C of length and body
+        byte_t crc[4];
+
+        /// @brief Body length
+        byte_t length[2];
+    } __attribute__((packed));
+
+    /**
+     * Counters of a FramedIO.
+    */
+    struct FrameStats
+    {
+        uint32_t framesSent = 0;
+        uint32_t framesReceived = 0;
+
+        /// @brief Frames with bad length or checksum
+        uint32_t framesDropped = 0;
+
+        /// @brief Times a valid frame was found after the stream lost sync
+        uint32_t resyncs = 0;
+
+        /// @brief Bytes thrown away while looking for a start of frame
+        uint32_t bytesSkipped = 0;
+    };
+
+    /**
+     * Channel which sends every write() as a frame with a start marker,
+     * length and CRC32C. The receiver scans for the start marker, so after a
+     * corrupted, dropped or inserted byte it resynchronizes on the next valid
+     * frame instead of parsing garbage until the connection is torn down.
+     * Partially received frames are kept between reads.
+     * @note Both ends of a link have to use FramedIO, or agree on CapFraming
+     *       at handshake if it is created as negotiated.
+    */
+    class FramedIO: public IO
+    {
+    public:
+        static constexpr byte_t FrameStart[2] = { 0xA5, 0x5A };
+        static constexpr buffer_length_t MaxBodyLength = HERMES_FRAME_MAX_LENGTH;
+        static constexpr buffer_length_t MaxFrameLength = sizeof(FrameHeader) + MaxBodyLength;
+
+        static_assert(MaxBodyLength >= sizeof(Message), "HERMES_FRAME_MAX_LENGTH is too small for a message");
+
+        /**
+         * @param io Underlying channel
+         * @param negotiated Pass data through as is until framing is agreed
+         *        at handshake, so the peer may not use FramedIO at all
+        */
+        explicit FramedIO(IO* io, bool negotiated = false);
+
+        virtual void offer(HandshakePayload& handshake) const override;
+        virtual bool negotiate(const HandshakePayload& handshake) override;
+
+        /**
+         * @return true if data is sent in frames
+        */
+        inline bool enabled() const { return m_enabled; }
+
+        virtual bool good() const override { return m_io->good(); }
+        virtual void flush() override;
+        virtual buffer_length_t available() const override;
+        virtual buffer_length_t wait(buffer_length_t length) override;
+        virtual buffer_length_t write(const byte_t* buf, buffer_length_t length) override;
+        virtual buffer_length_t read(byte_t* buf, buffer_length_t length) override;
+        virtual bool close() override { return m_io->close(); }
+        virtual int descriptor() const override { return m_io->descriptor(); }
+
+        inline const FrameStats& stats() const { return m_stats; }
+
+    private:
+        /**
+         * Scan received bytes until a frame passes the checks.
+         * @return false if underlying channel failed before a frame was found
+        */
+        bool receive();
+
+        /**
+         * Read from underlying channel until at least length bytes are buffered.
+        */
+        bool fill(buffer_length_t length);
+
+        void discard(buffer_length_t length);
+
+        inline buffer_length_t pending() const { return m_bodyLen - m_bodyPos; }
+
+    private:
+        IO* m_io;
+        FrameStats m_stats;
+        bool m_synced = true;
+        bool m_negotiated;
+        bool m_enabled;
+
+        /// @brief Largest body to send, the peer may accept less than we do
+        buffer_length_t m_maxBody = MaxBodyLength;
+
+        /// @brief Received bytes not scanned yet
+        byte_t m_rx[2 * MaxFrameLength];
+        buffer_length_t m_rxLen = 0;
+
+        /// @brief Body of the last valid frame, bytes from m_bodyPos are not consumed yet
+        byte_t m_body[MaxBodyLength];
+        buffer_length_t m_bodyLen = 0;
+        buffer_length_t m_bodyPos = 0;
+
+        byte_t m_tx[MaxFrameLength];
+    };
+} // namespace hermes
+
+#endif // HM_FRAMED_IO_H
@@ -0,0 +1,72 @@
+/**
+ * Hermes - A RPC for IOT
+ * Copyright (C) 2023  Eduard Sargsyan and Andrey Ovodov
+ * 
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ * 
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ * 
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#ifndef HM_GROUP_H
+#define HM_GROUP_H
+
+#include <hermes/Types.h>
+
+namespace hermes
+{
+    using group_t = uint16_t;
+
+    /**
+     * Group every slave is a member of
+    */
+    constexpr group_t BroadcastGroup = 0xFFFF;
+
+    /**
+     * Frames addressed to a group carry a serial made of marker bytes
+     * followed by the group id (big endian). Serials of real slaves must not
+     * start with the marker.
+    */
+    constexpr byte_t GroupSerialMarker = 0xFF;
+
+    /**
+     * @return Serial addressing all members of the group
+    */
+    inline serial_t groupSerial(group_t group)
+    {
+        serial_t serial(GroupSerialMarker);
+        serial.data[HERMES_SERIAL_LENGTH - 2] = static_cast<byte_t>(group >> 8);
+        serial.data[HERMES_SERIAL_LENGTH - 1] = static_cast<byte_t>(group & 0xFF);
+        return serial;
+    }
+
+    /**
+     * @return true if serial addresses a group rather than a slave
+    */
+    inline bool isGroupSerial(const byte_t* serial)
+    {
+        for (int i = 0; i < HERMES_SERIAL_LENGTH - 2; ++i) {
+            if (serial[i] != GroupSerialMarker)
+                return false;
+        }
+        return true;
+    }
+
+    /**
+     * @note Here is no check if serial addresses a group, see isGroupSerial
+    */
+    inline group_t serialGroup(const byte_t* serial)
+    {
+        return static_cast<group_t>((serial[HERMES_SERIAL_LENGTH - 2] << 8) | serial[HERMES_SERIAL_LENGTH - 1]);
+    }
+} // namespace hermes
+
+#endif // HM_GROUP_H
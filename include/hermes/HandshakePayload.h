@@ -30,6 +30,44 @@ namespace hermes
         Fail = 255
     };
 
+    /**
+     * Payload compression, negotiated at handshake
+     * @see CompressedIO
+    */
+    enum class Codec : byte_t
+    {
+        None = 0,
+
+        /// @brief LZ77 block coder, see lzCompress()
+        Lz = 1
+    };
+
+    /**
+     * Protocol features negotiated per link at handshake. A slave offers
+     * features its channel supports and master answers with the ones both
+     * ends support.
+    */
+    enum Capability : uint16_t
+    {
+        /// @brief Start of frame marker and length, see FramedIO
+        CapFraming = 1 << 0,
+
+        /// @brief CRC32C of every frame, see FramedIO
+        CapCrc = 1 << 1,
+
+        /// @brief Payload compression with HandshakePayload::codec, see CompressedIO
+        CapCompression = 1 << 2,
+
+        /// @brief Reserved for frames smaller than Message
+        CapCompactFrames = 1 << 3,
+
+        /// @brief Reserved for several requests in flight per slave
+        CapPipelining = 1 << 4,
+
+        /// @brief Reserved for several messages per frame
+        CapBatching = 1 << 5
+    };
+
     struct ApiVersion
     {
         uint8_t Release;
@@ -37,14 +75,66 @@ namespace hermes
         uint8_t Minor;
     } __attribute__((packed));
 
+    /**
+     * @return Negative, zero or positive if a is older, same or newer than b
+    */
+    constexpr int compare(const ApiVersion& a, const ApiVersion& b)
+    {
+        return a.Release != b.Release ? a.Release - b.Release
+             : a.Major != b.Major ? a.Major - b.Major
+             : a.Minor - b.Minor;
+    }
+
+    /// @brief Version spoken by this library
+    constexpr ApiVersion CurrentApiVersion = { 1, 2, 0 };
+
+    /// @brief Oldest version this library talks to
+    constexpr ApiVersion MinimumApiVersion = { 1, 0, 0 };
+
+    /// @brief First version with capabilities in the handshake
+    constexpr ApiVersion CapabilitiesApiVersion = { 1, 1, 0 };
+
+    /// @brief First version with schema hash in the handshake
+    constexpr ApiVersion SchemaApiVersion = { 1, 2, 0 };
+
+    /**
+     * Slave offers the range of versions it speaks. Master answers with all
+     * three versions set to the agreed one and result, older masters echo
+     * the offer back.
+    */
     struct HandshakePayload
     {
         ApiVersion desiredVersion;
         ApiVersion minimumVersion;
         ApiVersion maximumVersion;
         HandshakeResult result;
+
+        /// @brief Codec offered by slave, accepted one or None in response
+        Codec codec;
+
+        /// @brief Capability bits offered by slave, agreed ones in response
+        uint16_t capabilities;
+
+        /// @brief Largest frame body the sender receives, agreed one in response
+        uint16_t maxFrameLength;
+
+        /// @brief Suggested backoff in milliseconds with RetryLater result
+        uint16_t retryAfterMs;
+
+        /// @brief Hash of slave's properties, 0 if unknown, see schemaHash()
+        uint32_t schemaHash;
     } __attribute__((packed));
 
+    /**
+     * @return true if master settled the handshake on one version which has
+     *         capabilities, false for an offer echoed back by older masters
+    */
+    inline bool settled(const HandshakePayload& hs)
+    {
+        return compare(hs.minimumVersion, hs.maximumVersion) == 0
+            && compare(hs.maximumVersion, CapabilitiesApiVersion) >= 0;
+    }
+
 } // namespace hermes
 
 #endif // HM_HANDSHAKE_PAYLOAD_H
\ No newline at end of file
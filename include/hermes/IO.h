@@ -21,6 +21,7 @@
 
 #include <hermes/Config.h>
 #include <hermes/Types.h>
+#include <hermes/HandshakePayload.h>
 
 namespace hermes
 {
@@ -68,6 +69,47 @@ namespace hermes
 		 */
 		virtual buffer_length_t write(const byte_t* buf, buffer_length_t length) = 0;
 
+		/**
+		 * Write as much as channel takes without blocking. Channels which can
+		 * not tell if writing would block just write.
+		 * @return Bytes written, less than length if the rest would block
+		 * @see wouldBlock()
+		 */
+		virtual buffer_length_t tryWrite(const byte_t* buf, buffer_length_t length) { return write(buf, length); }
+
+		/**
+		 * Send data the channel buffered on its own, without blocking.
+		 * @return true if nothing is left to send
+		 */
+		virtual bool drain() { return true; }
+
+		/**
+		 * @return File descriptor which becomes readable when data arrives,
+		 *         -1 if the channel has none
+		 */
+		virtual int descriptor() const { return -1; }
+
+		/**
+		 * Add protocol features the channel supports to a handshake offer.
+		 * Channels over another channel add features of that one too.
+		 * @param handshake Offer to fill in
+		 * @see Capability
+		 */
+		virtual void offer(HandshakePayload& handshake) const { (void) handshake; }
+
+		/**
+		 * Use features agreed at handshake for following messages.
+		 * @param handshake Agreed features
+		 * @return false if channel can not use them
+		 */
+		virtual bool negotiate(const HandshakePayload& handshake) { (void) handshake; return true; }
+
+		/**
+		 * @return true if the last write stopped because the channel can not
+		 *         take more data now, retry later.
+		 */
+		inline bool wouldBlock() const { return m_wouldBlock; }
+
 		/**
 		 * @param buf Byte buffer for placing data received.
 		 * @param buf Buffer size.
@@ -117,6 +159,9 @@ namespace hermes
 		 * @param false if something went wrong.
 		 */
 		virtual bool close() = 0;
+
+	protected:
+		bool m_wouldBlock = false;
 	};
 }
 
@@ -31,6 +31,11 @@
 
 namespace hermes
 {
+    /**
+     * Channel over a pair of byte vectors holding at most maxSize bytes in
+     * the output buffer. write() takes the whole buffer or nothing and
+     * reports would block, tryWrite() takes as much as fits.
+    */
     class InMemoryIO: public IO
     {
     public:
@@ -44,6 +49,7 @@ namespace hermes
         virtual buffer_length_t wait(buffer_length_t length) override;
         virtual buffer_length_t available() const override;
         virtual buffer_length_t write(const byte_t* buffer, buffer_length_t sz) override;
+        virtual buffer_length_t tryWrite(const byte_t* buffer, buffer_length_t sz) override;
         virtual buffer_length_t read(byte_t* buffer, buffer_length_t sz) override;
         virtual bool good() const override;
         virtual void flush() override;
@@ -21,14 +21,17 @@
 #define HM_MASTER_H
 
 #include <hermes/IO.h>
+#include <hermes/AdmissionControl.h>
 #include <hermes/Message.h>
+#include <hermes/Group.h>
 #include <hermes/SlaveDescriptor.h>
 #include <list>
 
 namespace hermes
 {
     /**
-     * Callback for handling connections from new clients
+     * Callback for handling connections from new clients, and from known
+     * clients which connected again
      * 
     */
     typedef void (*on_new_slave_fn_t)(SlaveDescriptor* slave);
@@ -48,13 +51,101 @@ namespace hermes
         inline void setAuthenticator(authenticate_fn_t authenticator)
         { m_authenticator = authenticator; }
 
+        /**
+         * Run new slave callbacks, and callbacks of accepted slaves, on the
+         * executor instead of the accepting thread.
+         * @param executor Executor, nullptr to run callbacks inline
+         * @note close() waits for callbacks of the slave pending on the
+         *       executor, called from one of them it drops the rest.
+        */
+        inline void setExecutor(Executor* executor) { m_executor = executor; }
+
+        /**
+         * Limit handshakes taken at once, slaves over the limits are answered
+         * with RetryLater and a suggested backoff.
+        */
+        inline void setAdmissionLimits(const AdmissionLimits& limits) { m_admission.setLimits(limits); }
+
+        inline const AdmissionStats& admissionStats() const { return m_admission.stats(); }
+
+        /**
+         * Journal values of all slaves. Caches of new and reconnected slaves
+         * are restored from the journal right after the new slave callback,
+         * which is the place to set their max ages.
+         * @param journal Journal, nullptr to disable
+         * @see PropertyJournal::replay
+        */
+        inline void setJournal(PropertyJournal* journal) { m_journal = journal; }
+
+        /**
+         * Keep tokens and schemas of slaves in the registry. A slave whose
+         * handshake carries the schema hash of the registry gets its schema
+         * from there instead of from the bus.
+         * @param registry Registry, e.g. loaded from a snapshot, nullptr to disable
+        */
+        inline void setRegistry(SlaveRegistry* registry) { m_registry = registry; }
+
+        /**
+         * Read the first message of a slave from io and register the slave.
+         * A known slave handshaking again is moved to io, sets queued for
+         * its old connection fail and the new slave callback runs again, the
+         * place to subscribe again.
+         * @return false if the slave was rejected or told to retry later
+        */
         bool accept(IO* io);
 
+        /**
+         * Ask a proxy slave for slaves reachable through it and register them.
+         * New slaves share the proxy's IO, are checked by the authenticator
+         * with an empty token and reported with the new slave callback.
+         * @param proxy Slave acting as a proxy
+         * @return Count of new slaves
+         * @note Requests to the proxy and slaves behind it go over the same
+         *       channel, their descriptors serialize them with one lock.
+        */
+        uint8_t discover(SlaveDescriptor& proxy);
+
+        /**
+         * Disconnect the slave and forget it, after its callbacks pending on
+         * the executor are done.
+        */
         void close(SlaveDescriptor& slave);
+
+        /**
+         * Set a property on every member of a group with a single frame.
+         * @param io Channel the group is reachable through: a proxy, a shared
+         *        bus or Multiplexer::channel(groupSerial(group))
+         * @param group Group to address, BroadcastGroup for all slaves
+         * @param value New value, value.name is the name of the property
+         * @param ack If not null, wait for acknowledgements and sum them up
+         * @param responders Count of answers expected on io: 1 for a proxy,
+         *        count of slaves attached for a shared bus
+         * @return false if sending failed or acknowledgements are missing
+         * @note This is a blocking method if acknowledgements are requested
+        */
+        bool setGroup(IO* io, group_t group, const ValueData& value,
+                      GroupAckData* ack = nullptr, uint16_t responders = 1);
+    private:
+        /**
+         * Set up a new slave and run the new slave callback for it.
+         * @param admission Admission the slave holds until the callback
+         *        returns, if any
+        */
+        void announce(SlaveDescriptor* slave, AdmissionControl* admission = nullptr);
+
+        /**
+         * Send requests of a reconnected slave over its new IO.
+        */
+        void rebind(SlaveDescriptor* slave, IO* io);
+
     private:
         IO* m_io;
+        Executor* m_executor = nullptr;
+        PropertyJournal* m_journal = nullptr;
+        SlaveRegistry* m_registry = nullptr;
         on_new_slave_fn_t m_new_client = nullptr;
         authenticate_fn_t m_authenticator = nullptr;
+        AdmissionControl m_admission;
         std::list<SlaveDescriptor> m_slaves;
     };
 }
@@ -23,11 +23,15 @@
 #include <hermes/CommandPayload.h>
 #include <hermes/ErrorPayload.h>
 #include <hermes/HandshakePayload.h>
+#include <hermes/ValueFormat.h>
 
 #ifdef HAS_STDINT_H
 #include <stdint.h>
 #endif // HAS_STDINT_H
 
+#include <stdio.h>
+#include <string.h>
+
 namespace hermes
 {
     enum class MessageType : uint8_t
@@ -40,20 +44,45 @@ namespace hermes
 
     const char* mt2str(const MessageType& type);
 
-    const char* vd2str(const ValueData& vd, char* str);
+    /**
+     * Format value as a null terminated string
+     * @param vd Value
+     * @param str Output buffer, at least Traits::StringLength bytes
+     * @return str or nullptr if value type is unknown
+     * @see formatValue
+    */
+    template<class Traits>
+    const char* vd2str(const BasicValueData<Traits>& vd, char* str)
+    {
+        char* end = formatValue(str, str + Traits::StringLength - 1, vd);
+        if (end == nullptr)
+            return nullptr;
+        *end = '\0';
+        return str;
+    }
 
+    /**
+     * Format value into a buffer of the calling thread, which is overwritten
+     * by the next call.
+     * @return Formatted value, empty string if value type is unknown
+    */
     const char* vd2str(const ValueData& vd);
 
     /**
      * @struct Messaje object to be send between endpoints
+     * @tparam Traits Sizes of fixed length fields
+     * @see MessageTraits
     */
-    struct Message // 256 bytes
+    template<class Traits>
+    struct BasicMessage
     {
+        using traits_t = Traits;
+
         /// @brief Serial number of slave
-        byte_t serial[HERMES_SERIAL_LENGTH];  // 8 by default
+        byte_t serial[Traits::SerialLength];  // 8 by default
 
         /// @brief Authentification token
-        byte_t token[HERMES_TOKEN_LENGTH];    // 8 by default
+        byte_t token[Traits::TokenLength];    // 8 by default
 
         /// @brief Useful data length in the package
         uint16_t payloadLength;               // 2
@@ -64,15 +93,17 @@ namespace hermes
         /// @brief Useful data in a message
         union Payload {
             /// @brief Data in command
-            CommandPayload command;
+            BasicCommandPayload<Traits> command;
 
             /// @brief Error info
-            ErrorPayload error;
+            BasicErrorPayload<Traits> error;
 
             /// @brief Handshake data
             HandshakePayload handshake;
         } payload;
     } __attribute__((packed));
+
+    using Message = BasicMessage<DefaultMessageTraits>; // 149 bytes by default
 }
 
 #endif // HM_MESSAGE_H
\ No newline at end of file
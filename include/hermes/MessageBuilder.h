@@ -23,26 +23,34 @@
 #include <hermes/Message.h>
 #include <hermes/Config.h>
 #include <string.h>
+#include <algorithm>
+#include <type_traits>
 
 namespace hermes
 {
     struct MessageBuilder
     {
-        static inline void setSerial(Message& msg, const byte_t* serial) { memcpy(&msg.serial, serial, HERMES_SERIAL_LENGTH); }
+        template<class Traits>
+        static inline void setSerial(BasicMessage<Traits>& msg, const byte_t* serial) { memcpy(&msg.serial, serial, Traits::SerialLength); }
 
-        static inline void setToken(Message& msg, const byte_t* token) { memcpy(&msg.token, token, HERMES_TOKEN_LENGTH); }
+        template<class Traits>
+        static inline void setToken(BasicMessage<Traits>& msg, const byte_t* token) { memcpy(&msg.token, token, Traits::TokenLength); }
 
-        static inline void setError(Message& msg, ErrorType error, const char* cause)
+        template<class Traits>
+        static inline void setError(BasicMessage<Traits>& msg, ErrorType error, const char* cause)
         {
+            const size_t len = std::min(strlen(cause), sizeof(msg.payload.error.msg) - 1);
             msg.type = MessageType::Error;
             msg.payload.error.e = error;
-            memcpy(msg.payload.error.msg, cause, strlen(cause));
-            msg.payload.error.msg[strlen(cause)] = '\0';
+            memcpy(msg.payload.error.msg, cause, len);
+            msg.payload.error.msg[len] = '\0';
             msg.payloadLength = sizeof(msg.payload.error);
         }
-        static Message handshake(const byte_t* serial, byte_t api_release, byte_t api_major, byte_t api_minor, const byte_t* token)
+
+        template<class Traits = DefaultMessageTraits>
+        static BasicMessage<Traits> handshake(const byte_t* serial, byte_t api_release, byte_t api_major, byte_t api_minor, const byte_t* token)
         {
-            Message msg;
+            BasicMessage<Traits> msg{};
             msg.type = MessageType::Handshake;
 
             setSerial(msg, serial);
@@ -64,6 +72,129 @@ namespace hermes
 
             return msg;
         }
+
+        /**
+         * Handshake offering a range of versions, the newest one is desired.
+         * Fill in capabilities with IO::offer().
+        */
+        template<class Traits = DefaultMessageTraits>
+        static BasicMessage<Traits> handshake(const byte_t* serial, const ApiVersion& minimum, const ApiVersion& maximum, const byte_t* token)
+        {
+            BasicMessage<Traits> msg = handshake<Traits>(serial, maximum.Release, maximum.Major, maximum.Minor, token);
+            msg.payload.handshake.minimumVersion = minimum;
+            return msg;
+        }
+
+        /**
+         * Copy message between frames with different traits. Serial and token
+         * are truncated or zero padded, strings are truncated.
+         * @param src Source message
+         * @param dst Destination message
+        */
+        template<class To, class From>
+        static void convert(const BasicMessage<From>& src, BasicMessage<To>& dst)
+        {
+            memset(&dst, 0, sizeof(dst));
+            memcpy(dst.serial, src.serial, std::min(sizeof(dst.serial), sizeof(src.serial)));
+            memcpy(dst.token, src.token, std::min(sizeof(dst.token), sizeof(src.token)));
+            dst.type = src.type;
+
+            switch (src.type) {
+            case MessageType::Command: {
+                dst.payload.command.command = src.payload.command.command;
+                convert(src.payload.command.command, src.payload.command.data, dst.payload.command.data);
+                dst.payloadLength = sizeof(dst.payload.command.data);
+                break;
+            }
+            case MessageType::Error:
+            case MessageType::InternalError: {
+                dst.payload.error.e = src.payload.error.e;
+                copyString(dst.payload.error.msg, sizeof(dst.payload.error.msg),
+                           src.payload.error.msg, sizeof(src.payload.error.msg));
+                dst.payloadLength = sizeof(dst.payload.error);
+                break;
+            }
+            case MessageType::Handshake: {
+                dst.payload.handshake = src.payload.handshake;
+                dst.payloadLength = sizeof(dst.payload.handshake);
+                break;
+            }
+            default: break;
+            }
+        }
+
+        /**
+         * Copy command data between traits. Data with the same layout is
+         * copied as is, otherwise fields used by the command are converted.
+         * @param cmd Command the data belongs to
+         * @param src Source data
+         * @param dst Destination data
+        */
+        template<class To, class From>
+        static void convert(Command cmd, const BasicCommandData<From>& src, BasicCommandData<To>& dst)
+        {
+            if (std::is_same<To, From>::value) {
+                memcpy(&dst, &src, sizeof(dst));
+                return;
+            }
+
+            switch (cmd) {
+            case Command::GetPropertiesCount:
+            case Command::GetRoutesCount:
+            case Command::PollEvents:
+                dst.count = src.count;
+                break;
+            case Command::GetPropertyName:
+                // Request carries the index, response the name
+                dst.index = src.index;
+                copyString(dst.string, sizeof(dst.string), src.string, sizeof(src.string));
+                break;
+            case Command::GetRoute:
+                // Request carries the index in the first byte of the serial
+                memcpy(dst.route.serial, src.route.serial,
+                       std::min(sizeof(dst.route.serial), sizeof(src.route.serial)));
+                dst.route.hops = src.route.hops;
+                break;
+            case Command::GroupSet:
+                // Request carries the value, acknowledgement the counters over
+                // the first bytes of the name
+                convert(src.value, dst.value);
+                dst.ack = src.ack;
+                break;
+            case Command::Subscribe:
+                copyString(dst.subscribe.name, sizeof(dst.subscribe.name),
+                           src.subscribe.name, sizeof(src.subscribe.name));
+                dst.subscribe.deadband = src.subscribe.deadband;
+                dst.subscribe.minInterval = src.subscribe.minInterval;
+                dst.subscribe.maxInterval = src.subscribe.maxInterval;
+                break;
+            case Command::Unsubscribe:
+                copyString(dst.string, sizeof(dst.string), src.string, sizeof(src.string));
+                break;
+            default:
+                convert(src.value, dst.value);
+                break;
+            }
+        }
+
+        template<class To, class From>
+        static void convert(const BasicValueData<From>& src, BasicValueData<To>& dst)
+        {
+            copyString(dst.name, sizeof(dst.name), src.name, sizeof(src.name));
+            dst.type = src.type;
+            if (src.type == ValueType::String)
+                copyString(dst.value.S, sizeof(dst.value.S), src.value.S, sizeof(src.value.S));
+            else
+                memcpy(&dst.value, &src.value, sizeof(FloatValue));
+        }
+
+    private:
+        static inline void copyString(char* dst, size_t dstLen, const char* src, size_t srcLen)
+        {
+            const size_t len = std::min(strnlen(src, srcLen), dstLen - 1);
+            memcpy(dst, src, len);
+            dst[len] = '\0';
+        }
     };
 } // namespace hermes
 
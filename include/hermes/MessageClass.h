@@ -0,0 +1,118 @@
+/**
+ * Hermes - A RPC for IOT
+ * Copyright (C) 2023  Eduard Sargsyan and Andrey Ovodov
+ * 
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ * 
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ * 
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#ifndef HM_MESSAGE_CLASS_H
+#define HM_MESSAGE_CLASS_H
+
+#include <hermes/Message.h>
+
+namespace hermes
+{
+    /**
+     * Traffic class of a message, used by send queues to decide what to do
+     * with it when a link is congested.
+    */
+    enum class MessageClass : uint8_t
+    {
+        /// @brief Handshake and requests changing slave's state (Set, Subscribe...)
+        Control = 0,
+
+        /// @brief Requests reading slave's state and errors
+        Query = 1,
+
+        /// @brief Updates sent by slaves on their own
+        Event = 2,
+
+        /// @brief Anything else
+        Bulk = 3
+    };
+
+    constexpr uint8_t MessageClassCount = 4;
+
+    /**
+     * @return Traffic class of the message, responses have the class of
+     *         their request.
+    */
+    template<class Traits>
+    inline MessageClass classify(const BasicMessage<Traits>& msg)
+    {
+        switch (msg.type) {
+        case MessageType::Handshake:
+            return MessageClass::Control;
+        case MessageType::Error:
+        case MessageType::InternalError:
+            return MessageClass::Query;
+        case MessageType::Command:
+            break;
+        default:
+            return MessageClass::Bulk;
+        }
+
+        switch (msg.payload.command.command) {
+        case Command::Disconnect:
+        case Command::Set:
+        case Command::GroupSet:
+        case Command::Subscribe:
+        case Command::Unsubscribe:
+            return MessageClass::Control;
+        case Command::Get:
+        case Command::GetPropertiesCount:
+        case Command::GetPropertyName:
+        case Command::GetRoutesCount:
+        case Command::GetRoute:
+            return MessageClass::Query;
+        case Command::PollEvents:
+        case Command::Update:
+            return MessageClass::Event;
+        }
+        return MessageClass::Bulk;
+    }
+
+    /**
+     * Pick the lane to send from next: the highest class ready to send,
+     * unless a lower one was passed over HERMES_LANE_MAX_BYPASS times.
+     * @param ready Classes with a message to send
+     * @param bypassed Times every class was passed over since it was served,
+     *        updated for the pick
+     * @return Class to send, MessageClassCount if none is ready
+    */
+    inline uint8_t pickLane(const bool (&ready)[MessageClassCount], uint8_t (&bypassed)[MessageClassCount])
+    {
+        uint8_t pick = MessageClassCount;
+        for (uint8_t c = MessageClassCount - 1; c > 0; --c) {
+            if (ready[c] && bypassed[c] >= HERMES_LANE_MAX_BYPASS)
+                pick = c;
+        }
+        for (uint8_t c = 0; c < MessageClassCount && pick == MessageClassCount; ++c) {
+            if (ready[c])
+                pick = c;
+        }
+        if (pick == MessageClassCount)
+            return pick;
+
+        for (uint8_t c = 0; c < MessageClassCount; ++c) {
+            if (c == pick || !ready[c])
+                bypassed[c] = 0;
+            else if (bypassed[c] < HERMES_LANE_MAX_BYPASS)
+                ++bypassed[c];
+        }
+        return pick;
+    }
+} // namespace hermes
+
+#endif // HM_MESSAGE_CLASS_H
@@ -0,0 +1,146 @@
+/**
+ * Hermes - A RPC for IOT
+ * Copyright (C) 2023  Eduard Sargsyan and Andrey Ovodov
+ * 
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ * 
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ * 
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#ifndef HM_MESSAGE_POOL_H
+#define HM_MESSAGE_POOL_H
+
+#include <hermes/Config.h>
+#include <hermes/Message.h>
+
+#include <stddef.h>
+#include <memory>
+
+#ifdef HAS_STD_MUTEX
+#include <mutex>
+#endif // HAS_STD_MUTEX
+
+namespace hermes
+{
+    /**
+     * Allocation counters of a MessagePool.
+    */
+    struct PoolStats
+    {
+        /// @brief Successful acquire() calls
+        uint32_t acquired = 0;
+
+        /// @brief release() calls
+        uint32_t released = 0;
+
+        /// @brief acquire() calls which failed because the slab was empty
+        uint32_t exhausted = 0;
+
+        /// @brief Slots currently in use
+        uint16_t inUse = 0;
+
+        /// @brief Maximum of inUse since construction
+        uint16_t peak = 0;
+    };
+
+    class MessageQueue;
+
+    /**
+     * Fixed-size slab of messages allocated once at construction. Messages
+     * are handed out by acquire() and recycled by release(), so steady state
+     * traffic does not touch the heap.
+    */
+    class MessagePool
+    {
+    public:
+        /**
+         * @param capacity Number of messages in the slab
+        */
+        explicit MessagePool(uint16_t capacity = HERMES_MESSAGE_POOL_SIZE);
+
+        MessagePool(const MessagePool&) = delete;
+        const MessagePool& operator = (const MessagePool&) = delete;
+
+        /**
+         * @return Free message or nullptr if all of them are in use.
+        */
+        Message* acquire();
+
+        /**
+         * Return message to the pool.
+         * @param msg Message obtained with acquire() from this pool.
+        */
+        void release(Message* msg);
+
+        inline uint16_t capacity() const { return m_capacity; }
+
+        inline const PoolStats& stats() const { return m_stats; }
+
+    private:
+        friend class MessageQueue;
+
+        struct Node
+        {
+            Node* next;
+            Message msg;
+        };
+
+        static inline Node* node(Message* msg)
+        { return reinterpret_cast<Node*>(reinterpret_cast<byte_t*>(msg) - offsetof(Node, msg)); }
+
+    private:
+        std::unique_ptr<Node[]> m_slab;
+        Node* m_free = nullptr;
+        uint16_t m_capacity;
+        PoolStats m_stats;
+        #ifdef HAS_STD_MUTEX
+        std::mutex m_mx;
+        #endif // HAS_STD_MUTEX
+    };
+
+    /**
+     * FIFO of messages acquired from a MessagePool. Links are kept in the
+     * pool slots, so pushing and popping never allocates.
+    */
+    class MessageQueue
+    {
+    public:
+        MessageQueue() = default;
+        MessageQueue(const MessageQueue&) = delete;
+        const MessageQueue& operator = (const MessageQueue&) = delete;
+
+        void push(Message* msg);
+
+        /**
+         * @return Oldest message or nullptr if queue is empty.
+        */
+        Message* pop();
+
+        inline Message* front() const { return m_head ? &m_head->msg : nullptr; }
+
+        inline bool empty() const { return m_head == nullptr; }
+
+        inline uint16_t size() const { return m_size; }
+
+        /**
+         * Release all queued messages to the pool.
+        */
+        void clear(MessagePool& pool);
+
+    private:
+        MessagePool::Node* m_head = nullptr;
+        MessagePool::Node* m_tail = nullptr;
+        uint16_t m_size = 0;
+    };
+} // namespace hermes
+
+#endif // HM_MESSAGE_POOL_H
@@ -0,0 +1,62 @@
+/**
+ * Hermes - A RPC for IOT
+ * Copyright (C) 2023  Eduard Sargsyan and Andrey Ovodov
+ * 
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ * 
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ * 
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#ifndef HM_MESSAGE_TRAITS_H
+#define HM_MESSAGE_TRAITS_H
+
+#include <hermes/Config.h>
+
+#ifndef HERMES_ERROR_MESSAGE_LENGTH
+#define HERMES_ERROR_MESSAGE_LENGTH 100
+#endif // HERMES_ERROR_MESSAGE_LENGTH
+
+namespace hermes
+{
+    /**
+     * Sizes of fixed length fields in a message. Message and value structures
+     * are parameterized by a traits type, so different channels in the same
+     * binary can use differently sized frames.
+     * @see BasicMessage
+     * @see SizedFrameIO
+    */
+    template<int SerialLen,
+             int TokenLen,
+             int StringLen,
+             int PropertyNameLen = StringLen,
+             int ErrorMessageLen = HERMES_ERROR_MESSAGE_LENGTH>
+    struct MessageTraits
+    {
+        static constexpr int SerialLength = SerialLen;
+        static constexpr int TokenLength = TokenLen;
+        static constexpr int StringLength = StringLen;
+        static constexpr int PropertyNameLength = PropertyNameLen;
+        static constexpr int ErrorMessageLength = ErrorMessageLen;
+    };
+
+    /**
+     * Traits built from HERMES_* configuration macros, used by Message,
+     * ValueData and all endpoints.
+    */
+    using DefaultMessageTraits = MessageTraits<HERMES_SERIAL_LENGTH,
+                                               HERMES_TOKEN_LENGTH,
+                                               HERMES_STRING_LENGTH,
+                                               HERMES_PROPERTY_NAME_MAX_LENGTH,
+                                               HERMES_ERROR_MESSAGE_LENGTH>;
+} // namespace hermes
+
+#endif // HM_MESSAGE_TRAITS_H
@@ -0,0 +1,189 @@
+/**
+ * Hermes - A RPC for IOT
+ * Copyright (C) 2023  Eduard Sargsyan and Andrey Ovodov
+ * 
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ * 
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ * 
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#ifndef HM_MULTIPLEXER_H
+#define HM_MULTIPLEXER_H
+
+#include <hermes/IO.h>
+#include <hermes/Message.h>
+#include <hermes/MessageClass.h>
+#include <hermes/MessagePool.h>
+
+#include <list>
+
+#ifdef HAS_STD_MUTEX
+#include <mutex>
+#include <condition_variable>
+#endif // HAS_STD_MUTEX
+
+namespace hermes
+{
+    class Multiplexer;
+
+    /**
+     * Logical channel to one slave on a multiplexed IO. Use it wherever an
+     * IO for a single slave is expected (Master::accept, SlaveDescriptor).
+     * @note Channels carry whole messages, reads and writes of other sizes fail.
+    */
+    class MuxChannel: public IO
+    {
+    public:
+        MuxChannel(Multiplexer* mux, const serial_t& serial);
+
+        virtual bool good() const override;
+        virtual void flush() override;
+        virtual buffer_length_t available() const override;
+        virtual buffer_length_t wait(buffer_length_t length) override;
+        virtual buffer_length_t write(const byte_t* buf, buffer_length_t length) override;
+        virtual buffer_length_t read(byte_t* buf, buffer_length_t length) override;
+
+        /**
+         * Stop receiving frames for this serial. Shared IO stays open.
+        */
+        virtual bool close() override;
+
+        inline const serial_t& serial() const { return m_serial; }
+
+    private:
+        friend class Multiplexer;
+
+        Multiplexer* m_mux;
+        serial_t m_serial;
+        MessagePool m_pool;
+        MessageQueue m_in;
+        MessageQueue m_out;
+        bool m_open = true;
+    };
+
+    /**
+     * Counters of a Multiplexer
+    */
+    struct MultiplexerStats
+    {
+        uint32_t framesIn = 0;
+        uint32_t framesOut = 0;
+
+        /// @brief Incoming frames dropped because the channel's queue was full
+        uint32_t framesDropped = 0;
+
+        /// @brief Channels opened by frames from new serials
+        uint32_t channelsOpened = 0;
+    };
+
+    /**
+     * Shares one IO (a bus or an uplink from a hub) between many slaves.
+     * Incoming frames are put into per-serial queues of MuxChannel. Whichever
+     * thread waits for data reads the shared IO on behalf of all channels, so
+     * no dedicated reader thread is needed. Outgoing frames are queued per
+     * channel and written round-robin, one frame per channel at a time,
+     * channels with higher MessageClass frames at their head going first.
+     * Frames addressed to a group are queued to every open channel, unless
+     * there is a channel for the group serial itself (master side collecting
+     * acknowledgements).
+     *
+     * @code
+     * Multiplexer mux(hubIo);
+     * while (MuxChannel* channel = mux.accept())
+     *     master.accept(channel);
+     * @endcode
+    */
+    class Multiplexer
+    {
+    public:
+        /**
+         * @param io Shared channel
+        */
+        explicit Multiplexer(IO* io);
+
+        Multiplexer(const Multiplexer&) = delete;
+        const Multiplexer& operator = (const Multiplexer&) = delete;
+
+        /**
+         * @param serial Slave serial
+         * @return Channel for the serial, created if needed
+        */
+        MuxChannel* channel(const serial_t& serial);
+
+        /**
+         * Wait for a frame from a serial without an open channel.
+         * @return Channel with the frame queued, nullptr if IO failed
+         * @note This is a blocking method
+        */
+        MuxChannel* accept();
+
+        /**
+         * Read one frame from the shared IO and queue it.
+         * @return false if reading failed
+         * @note For single threaded use, channels pump the IO by themselves.
+        */
+        bool poll();
+
+        inline bool good() const { return m_io->good(); }
+
+        inline const MultiplexerStats& stats() const { return m_stats; }
+
+    private:
+        friend class MuxChannel;
+
+        /**
+         * Queue message and write out pending frames of all channels.
+        */
+        bool send(MuxChannel* channel, const Message& msg);
+
+        /**
+         * Wait for a message for the channel.
+        */
+        bool receive(MuxChannel* channel, Message& msg);
+
+        /**
+         * Read shared IO until predicate holds, or wait while other thread does.
+         * @note Locks m_mx by itself, callers must not hold it
+        */
+        template<class Pred>
+        bool pumpUntil(Pred pred);
+
+        void dispatch(const Message& msg);
+
+        MuxChannel* find(const byte_t* serial);
+
+        /**
+         * @return Next channel with pending output by class, then round-robin.
+         *         A class passed over HERMES_LANE_MAX_BYPASS times in a row is
+         *         served next.
+        */
+        MuxChannel* nextOutbound();
+
+    private:
+        IO* m_io;
+        std::list<MuxChannel> m_channels;
+        std::list<MuxChannel*> m_accepted;
+        size_t m_cursor = 0;
+
+        /// @brief Times a class with pending output was passed over since it was served
+        uint8_t m_bypassed[MessageClassCount] = { 0 };
+        bool m_reading = false;
+        MultiplexerStats m_stats;
+        #ifdef HAS_STD_MUTEX
+        std::mutex m_mx;
+        std::mutex m_writeMx;
+        std::condition_variable m_cv;
+        #endif // HAS_STD_MUTEX
+    };
+} // namespace hermes
+
+#endif // HM_MULTIPLEXER_H
@@ -0,0 +1,132 @@
+/**
+ * Hermes - A RPC for IOT
+ * Copyright (C) 2023  Eduard Sargsyan and Andrey Ovodov
+ * 
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ * 
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ * 
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#ifndef HM_PROPERTY_CACHE_H
+#define HM_PROPERTY_CACHE_H
+
+#include <hermes/ValueData.h>
+#include <vector>
+
+#ifdef HAS_STD_MUTEX
+#include <mutex>
+#endif // HAS_STD_MUTEX
+
+namespace hermes
+{
+    struct CacheStats
+    {
+        /// @brief Reads answered from the cache
+        uint32_t hits = 0;
+
+        /// @brief Reads of cached properties which went to the slave
+        uint32_t misses = 0;
+
+        /// @brief Values refreshed by updates slave pushed
+        uint32_t pushed = 0;
+
+        uint32_t invalidated = 0;
+    };
+
+    /**
+     * Last known values of slave's properties, keyed by property index. A
+     * value is served while it is not older than max age of its property,
+     * properties with zero max age are not cached. Names of cached
+     * properties are kept too, they are needed to match pushed updates.
+     * Thread safe if HAS_STD_MUTEX is defined.
+    */
+    class PropertyCache
+    {
+    public:
+        /**
+         * @param ms Max age of properties without their own one, 0 to cache
+         *        only properties with their own max age
+        */
+        void setDefaultMaxAge(uint32_t ms);
+
+        /**
+         * @param property Index of the property
+         * @param ms Max age of the property's value, 0 to not cache it
+        */
+        void setMaxAge(uint8_t property, uint32_t ms);
+
+        uint32_t maxAge(uint8_t property) const;
+
+        /**
+         * @param now Milliseconds from any fixed point
+         * @return true if value is fresh enough, counts a hit or a miss for
+         *         cached properties
+        */
+        bool lookup(uint8_t property, uint32_t now, ValueData& value);
+
+        /**
+         * Remember value read at now if the property is cached.
+        */
+        void store(uint8_t property, uint32_t now, const ValueData& value);
+
+        /**
+         * Refresh value pushed by slave, property is found by value's name.
+         * @param property If not null, set to index of the property
+         * @return false if no cached property has that name
+        */
+        bool push(uint32_t now, const ValueData& value, uint8_t* property = nullptr);
+
+        void invalidate(uint8_t property);
+
+        /**
+         * Forget all values and names, e.g. after slave reconnected.
+        */
+        void clear();
+
+        /**
+         * @return false if name of the property is not known
+        */
+        bool name(uint8_t property, char* name) const;
+
+        void setName(uint8_t property, const char* name);
+
+        inline const CacheStats& stats() const { return m_stats; }
+
+    private:
+        struct Entry
+        {
+            /// @brief Value, its name is known if named is set
+            ValueData value;
+            uint32_t updated = 0;
+
+            /// @brief Own max age, Default to use default one
+            uint32_t maxAge = Default;
+            bool named = false;
+            bool valid = false;
+        };
+
+        static constexpr uint32_t Default = 0xFFFFFFFF;
+
+        Entry& entry(uint8_t property);
+        uint32_t maxAgeLocked(uint8_t property) const;
+
+    private:
+        std::vector<Entry> m_entries;
+        uint32_t m_defaultMaxAge = 0;
+        CacheStats m_stats;
+        #ifdef HAS_STD_MUTEX
+        mutable std::mutex m_mx;
+        #endif // HAS_STD_MUTEX
+    };
+} // namespace hermes
+
+#endif // HM_PROPERTY_CACHE_H
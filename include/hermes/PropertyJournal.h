@@ -0,0 +1,204 @@
+/**
+ * Hermes - A RPC for IOT
+ * Copyright (C) 2023  Eduard Sargsyan and Andrey Ovodov
+ * 
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ * 
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ * 
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#ifndef HM_PROPERTY_JOURNAL_H
+#define HM_PROPERTY_JOURNAL_H
+
+#include <hermes/ValueData.h>
+#include <map>
+#include <string>
+
+#ifdef HAS_STD_MUTEX
+#include <mutex>
+#endif // HAS_STD_MUTEX
+
+#ifdef HAS_STD_THREAD_H
+#include <condition_variable>
+#include <thread>
+#endif // HAS_STD_THREAD_H
+
+namespace hermes
+{
+    class SlaveDescriptor;
+
+    struct JournalStats
+    {
+        /// @brief Records appended since opening
+        uint32_t appended = 0;
+
+        /// @brief Values restored into caches
+        uint32_t replayed = 0;
+        uint32_t compactions = 0;
+
+        /// @brief Records in the file, latest and outdated ones
+        uint32_t records = 0;
+
+        /// @brief Count of (serial, property) pairs with a value
+        uint32_t live = 0;
+    };
+
+    /**
+     * Append-only journal of property values received by master, kept in a
+     * memory mapped file. Opening the journal reads it sequentially and keeps
+     * the offset of the latest value of every (serial, property), so after a
+     * restart master can warm caches of slaves (replay()) instead of polling
+     * them again. When the file holds HERMES_JOURNAL_COMPACT_RECORDS records
+     * and most of them are outdated, it is rewritten with the latest values
+     * only. That runs on a thread of the journal if HAS_STD_THREAD_H is
+     * defined, appends go on meanwhile. A failed compaction is tried again
+     * once the file grew by another compactAt records.
+     *
+     * Records have a fixed size and a CRC32C, a torn record at the end of the
+     * file, e.g. after a crash, ends the journal. Data reaches the page cache
+     * right away, call sync() to make it survive a power loss.
+     * Thread safe if HAS_STD_MUTEX is defined, needs HAS_LINUX_HEADERS.
+    */
+    class PropertyJournal
+    {
+    public:
+        /**
+         * Open or create the journal. A file of another version, record size
+         * or serial length is started over.
+         * @param path File of the journal
+         * @param compactAt Count of records after which compaction is tried
+        */
+        PropertyJournal(const char* path, uint32_t compactAt = HERMES_JOURNAL_COMPACT_RECORDS);
+        ~PropertyJournal();
+
+        inline bool isOpen() const { return m_map != nullptr; }
+
+        /**
+         * Append the latest value of a property.
+         * @param timestamp Milliseconds since the epoch, 0 for now
+         * @return false if the journal is not open or can't grow
+        */
+        bool append(const serial_t& serial, uint8_t property, const ValueData& value, uint64_t timestamp = 0);
+
+        /**
+         * Find the latest value of a property.
+         * @param timestamp Set to the time value was appended
+         * @return false if there is no value
+        */
+        bool find(const serial_t& serial, uint8_t property, ValueData& value, uint64_t& timestamp) const;
+
+        /**
+         * Restore latest values of slave's properties into its cache, with
+         * their age, so only values younger than max age are served. Call it
+         * after max ages of the cache are set.
+         * @return Count of values restored
+         * @see SlaveDescriptor::cache()
+        */
+        uint8_t replay(SlaveDescriptor& slave);
+
+        /**
+         * Rewrite the file with the latest values only. Appends do not wait
+         * for the new file to be written and synced.
+         * @return false if the new file could not be written, the old one
+         *         stays in use then
+        */
+        bool compact();
+
+        /**
+         * Flush appended records to the disk.
+        */
+        bool sync();
+
+        JournalStats stats() const;
+
+    private:
+        /**
+         * Journal record, fixed size so the file can be scanned without
+         * parsing.
+        */
+        struct Record
+        {
+            /// @brief CRC32C of the rest of the record
+            uint32_t checksum;
+            uint64_t timestamp;
+            byte_t serial[HERMES_SERIAL_LENGTH];
+            uint8_t property;
+            ValueData value;
+        } __attribute__((packed));
+
+        struct Header
+        {
+            char magic[4];
+            uint16_t version;
+            uint16_t recordSize;
+            uint8_t serialLength;
+            uint8_t reserved[7];
+        } __attribute__((packed));
+
+        static constexpr uint16_t Version = 1;
+
+        static std::string key(const byte_t* serial, uint8_t property);
+        static uint32_t checksum(const Record& record);
+
+        bool open();
+        void close();
+        bool map(size_t capacity);
+        bool appendLocked(const Record& record);
+
+        /**
+         * @return true if most records are outdated and compaction is due
+         * @note Has to be called with m_mx locked
+        */
+        bool compactionDue() const;
+        Record* record(size_t offset) const;
+
+        #if defined(HAS_STD_THREAD_H) && defined(HAS_STD_MUTEX)
+        /**
+         * Thread running compactions requested by append()
+        */
+        void compactor();
+        #endif // HAS_STD_THREAD_H && HAS_STD_MUTEX
+
+    private:
+        std::string m_path;
+        uint32_t m_compactAt;
+
+        /// @brief Compaction is not tried again before the file has this many records
+        uint32_t m_nextCompact = 0;
+        int m_fd = -1;
+        byte_t* m_map = nullptr;
+
+        /// @brief Mapped length of the file
+        size_t m_capacity = 0;
+
+        /// @brief Offset past the last valid record
+        size_t m_tail = 0;
+
+        /// @brief Offsets of latest records by serial and property
+        std::map<std::string, size_t> m_index;
+        JournalStats m_stats;
+        #ifdef HAS_STD_MUTEX
+        mutable std::mutex m_mx;
+
+        /// @brief Held for a whole compaction, appends only wait for m_mx
+        std::mutex m_compactMx;
+        #endif // HAS_STD_MUTEX
+        #if defined(HAS_STD_THREAD_H) && defined(HAS_STD_MUTEX)
+        std::thread m_compactor;
+        std::condition_variable m_compactCv;
+        bool m_compactDue = false;
+        bool m_stop = false;
+        #endif // HAS_STD_THREAD_H && HAS_STD_MUTEX
+    };
+} // namespace hermes
+
+#endif // HM_PROPERTY_JOURNAL_H
@@ -0,0 +1,179 @@
+/**
+ * Hermes - A RPC for IOT
+ * Copyright (C) 2023  Eduard Sargsyan and Andrey Ovodov
+ * 
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ * 
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ * 
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#ifndef HM_QUEUED_IO_H
+#define HM_QUEUED_IO_H
+
+#include <hermes/IO.h>
+#include <hermes/MessageClass.h>
+#include <hermes/MessagePool.h>
+
+#ifdef HAS_STD_MUTEX
+#include <condition_variable>
+#include <mutex>
+#endif // HAS_STD_MUTEX
+
+namespace hermes
+{
+    /**
+     * What to do with a message when send queue is congested
+    */
+    enum class OverflowPolicy : uint8_t
+    {
+        /// @brief Wait up to HERMES_SEND_TIMEOUT_MS for a free slot
+        Block = 0,
+
+        /// @brief Fail the write and report would block
+        Reject = 1,
+
+        /// @brief Drop the oldest queued message of the same class
+        DropOldest = 2
+    };
+
+    /**
+     * Counters of a QueuedIO
+    */
+    struct SendQueueStats
+    {
+        uint32_t sent = 0;
+        uint32_t queued = 0;
+
+        /// @brief Messages dropped by DropOldest policy
+        uint32_t dropped = 0;
+
+        /// @brief Writes failed by Reject policy or Block timeout
+        uint32_t rejected = 0;
+
+        /// @brief Writes which had to wait by Block policy
+        uint32_t blocked = 0;
+
+        uint16_t peak = 0;
+
+        /// @brief Sent messages per MessageClass
+        uint32_t sentByClass[MessageClassCount] = { 0 };
+    };
+
+    /**
+     * Bounded send queue in front of a channel. Messages go straight to the
+     * channel while it takes them without blocking and are queued otherwise.
+     * Once the queue reaches the high watermark, new messages are handled
+     * by the policy of their class until it drains to the low watermark.
+     * Queued messages are sent on following reads and writes, or drain().
+     *
+     * Every MessageClass has its own lane. Queued messages are sent in class
+     * order, so a Set waits at most for the message being sent, not for
+     * events queued before it. A lane which was passed over
+     * HERMES_LANE_MAX_BYPASS times is served next, so lower classes are
+     * delayed but never starved. When the queue is full, messages of lower
+     * classes with DropOldest policy make room for higher ones.
+     *
+     * Defaults: Control and Query block, Event drops oldest, Bulk is rejected.
+     * @note Queue carries whole messages, writes of other sizes fail.
+    */
+    class QueuedIO: public IO
+    {
+    public:
+        /**
+         * @param io Channel to send through
+         * @param capacity Messages which can be queued
+         * @param high Queue length to start applying policies at, 0 for capacity
+         * @param low Queue length to stop applying policies at, 0 for half of high
+        */
+        explicit QueuedIO(IO* io, uint16_t capacity = HERMES_SEND_QUEUE_SIZE, uint16_t high = 0, uint16_t low = 0);
+
+        inline void setPolicy(MessageClass cls, OverflowPolicy policy) { m_policies[static_cast<uint8_t>(cls)] = policy; }
+
+        inline OverflowPolicy policy(MessageClass cls) const { return m_policies[static_cast<uint8_t>(cls)]; }
+
+        /**
+         * Send queued messages while channel takes them without blocking.
+         * @return true if queue is empty
+        */
+        virtual bool drain() override;
+
+        /**
+         * @return Messages waiting to be sent, including partially sent one
+        */
+        uint16_t queued() const;
+
+        /**
+         * @return true if high watermark was reached and queue did not drain
+         *         to low watermark yet
+        */
+        inline bool congested() const { return m_congested; }
+
+        inline const SendQueueStats& stats() const { return m_stats; }
+
+        inline IO* io() const { return m_io; }
+
+        virtual void offer(HandshakePayload& handshake) const override { m_io->offer(handshake); }
+        virtual bool negotiate(const HandshakePayload& handshake) override { return m_io->negotiate(handshake); }
+        virtual bool good() const override;
+        virtual void flush() override;
+        virtual buffer_length_t available() const override;
+        virtual buffer_length_t wait(buffer_length_t length) override;
+        virtual buffer_length_t write(const byte_t* buf, buffer_length_t length) override;
+        virtual buffer_length_t read(byte_t* buf, buffer_length_t length) override;
+        virtual bool close() override;
+        virtual int descriptor() const override { return m_io->descriptor(); }
+
+    private:
+        bool drainLocked();
+        uint16_t pending() const;
+        bool push(const Message& msg);
+
+        /**
+         * @return Next message to send according to lane priorities
+        */
+        Message* next();
+
+        /**
+         * Drop the oldest message of a lower class with DropOldest policy.
+         * @return false if there is no such message
+        */
+        bool evictBelow(MessageClass cls);
+
+        inline MessageQueue& lane(MessageClass cls) { return m_lanes[static_cast<uint8_t>(cls)]; }
+
+    private:
+        IO* m_io;
+        MessagePool m_pool;
+        MessageQueue m_lanes[MessageClassCount];
+
+        /// @brief Times a lane with messages was passed over since it was served
+        uint8_t m_bypassed[MessageClassCount] = { 0 };
+
+        /// @brief Message being sent, m_offset bytes of it are written
+        Message* m_sending = nullptr;
+        buffer_length_t m_offset = 0;
+
+        OverflowPolicy m_policies[MessageClassCount];
+        uint16_t m_high;
+        uint16_t m_low;
+        bool m_congested = false;
+        SendQueueStats m_stats;
+        #ifdef HAS_STD_MUTEX
+        mutable std::mutex m_mx;
+
+        /// @brief Notified when queued messages were sent
+        std::condition_variable m_space;
+        #endif // HAS_STD_MUTEX
+    };
+} // namespace hermes
+
+#endif // HM_QUEUED_IO_H
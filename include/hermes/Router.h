@@ -0,0 +1,121 @@
+/**
+ * Hermes - A RPC for IOT
+ * Copyright (C) 2023  Eduard Sargsyan and Andrey Ovodov
+ * 
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ * 
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ * 
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#ifndef HM_ROUTER_H
+#define HM_ROUTER_H
+
+#include <hermes/IO.h>
+#include <hermes/Message.h>
+
+namespace hermes
+{
+    /**
+     * Downstream slave reachable through a proxy
+    */
+    struct Route
+    {
+        /// @brief Serial of the downstream slave
+        serial_t serial;
+
+        /// @brief Link the slave (or next proxy) is attached to
+        IO* link = nullptr;
+
+        /// @brief 1 if slave is attached directly to the link
+        uint8_t hops = 0;
+    };
+
+    /**
+     * Routing table of a proxy slave. A DummySlave with a router forwards
+     * frames addressed to other serials to the link hosting that serial and
+     * passes the response back upstream. Frames are forwarded as is, only
+     * the serial and command bytes are looked at.
+     *
+     * [Master] <--TCP--> [Proxy] <--UART--> [Slave]
+     *
+     * @note Since in many embedded systems there is no implementation of hash
+     *       maps and route count is small, lookup is linear.
+    */
+    class Router
+    {
+    public:
+        Router() = default;
+        Router(const Router&) = delete;
+        const Router& operator = (const Router&) = delete;
+
+        /**
+         * Add or update route
+         * @param serial Serial of the downstream slave
+         * @param link Link to forward frames for the serial to
+         * @param hops Distance to the slave
+         * @return false if routing table is full
+        */
+        bool addRoute(const serial_t& serial, IO* link, uint8_t hops = 1);
+
+        /**
+         * @return false if there was no route for the serial
+        */
+        bool removeRoute(const serial_t& serial);
+
+        /**
+         * Ask a downstream proxy for its routes and add them with one more hop.
+         * @param link Link the proxy is attached to
+         * @param proxy Serial of the proxy
+         * @return Routes added
+         * @note This is a blocking method
+        */
+        uint8_t discover(IO* link, const serial_t& proxy);
+
+        /**
+         * @return Link for the serial or nullptr if there is no route
+        */
+        IO* find(const byte_t* serial) const;
+
+        inline uint8_t routesCount() const { return m_count; }
+
+        /**
+         * @note Here is no check if index is correct, be careful calling this function!
+        */
+        inline const Route& route(uint8_t index) const { return m_routes[index]; }
+
+        /**
+         * Forward a frame to its destination and the response back.
+         * @param frame Frame received from upstream
+         * @param upstream Link to send the response to
+         * @return false if there is no route or forwarding failed
+         * @note Updates of subscriptions waiting on the link are passed upstream
+         *       before the response.
+        */
+        bool forward(const Message& frame, IO* upstream);
+
+        /**
+         * Send a group frame once over every link.
+         * @param frame Frame addressed to a group
+         * @param ack If not null, collect acknowledgements from the links and
+         *        add them. One answer is expected per slave attached directly
+         *        to the link, proxies answer for slaves behind them.
+         * @return false if writing to a link or collecting answers failed
+        */
+        bool broadcast(const Message& frame, GroupAckData* ack = nullptr);
+
+    private:
+        Route m_routes[HERMES_MAX_ROUTES];
+        uint8_t m_count = 0;
+    };
+} // namespace hermes
+
+#endif // HM_ROUTER_H
@@ -0,0 +1,119 @@
+/**
+ * Hermes - A RPC for IOT
+ * Copyright (C) 2023  Eduard Sargsyan and Andrey Ovodov
+ * 
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ * 
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ * 
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#ifndef HM_SCHEMA_H
+#define HM_SCHEMA_H
+
+#include <hermes/SchemaHash.h>
+#include <vector>
+
+#ifdef HAS_STD_MUTEX
+#include <mutex>
+#endif // HAS_STD_MUTEX
+
+namespace hermes
+{
+    /**
+     * Name and type of a property
+    */
+    struct PropertySchema
+    {
+        char name[HERMES_PROPERTY_NAME_MAX_LENGTH];
+        ValueType type;
+    };
+
+    /**
+     * Hash of a property table. Slaves send it at handshake, so master can
+     * tell its copy of the table is still valid.
+     * @return Hash, never 0 which stands for unknown
+     * @see SchemaHasher
+    */
+    uint32_t schemaHash(const PropertySchema* properties, uint8_t count);
+
+    /**
+     * Property table of a slave as master learns it from responses, or gets
+     * it from a SlaveRegistry. Thread safe if HAS_STD_MUTEX is defined.
+    */
+    class SlaveSchema
+    {
+    public:
+        /**
+         * @return false if count is not known
+        */
+        bool count(uint8_t& count) const;
+        void setCount(uint8_t count);
+
+        /**
+         * @return false if name of the property is not known
+        */
+        bool name(uint8_t property, char* name) const;
+        void setName(uint8_t property, const char* name);
+
+        /**
+         * @return Index of the property with name, -1 if it is not known
+        */
+        int16_t index(const char* name) const;
+
+        /**
+         * @return false if type of the property is not known
+        */
+        bool type(uint8_t property, ValueType& type) const;
+        void setType(uint8_t property, ValueType type);
+
+        /**
+         * @return true if count, names and types of all properties are known
+        */
+        bool complete() const;
+
+        /**
+         * @return Hash of the table, 0 if it is not complete
+        */
+        uint32_t hash() const;
+
+        /**
+         * @return Copy of the table, empty if it is not complete
+        */
+        std::vector<PropertySchema> properties() const;
+
+        /**
+         * Replace the table with a complete one.
+        */
+        void assign(const std::vector<PropertySchema>& properties);
+
+        void clear();
+
+    private:
+        struct Entry
+        {
+            PropertySchema property = {};
+            bool named = false;
+            bool typed = false;
+        };
+
+        bool completeLocked() const;
+
+    private:
+        std::vector<Entry> m_entries;
+        bool m_counted = false;
+        #ifdef HAS_STD_MUTEX
+        mutable std::mutex m_mx;
+        #endif // HAS_STD_MUTEX
+    };
+} // namespace hermes
+
+#endif // HM_SCHEMA_H
@@ -0,0 +1,61 @@
+/**
+ * Hermes - A RPC for IOT
+ * Copyright (C) 2023  Eduard Sargsyan and Andrey Ovodov
+ * 
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ * 
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ * 
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#ifndef HM_SCHEMA_HASH_H
+#define HM_SCHEMA_HASH_H
+
+#include <hermes/ValueData.h>
+
+namespace hermes
+{
+    /**
+     * FNV-1a hash of a property table: count, then names and types in order
+     * of indices. Needs no memory, so slaves can compute it when they
+     * handshake.
+    */
+    class SchemaHasher
+    {
+    public:
+        explicit SchemaHasher(uint8_t count) { mix(count); }
+
+        void add(const char* name, ValueType type)
+        {
+            for (size_t i = 0; i < HERMES_PROPERTY_NAME_MAX_LENGTH && name[i] != '\0'; ++i)
+                mix(static_cast<byte_t>(name[i]));
+            mix(0);
+            mix(type);
+        }
+
+        /**
+         * @return Hash, never 0 which stands for unknown
+        */
+        uint32_t value() const { return m_hash != 0 ? m_hash : 1; }
+
+    private:
+        void mix(byte_t b)
+        {
+            m_hash ^= b;
+            m_hash *= 16777619u;
+        }
+
+    private:
+        uint32_t m_hash = 2166136261u;
+    };
+} // namespace hermes
+
+#endif // HM_SCHEMA_HASH_H
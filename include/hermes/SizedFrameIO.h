@@ -0,0 +1,130 @@
+/**
+ * Hermes - A RPC for IOT
+ * Copyright (C) 2023  Eduard Sargsyan and Andrey Ovodov
+ * 
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ * 
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ * 
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#ifndef HM_SIZED_FRAME_IO_H
+#define HM_SIZED_FRAME_IO_H
+
+#include <hermes/IO.h>
+#include <hermes/Message.h>
+#include <hermes/MessageBuilder.h>
+
+namespace hermes
+{
+    /**
+     * Channel which carries BasicMessage<Traits> frames on the wire while its
+     * users keep reading and writing Message. Put it over a slow link to use
+     * small frames there and default sized frames everywhere else.
+     * @tparam Traits Frame sizes used on the wire
+     * @note Strings longer than Traits allows are truncated.
+    */
+    template<class Traits>
+    class SizedFrameIO: public IO
+    {
+    public:
+        using frame_t = BasicMessage<Traits>;
+
+        /**
+         * @param io Underlying channel
+        */
+        explicit SizedFrameIO(IO* io)
+            : m_io(io)
+        {}
+
+        CXX_VIRTUAL bool good() const CXX_OVERRIDE { return m_io->good(); }
+
+        CXX_VIRTUAL void flush() CXX_OVERRIDE
+        {
+            m_inPos = sizeof(Message);
+            m_outPos = 0;
+            m_io->flush();
+        }
+
+        CXX_VIRTUAL buffer_length_t available() const CXX_OVERRIDE
+        {
+            const size_t frames = m_io->available() / sizeof(frame_t);
+            return static_cast<buffer_length_t>(std::min<size_t>(pending() + frames * sizeof(Message), 0xFFFF));
+        }
+
+        CXX_VIRTUAL int descriptor() const CXX_OVERRIDE { return m_io->descriptor(); }
+
+        CXX_VIRTUAL buffer_length_t wait(buffer_length_t length) CXX_OVERRIDE
+        {
+            if (pending() < length) {
+                const size_t frames = (length - pending() + sizeof(Message) - 1) / sizeof(Message);
+                m_io->wait(static_cast<buffer_length_t>(frames * sizeof(frame_t)));
+            }
+            return available();
+        }
+
+        CXX_VIRTUAL buffer_length_t write(const byte_t* buf, buffer_length_t length) CXX_OVERRIDE
+        {
+            buffer_length_t done = 0;
+            while (done < length) {
+                const size_t n = std::min<size_t>(length - done, sizeof(Message) - m_outPos);
+                memcpy(reinterpret_cast<byte_t*>(&m_out) + m_outPos, buf + done, n);
+                m_outPos += n;
+                done += n;
+                if (m_outPos == sizeof(Message)) {
+                    m_outPos = 0;
+                    frame_t frame;
+                    MessageBuilder::convert(m_out, frame);
+                    if (!m_io->write(frame))
+                        return 0;
+                }
+            }
+            return done;
+        }
+
+        CXX_VIRTUAL buffer_length_t read(byte_t* buf, buffer_length_t length) CXX_OVERRIDE
+        {
+            buffer_length_t done = 0;
+            while (done < length) {
+                if (pending() == 0) {
+                    frame_t frame;
+                    if (!m_io->read(frame))
+                        break;
+                    MessageBuilder::convert(frame, m_in);
+                    m_inPos = 0;
+                }
+                const size_t n = std::min<size_t>(length - done, pending());
+                memcpy(buf + done, reinterpret_cast<const byte_t*>(&m_in) + m_inPos, n);
+                m_inPos += n;
+                done += n;
+            }
+            return done;
+        }
+
+        CXX_VIRTUAL void offer(HandshakePayload& handshake) const CXX_OVERRIDE { m_io->offer(handshake); }
+
+        CXX_VIRTUAL bool negotiate(const HandshakePayload& handshake) CXX_OVERRIDE { return m_io->negotiate(handshake); }
+
+        CXX_VIRTUAL bool close() CXX_OVERRIDE { return m_io->close(); }
+
+    private:
+        inline size_t pending() const { return sizeof(Message) - m_inPos; }
+
+    private:
+        IO* m_io;
+        Message m_in;
+        size_t m_inPos = sizeof(Message);
+        Message m_out;
+        size_t m_outPos = 0;
+    };
+} // namespace hermes
+
+#endif // HM_SIZED_FRAME_IO_H
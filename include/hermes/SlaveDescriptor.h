@@ -22,12 +22,20 @@
 
 #include <hermes/IO.h>
 #include <hermes/Event.h>
+#include <hermes/Executor.h>
 #include <hermes/Message.h>
+#include <hermes/PropertyCache.h>
+#include <hermes/PropertyJournal.h>
+#include <hermes/SlaveRegistry.h>
 #include <hermes/Slave.h>
 #include <vector>
-#include <list>
 #include <string>
 
+#ifdef HAS_STD_MUTEX
+#include <memory>
+#include <mutex>
+#endif // HAS_STD_MUTEX
+
 
 namespace hermes
 {
@@ -50,6 +58,44 @@ namespace hermes
     */
     typedef void (*on_event_fn_t)(event_t& event);
 
+    class SlaveDescriptor;
+
+    /**
+     * Callback for property updates of subscriptions
+    */
+    typedef void (*on_update_fn_t)(SlaveDescriptor* slave, const ValueData& value);
+
+    /**
+     * Callback for completed combined sets
+     * @param property Index of the property
+     * @param applied Value slave reported after the set, or the value sent if it failed
+     * @param ok false if set failed
+    */
+    typedef void (*on_set_fn_t)(SlaveDescriptor* slave, uint8_t property, const ValueData& applied, bool ok);
+
+    /**
+     * Counters of write combining
+    */
+    struct WriteCombiningStats
+    {
+        /// @brief Sets queued while combining is on
+        uint32_t queued = 0;
+
+        /// @brief Sets replaced by a later set of the same property
+        uint32_t combined = 0;
+
+        /// @brief Sets sent to slave
+        uint32_t sent = 0;
+    };
+
+    /**
+     * Master side proxy of a slave. Requests of concurrent threads are
+     * serialized, also between descriptors sharing a channel through
+     * Master::discover(). Callbacks run inline must not make requests on the
+     * same channel, set an executor for that. Requests go to the IO as they
+     * are made, message classes are only prioritized if it is a QueuedIO or
+     * a Multiplexer channel; poll() drains it.
+    */
     class SlaveDescriptor: public Slave
     {
     public:
@@ -60,14 +106,16 @@ namespace hermes
         SlaveDescriptor(IO* io, serial_t serial);
 
         /**
-         * Makes request to obtain available properties count
+         * Makes request to obtain available properties count, unless it is
+         * already known from schema().
          * @return Properties count associated with this slave.
          * @see Slave::propertiesCount
         */
         virtual uint8_t propertiesCount() override;
 
         /**
-         * Makes request to obtain property name by index
+         * Makes request to obtain property name by index, unless it is
+         * already known from schema().
          * @param index Index of the property
          * @param name Name of the property
          * @return True if slave responded with name
@@ -90,13 +138,15 @@ namespace hermes
 
 
         /**
-         * Get value type for the property.
+         * Get value type for the property, reads the property if the type is
+         * not known from schema().
          * @param index Property index.
         */
         virtual ValueType propertyType(uint8_t index) override;
 
         /**
-         * Assign new value to a property
+         * Assign new value to a property. With write combining the value is
+         * queued and sent after the window, see setWriteCombining().
          * @param property Index of the property
          * @param value New value.
          * @return false if writing new value to the property failed.
@@ -104,37 +154,203 @@ namespace hermes
         virtual bool set(uint8_t property, const ValueData& value) override;
 
         /**
-         * Fetch currrent value of a property
+         * Fetch currrent value of a property. Served from cache() if the
+         * property is cached and its value is fresh enough.
          * @param property Index of the property
          * @param value Storage for value.
          * @param false if Fetching failed for some reason.
         */
         virtual bool get(uint8_t property, ValueData& value) override;
 
+        /**
+         * Makes request to obtain routes count of a proxy slave
+         * @return Count of slaves reachable through this one
+         * @see Router
+        */
+        uint8_t routesCount();
+
+        /**
+         * Makes request to obtain a route of a proxy slave
+         * @param index Index of the route
+         * @param serial Serial of the downstream slave
+         * @param hops Distance from this slave to the downstream one
+         * @return True if slave responded with route
+        */
+        bool route(uint8_t index, serial_t& serial, uint8_t& hops);
+
         /**
          * @return Serial id
         */
         inline const serial_t& serial() const { return m_serial; }
 
+        /**
+         * @return API version agreed at handshake
+        */
+        inline const ApiVersion& version() const { return m_version; }
+
+        /**
+         * @return Capability bits agreed at handshake
+         * @see Capability
+        */
+        inline uint16_t capabilities() const { return m_capabilities; }
+
         /**
          * Set callback to handle new events from clients
          * @param callback Callback
         */
         inline void setEventsHandlerCallback(on_event_fn_t callback) { m_on_event = callback; }
 
+        /**
+         * Set callback to handle property updates sent for subscriptions
+         * @param callback Callback
+        */
+        inline void setUpdateCallback(on_update_fn_t callback) { m_on_update = callback; }
+
+        /**
+         * Run callbacks on the executor instead of the thread reading the
+         * message. Callbacks of one slave keep their order.
+         * @param executor Executor, nullptr to run callbacks inline
+        */
+        inline void setExecutor(Executor* executor) { m_executor = executor; }
+
+        /**
+         * Append values read, set and pushed to the journal. Pushed values
+         * are journaled for cached properties only, their index is not known
+         * otherwise.
+         * @param journal Journal, nullptr to stop journaling
+        */
+        inline void setJournal(PropertyJournal* journal) { m_journal = journal; }
+
+        /**
+         * Property table learned from responses, or restored from a registry.
+         * Names, count and types in it are not requested again.
+        */
+        inline const SlaveSchema& schema() const { return m_schema; }
+
+        /**
+         * Combine sets of the same property made within a window: set()
+         * queues the value and returns, only the last value queued in the
+         * window is sent. Completions are reported with the set callback.
+         * Queued sets are sent by following set(), poll() and flushSets().
+         * @param windowMs Window in milliseconds, 0 to send every set right away
+        */
+        inline void setWriteCombining(uint16_t windowMs) { m_combineWindow = windowMs; }
+
+        inline void setSetCallback(on_set_fn_t callback) { m_on_set = callback; }
+
+        /**
+         * Send queued sets whose window elapsed. Sets are sent by one thread
+         * at a time, if another one is sending them already this returns
+         * right away and leaves due sets to it.
+         * @param all Send all queued sets, e.g. before closing, waits for
+         *        the thread sending them
+         * @return Count of sets sent
+        */
+        uint8_t flushSets(bool all = false);
+
+        inline const WriteCombiningStats& writeStats() const { return m_writeStats; }
+
+        /**
+         * Ask slave to send updates of the property. The current value is
+         * reported with the update callback right away.
+         * @param property Index of the property
+         * @param deadband Change of the value needed for an update, 0 for any change
+         * @param minInterval Minimal milliseconds between updates
+         * @param maxInterval Milliseconds after which value is sent even if
+         *        unchanged, 0 to send changes only
+         * @return false if slave refused the subscription
+        */
+        bool subscribe(uint8_t property, float deadband, uint16_t minInterval, uint16_t maxInterval = 0);
+
+        bool unsubscribe(uint8_t property);
+
+        /**
+         * Handle updates which are already received, without blocking.
+         * Combined sets which are due are sent first, waiting for responses.
+         * Updates coming in during other requests are handled by them.
+         * @return Count of updates handled
+        */
+        uint8_t poll();
+
+        /**
+         * Read-through cache of property values, disabled by default. Set
+         * max age of properties to enable it, values are refreshed by
+         * updates of subscriptions.
+        */
+        inline PropertyCache& cache() { return m_cache; }
+
         void close();
     protected:
         friend class Master;
-        void add(const Message& msg);
+        friend class AsyncSlaveDescriptor;
+
+        /**
+         * Handle frames slave sends on its own.
+         * @return true if message was consumed and is not a response
+        */
         bool handle(Message& msg);
+
+        void notify(const ValueData& value);
         Message makeRequest(const Message& msg);
+
+        /**
+         * Property name from cache, or from slave.
+        */
+        bool nameOf(uint8_t property, char* name);
+
+        /**
+         * Send a Set and wait for the response.
+         * @param applied Value reported by slave
+        */
+        bool write(uint8_t property, const ValueData& value, ValueData& applied);
+
+        void completed(uint8_t property, const ValueData& applied, bool ok);
+
+        /**
+         * Report sets still queued as failed and forget them, they were
+         * meant for a connection which is gone.
+        */
+        void dropSets();
+
+        void record(uint8_t property, const ValueData& value);
+
+        /**
+         * Hand the schema to the registry if it is complete.
+        */
+        void learned();
+
+        struct PendingSet
+        {
+            uint8_t property;
+            uint32_t deadline;
+            ValueData value;
+        };
     private:
         IO* m_io;
-        std::list<Message> m_msgs;
         serial_t m_serial;
         token_t m_token;
-        Message m_rsp;
+        PropertyCache m_cache;
+        SlaveSchema m_schema;
+        SlaveRegistry* m_registry = nullptr;
+        ApiVersion m_version = MinimumApiVersion;
+        uint16_t m_capabilities = 0;
         on_event_fn_t m_on_event = nullptr;
+        on_update_fn_t m_on_update = nullptr;
+        on_set_fn_t m_on_set = nullptr;
+        uint16_t m_combineWindow = 0;
+        std::vector<PendingSet> m_pendingSets;
+        WriteCombiningStats m_writeStats;
+        #ifdef HAS_STD_MUTEX
+        std::mutex m_setsMx;
+
+        /// @brief Held while queued sets are sent, callbacks run inline may flush again
+        std::recursive_mutex m_flushMx;
+
+        /// @brief Held for a request and its response, shared by descriptors on one channel
+        std::shared_ptr<std::mutex> m_requestMx;
+        #endif // HAS_STD_MUTEX
+        Executor* m_executor = nullptr;
+        PropertyJournal* m_journal = nullptr;
     };
 }
 
@@ -0,0 +1,116 @@
+/**
+ * Hermes - A RPC for IOT
+ * Copyright (C) 2023  Eduard Sargsyan and Andrey Ovodov
+ * 
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ * 
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ * 
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#ifndef HM_SLAVE_REGISTRY_H
+#define HM_SLAVE_REGISTRY_H
+
+#include <hermes/Schema.h>
+#include <map>
+#include <string>
+
+#ifdef HAS_STD_MUTEX
+#include <mutex>
+#endif // HAS_STD_MUTEX
+
+namespace hermes
+{
+    /**
+     * What master knows about a slave
+    */
+    struct RegistryEntry
+    {
+        serial_t serial;
+
+        /// @brief Token slave was accepted with
+        token_t token;
+
+        /// @brief Hash of properties, 0 if the schema is not known
+        uint32_t schemaHash = 0;
+        std::vector<PropertySchema> properties;
+    };
+
+    /**
+     * Known slaves with their tokens and property tables, which master keeps
+     * in a snapshot file between restarts. Master updates the registry as
+     * slaves are accepted and their schemas learned, and gives the schema to
+     * a slave whose handshake carries the same schema hash, so its
+     * properties are not rediscovered over the bus.
+     *
+     * The snapshot is a header (magic "HMRS", version, serial and token
+     * lengths, count of entries, CRC32C of the entries) and entries of
+     * serial, token, schema hash, properties count and properties as name
+     * length, name and type, numbers in host byte order. Thread safe if
+     * HAS_STD_MUTEX is defined.
+     *
+     * Tokens are stored in plain text, so the snapshot has to be readable by
+     * master only. They are informational, master never authenticates a
+     * slave against the registry, that is up to the authenticator.
+    */
+    class SlaveRegistry
+    {
+    public:
+        /**
+         * Replace entries with ones of the snapshot.
+         * @return false if file can't be read or is corrupted, entries are
+         *         not changed then
+        */
+        bool load(const char* path);
+
+        /**
+         * Write a snapshot, the file is replaced atomically.
+        */
+        bool save(const char* path) const;
+
+        /**
+         * Remember slave accepted with token.
+        */
+        void remember(const serial_t& serial, const token_t& token);
+
+        /**
+         * Remember a complete schema of a slave.
+        */
+        void setSchema(const serial_t& serial, const std::vector<PropertySchema>& properties);
+
+        /**
+         * @return false if slave is not known
+        */
+        bool find(const serial_t& serial, RegistryEntry& entry) const;
+
+        void forget(const serial_t& serial);
+
+        size_t size() const;
+
+        /**
+         * @return true if entries changed since the last load() or save()
+        */
+        bool dirty() const;
+
+    private:
+        static std::string key(const serial_t& serial);
+        RegistryEntry& entry(const serial_t& serial);
+
+    private:
+        std::map<std::string, RegistryEntry> m_entries;
+        mutable bool m_dirty = false;
+        #ifdef HAS_STD_MUTEX
+        mutable std::mutex m_mx;
+        #endif // HAS_STD_MUTEX
+    };
+} // namespace hermes
+
+#endif // HM_SLAVE_REGISTRY_H
@@ -0,0 +1,141 @@
+/**
+ * Hermes - A RPC for IOT
+ * Copyright (C) 2023  Eduard Sargsyan and Andrey Ovodov
+ * 
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ * 
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ * 
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#ifndef HM_TASK_H
+#define HM_TASK_H
+
+#include <hermes/Config.h>
+
+#ifdef HM_HAS_COROUTINES
+
+#include <coroutine>
+#include <exception>
+#include <utility>
+
+namespace hermes
+{
+    template<typename T>
+    class Task;
+
+    namespace detail
+    {
+        /**
+         * Resumes the awaiting coroutine when task completes
+        */
+        struct TaskFinalAwaiter
+        {
+            inline bool await_ready() const noexcept { return false; }
+
+            template<typename Promise>
+            inline std::coroutine_handle<> await_suspend(std::coroutine_handle<Promise> h) noexcept
+            {
+                if (h.promise().continuation)
+                    return h.promise().continuation;
+                return std::noop_coroutine();
+            }
+
+            inline void await_resume() const noexcept {}
+        };
+
+        struct TaskPromiseBase
+        {
+            inline std::suspend_always initial_suspend() const noexcept { return {}; }
+            inline TaskFinalAwaiter final_suspend() const noexcept { return {}; }
+            inline void unhandled_exception() const noexcept { std::terminate(); }
+
+            std::coroutine_handle<> continuation;
+        };
+    } // namespace detail
+
+    /**
+     * Lazily started coroutine returning T. Starts when awaited and resumes
+     * the awaiting coroutine on completion.
+     * @code
+     * Task<bool> refresh(AsyncSlaveDescriptor& slave)
+     * {
+     *     ValueData vd;
+     *     co_return co_await slave.get(0, vd);
+     * }
+     * @endcode
+    */
+    template<typename T>
+    class Task
+    {
+    public:
+        struct promise_type: detail::TaskPromiseBase
+        {
+            inline Task get_return_object() { return Task(std::coroutine_handle<promise_type>::from_promise(*this)); }
+            inline void return_value(T v) { value = std::move(v); }
+
+            T value {};
+        };
+
+        Task(Task&& src) noexcept : m_h(std::exchange(src.m_h, nullptr)) {}
+        Task(const Task&) = delete;
+        ~Task() { if (m_h) m_h.destroy(); }
+
+        inline bool await_ready() const noexcept { return false; }
+
+        inline std::coroutine_handle<> await_suspend(std::coroutine_handle<> awaiting) noexcept
+        {
+            m_h.promise().continuation = awaiting;
+            return m_h;
+        }
+
+        inline T await_resume() { return std::move(m_h.promise().value); }
+
+    private:
+        explicit Task(std::coroutine_handle<promise_type> h) : m_h(h) {}
+
+        std::coroutine_handle<promise_type> m_h;
+    };
+
+    template<>
+    class Task<void>
+    {
+    public:
+        struct promise_type: detail::TaskPromiseBase
+        {
+            inline Task get_return_object() { return Task(std::coroutine_handle<promise_type>::from_promise(*this)); }
+            inline void return_void() const noexcept {}
+        };
+
+        Task(Task&& src) noexcept : m_h(std::exchange(src.m_h, nullptr)) {}
+        Task(const Task&) = delete;
+        ~Task() { if (m_h) m_h.destroy(); }
+
+        inline bool await_ready() const noexcept { return false; }
+
+        inline std::coroutine_handle<> await_suspend(std::coroutine_handle<> awaiting) noexcept
+        {
+            m_h.promise().continuation = awaiting;
+            return m_h;
+        }
+
+        inline void await_resume() const noexcept {}
+
+    private:
+        explicit Task(std::coroutine_handle<promise_type> h) : m_h(h) {}
+
+        std::coroutine_handle<promise_type> m_h;
+    };
+} // namespace hermes
+
+#endif // HM_HAS_COROUTINES
+
+#endif // HM_TASK_H
@@ -0,0 +1,189 @@
+/**
+ * Hermes - A RPC for IOT
+ * Copyright (C) 2023  Eduard Sargsyan and Andrey Ovodov
+ * 
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ * 
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ * 
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#ifndef HM_TELEMETRY_COLLECTOR_H
+#define HM_TELEMETRY_COLLECTOR_H
+
+#include <hermes/ValueData.h>
+#include <stddef.h>
+#include <stdio.h>
+#include <vector>
+
+#ifdef HAS_STD_MUTEX
+#include <mutex>
+#endif // HAS_STD_MUTEX
+
+namespace hermes
+{
+    class SlaveDescriptor;
+
+    /**
+     * Destination of telemetry blocks, e.g. a file or a socket of an
+     * ingestion pipeline.
+    */
+    class TelemetrySink
+    {
+    public:
+        virtual ~TelemetrySink() = default;
+
+        /**
+         * @return false if block was not written
+        */
+        virtual bool write(const byte_t* data, size_t length) = 0;
+    };
+
+    /**
+     * Appends blocks to a file.
+    */
+    class FileTelemetrySink: public TelemetrySink
+    {
+    public:
+        FileTelemetrySink(const char* path);
+        ~FileTelemetrySink();
+
+        inline bool isOpen() const { return m_file != nullptr; }
+
+        virtual bool write(const byte_t* data, size_t length) override;
+    private:
+        FILE* m_file;
+    };
+
+    struct TelemetryStats
+    {
+        /// @brief Samples written to the sink
+        uint64_t rows = 0;
+        uint32_t blocks = 0;
+        uint64_t bytes = 0;
+
+        /// @brief Samples lost because of unknown type or a failed write
+        uint64_t dropped = 0;
+    };
+
+    /**
+     * Collects samples (serial, property index, timestamp, value) of the
+     * master and writes them to a sink in columnar blocks, so the pipeline
+     * ingests a batch at once instead of formatting values one by one.
+     * Thread safe if HAS_STD_MUTEX is defined.
+     *
+     * Block layout, numbers are little endian and every column starts at a
+     * multiple of 8 bytes:
+     *
+     *     char   magic[4]         "HMTB"
+     *     uint16 version          TelemetryCollector::Version
+     *     uint8  serialLength     HERMES_SERIAL_LENGTH
+     *     uint8  groups           count of groups which follow
+     *     uint32 rows             count of samples in all groups
+     *     uint32 length           length of the block with this header
+     *
+     * A group of samples for every ValueType present, in the order of types:
+     *
+     *     uint8  type             ValueType
+     *     uint8  columns          count of columns which follow
+     *     uint16 reserved
+     *     uint32 rows
+     *
+     * Columns of a group, each is a uint32 byte length, uint32 reserved and
+     * data padded with zeros to 8 bytes:
+     *
+     *     serial      rows * serialLength bytes
+     *     property    uint8[rows]
+     *     timestamp   uint64[rows], milliseconds
+     *     value       uint8[rows] for Boolean, int32[rows] for Integer,
+     *                 uint32[rows] for UnsignedInteger, int32[rows] V for Float
+     *     precision   uint16[rows], Float only
+     *     offsets     uint32[rows + 1] of strings in the next column, String only
+     *     value       bytes of strings without terminators, String only
+    */
+    class TelemetryCollector
+    {
+    public:
+        static constexpr uint16_t Version = 1;
+
+        /**
+         * @param sink Destination of blocks
+         * @param batch Count of samples after which a block is written
+        */
+        TelemetryCollector(TelemetrySink* sink, size_t batch = HERMES_TELEMETRY_BATCH_SIZE);
+
+        /**
+         * Writes samples collected so far.
+        */
+        ~TelemetryCollector();
+
+        /**
+         * Add a sample, a block is written when batch is full.
+         * @param timestamp Milliseconds, e.g. since the epoch
+         * @return false if value type is unknown or writing the block failed
+        */
+        bool add(const serial_t& serial, uint8_t property, uint64_t timestamp, const ValueData& value);
+
+        /**
+         * Read every property of slave and add it.
+         * @return Count of samples added
+        */
+        uint8_t collect(SlaveDescriptor& slave, uint64_t timestamp);
+
+        /**
+         * Write collected samples as a block, even if batch is not full.
+         * @return false if writing failed, samples are dropped then
+        */
+        bool flush();
+
+        /**
+         * @return Count of samples waiting for the next block
+        */
+        size_t pending() const;
+
+        TelemetryStats stats() const;
+
+    private:
+        struct Group
+        {
+            std::vector<byte_t> serials;
+            std::vector<uint8_t> properties;
+            std::vector<uint64_t> timestamps;
+
+            /// @brief Fixed width values, V of floats, or string bytes
+            std::vector<byte_t> values;
+            std::vector<uint16_t> precisions;
+            std::vector<uint32_t> offsets;
+            uint32_t rows = 0;
+        };
+
+        static constexpr uint8_t TypesCount = ValueType::Float + 1;
+
+        bool flushLocked();
+        void encode(uint8_t type, const Group& group);
+        void column(const void* data, size_t length);
+
+    private:
+        TelemetrySink* m_sink;
+        size_t m_batch;
+        size_t m_rows = 0;
+        Group m_groups[TypesCount];
+
+        /// @brief Encoded block, reused between flushes
+        std::vector<byte_t> m_block;
+        TelemetryStats m_stats;
+        #ifdef HAS_STD_MUTEX
+        mutable std::mutex m_mx;
+        #endif // HAS_STD_MUTEX
+    };
+} // namespace hermes
+
+#endif // HM_TELEMETRY_COLLECTOR_H
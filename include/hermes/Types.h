@@ -38,7 +38,7 @@ namespace hermes
     {
         inline Buffer(byte_t val = 0) { memset(data, val, Length); }
         inline Buffer(const byte_t* val) { *this = val; }
-        inline Buffer(Buffer& src) { *this = src; }
+        inline Buffer(const Buffer& src) { *this = src; }
         inline const Buffer& operator = (const Buffer& src) { *this = src.data; return *this;}
         inline const Buffer& operator = (const byte_t* src) { memcpy(data, src, Length); return *this; }
         inline bool operator == (const Buffer& src) const { return *this == src.data; }
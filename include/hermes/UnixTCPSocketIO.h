@@ -21,8 +21,6 @@
 
 #include <hermes/IO.h>
 
-#include <vector>
-
 namespace hermes
 {
     class UnixTCPSocketIO: public IO
@@ -32,15 +30,30 @@ namespace hermes
         virtual ~UnixTCPSocketIO() = default;
         virtual buffer_length_t wait(buffer_length_t length) override;
         virtual buffer_length_t available() const override;
+        /**
+         * Blocks at most HERMES_TCP_SOCK_WRITE_TIMEOUT_SEC, reports would
+         * block if socket's send buffer stays full and nothing was sent. A
+         * timeout after part of the buffer was sent breaks the channel, see
+         * good().
+        */
         virtual buffer_length_t write(const byte_t* buffer, buffer_length_t sz) override;
+        virtual buffer_length_t tryWrite(const byte_t* buffer, buffer_length_t sz) override;
         virtual buffer_length_t read(byte_t* buffer, buffer_length_t sz) override;
         virtual bool good() const override;
         virtual void flush() override;
         virtual bool close() override;
+        virtual int descriptor() const override { return m_sfd; }
+
+    private:
+        inline buffer_length_t buffered() const { return m_end - m_begin; }
+        buffer_length_t send(const byte_t* buffer, buffer_length_t sz, int flags);
 
     private:
         int m_sfd;
-        mutable std::vector<byte_t> m_buffer;
+        /// @brief Receive buffer, bytes [m_begin, m_end) are not consumed yet
+        byte_t m_buffer[HERMES_TCP_BUFFER_LENGTH];
+        buffer_length_t m_begin = 0;
+        buffer_length_t m_end = 0;
         mutable bool m_good;
     };
 }
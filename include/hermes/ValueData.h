@@ -21,6 +21,7 @@
 #define HM_VALUE_DATA_H
 
 #include <hermes/Types.h>
+#include <hermes/MessageTraits.h>
 
 namespace hermes
 {
@@ -39,18 +40,21 @@ namespace hermes
         uint16_t Precision;
     } __attribute__((packed));
 
-    struct ValueData
+    template<class Traits>
+    struct BasicValueData
     {
-        char name[HERMES_PROPERTY_NAME_MAX_LENGTH];
+        char name[Traits::PropertyNameLength];
         ValueType type; // 1
         union {
             uint8_t B;  // 1
             int32_t I;  // 4
             uint32_t U; // 4
-            char S[HERMES_STRING_LENGTH];
+            char S[Traits::StringLength];
             FloatValue F;
         } value;
     } __attribute__((packed));
+
+    using ValueData = BasicValueData<DefaultMessageTraits>;
 } // namespace hermes
 
 #endif // HM_VALUE_DATA_H
\ No newline at end of file
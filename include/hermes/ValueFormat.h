@@ -0,0 +1,178 @@
+/**
+ * Hermes - A RPC for IOT
+ * Copyright (C) 2023  Eduard Sargsyan and Andrey Ovodov
+ * 
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ * 
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ * 
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#ifndef HM_VALUE_FORMAT_H
+#define HM_VALUE_FORMAT_H
+
+#include <hermes/ValueData.h>
+#include <stddef.h>
+#include <string.h>
+
+namespace hermes
+{
+    /**
+     * Formatting and parsing of values into caller's buffers. Like
+     * std::to_chars() and std::from_chars() functions below keep no state,
+     * allocate nothing and do not null terminate, so they can be used by
+     * many threads at once.
+     *
+     * Floats with precision of a power of ten are formatted exactly, i.e.
+     * {3145, 1000} is "3.145". Parsing a float picks the precision from the
+     * count of fraction digits, at most 4.
+    */
+
+    /**
+     * @return Pointer past the last written character or nullptr if the
+     *         value does not fit into [first, last)
+    */
+    char* formatBoolean(char* first, char* last, bool value);
+    char* formatInteger(char* first, char* last, int32_t value);
+    char* formatUnsigned(char* first, char* last, uint32_t value);
+
+    /**
+     * @return Pointer past the last written character or nullptr if the
+     *         value does not fit or its precision is 0
+    */
+    char* formatFloat(char* first, char* last, const FloatValue& value);
+
+    /**
+     * Parse the whole range [first, last).
+     * @return false if range is not a valid value of the type, nothing
+     *         is stored then
+    */
+    bool parseBoolean(const char* first, const char* last, uint8_t& value);
+    bool parseInteger(const char* first, const char* last, int32_t& value);
+    bool parseUnsigned(const char* first, const char* last, uint32_t& value);
+    bool parseFloat(const char* first, const char* last, FloatValue& value);
+
+    /**
+     * Format value, as std::to_chars().
+     * @param first Output buffer
+     * @param last End of the output buffer
+     * @param vd Value
+     * @return Pointer past the last written character, nullptr if value does
+     *         not fit or its type is unknown
+    */
+    template<class Traits>
+    char* formatValue(char* first, char* last, const BasicValueData<Traits>& vd)
+    {
+        switch (vd.type)
+        {
+        case ValueType::Boolean:
+            return formatBoolean(first, last, vd.value.B);
+        case ValueType::Integer:
+            return formatInteger(first, last, vd.value.I);
+        case ValueType::UnsignedInteger:
+            return formatUnsigned(first, last, vd.value.U);
+        case ValueType::Float:
+            return formatFloat(first, last, vd.value.F);
+        case ValueType::String:
+        {
+            size_t length = strnlen(vd.value.S, Traits::StringLength);
+            if (size_t(last - first) < length)
+                return nullptr;
+            memcpy(first, vd.value.S, length);
+            return first + length;
+        }
+        default:
+            return nullptr;
+        }
+    }
+
+    /**
+     * Parse value of type vd.type from the whole range [first, last).
+     * @return false if range is not a valid value of the type or a string
+     *         is too long, vd is not changed then
+    */
+    template<class Traits>
+    bool parseValue(const char* first, const char* last, BasicValueData<Traits>& vd)
+    {
+        switch (vd.type)
+        {
+        case ValueType::Boolean:
+        {
+            uint8_t value;
+            if (!parseBoolean(first, last, value))
+                return false;
+            vd.value.B = value;
+            return true;
+        }
+        case ValueType::Integer:
+        {
+            int32_t value;
+            if (!parseInteger(first, last, value))
+                return false;
+            vd.value.I = value;
+            return true;
+        }
+        case ValueType::UnsignedInteger:
+        {
+            uint32_t value;
+            if (!parseUnsigned(first, last, value))
+                return false;
+            vd.value.U = value;
+            return true;
+        }
+        case ValueType::Float:
+        {
+            FloatValue value;
+            if (!parseFloat(first, last, value))
+                return false;
+            vd.value.F = value;
+            return true;
+        }
+        case ValueType::String:
+        {
+            size_t length = last - first;
+            if (length >= Traits::StringLength || memchr(first, '\0', length) != nullptr)
+                return false;
+            memcpy(vd.value.S, first, length);
+            memset(vd.value.S + length, '\0', Traits::StringLength - length);
+            return true;
+        }
+        default:
+            return false;
+        }
+    }
+
+    /**
+     * Format values one after another, each followed by separator, e.g. to
+     * export a batch of samples.
+     * @param end Set past the last written character
+     * @return Count of values written, less than count if the buffer is full
+     *         or a value has unknown type
+    */
+    template<class Traits>
+    size_t formatValues(char* first, char* last, const BasicValueData<Traits>* values,
+                        size_t count, char separator, char*& end)
+    {
+        size_t i = 0;
+        end = first;
+        for (; i < count; ++i)
+        {
+            char* next = formatValue(end, last, values[i]);
+            if (next == nullptr || next == last)
+                break;
+            *next++ = separator;
+            end = next;
+        }
+        return i;
+    }
+} // namespace hermes
+
+#endif // HM_VALUE_FORMAT_H
@@ -0,0 +1,168 @@
+/**
+ * Hermes - A RPC for IOT
+ * Copyright (C) 2023  Eduard Sargsyan and Andrey Ovodov
+ * 
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ * 
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ * 
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#ifndef HM_WORK_STEALING_POOL_H
+#define HM_WORK_STEALING_POOL_H
+
+#include <hermes/Executor.h>
+
+#ifdef HAS_STD_THREAD_H
+
+#include <atomic>
+#include <condition_variable>
+#include <deque>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <unordered_map>
+#include <vector>
+
+namespace hermes
+{
+    /**
+     * Counters of a WorkStealingPool
+    */
+    struct ExecutorStats
+    {
+        uint64_t posted = 0;
+        uint64_t executed = 0;
+
+        /// @brief Jobs taken from queue of another worker
+        uint64_t stolen = 0;
+
+        /// @brief Jobs refused by tryPost because pool was full
+        uint64_t rejected = 0;
+
+        /// @brief Posts which had to wait for free space
+        uint64_t blocked = 0;
+
+        size_t pending = 0;
+        size_t peak = 0;
+    };
+
+    /**
+     * Thread pool where every worker has its own queue and idle workers
+     * steal from the others. Jobs with the same key form a strand: only one
+     * of them runs at a time, in posting order, so callbacks of one slave
+     * never overlap while different slaves run in parallel.
+     *
+     * At most capacity jobs are pending. Above that post() blocks the
+     * posting thread until workers catch up, which slows down reading from
+     * slaves instead of growing queues without bound.
+    */
+    class WorkStealingPool: public Executor
+    {
+    public:
+        /**
+         * @param threads Worker count, 0 for hardware concurrency
+         * @param capacity Maximum count of pending jobs
+        */
+        explicit WorkStealingPool(unsigned threads = 0, size_t capacity = HERMES_EXECUTOR_CAPACITY);
+        ~WorkStealingPool();
+
+        WorkStealingPool(const WorkStealingPool&) = delete;
+        const WorkStealingPool& operator = (const WorkStealingPool&) = delete;
+
+        /**
+         * Blocks while pool is full.
+         * @note Posting from a job never blocks to avoid deadlocks, pool can
+         *       go above capacity then.
+        */
+        virtual bool post(const void* key, job_t job) override;
+
+        /**
+         * @return false if pool is full
+        */
+        bool tryPost(const void* key, job_t job);
+
+        /**
+         * Block until all pending jobs are done
+        */
+        void wait();
+
+        /**
+         * Called from a job of the strand itself, drops the jobs of the
+         * strand which did not start yet instead of waiting for them.
+         * @note Called from a job of another strand it holds that worker, a
+         *       pool with one thread deadlocks then.
+        */
+        virtual void drain(const void* key) override;
+
+        /**
+         * Stop and join workers. Jobs not started yet are dropped.
+        */
+        void stop();
+
+        ExecutorStats stats() const;
+
+        inline unsigned threads() const { return static_cast<unsigned>(m_workers.size()); }
+
+    private:
+        struct Strand
+        {
+            std::deque<job_t> jobs;
+            bool scheduled = false;
+        };
+
+        /**
+         * Either a single job, or a strand with jobs waiting
+        */
+        struct Item
+        {
+            const void* key;
+            Strand* strand;
+            job_t job;
+        };
+
+        struct Worker
+        {
+            std::mutex mx;
+            std::deque<Item> items;
+        };
+
+        bool enqueue(const void* key, job_t&& job, bool block);
+        void push(Item&& item);
+        bool take(size_t self, Item& item);
+        void run(size_t self);
+        void execute(Item& item);
+        void done(std::unique_lock<std::mutex>& lock);
+
+    private:
+        std::vector<std::unique_ptr<Worker>> m_workers;
+        std::vector<std::thread> m_threads;
+        std::unordered_map<const void*, Strand> m_strands;
+        mutable std::mutex m_mx;
+        std::condition_variable m_work;
+        std::condition_variable m_space;
+        std::condition_variable m_idle;
+
+        /// @brief Notified when a strand has no jobs left
+        std::condition_variable m_drained;
+        const size_t m_capacity;
+        std::atomic<size_t> m_queued { 0 };
+        std::atomic<size_t> m_sleeping { 0 };
+        std::atomic<size_t> m_next { 0 };
+        std::atomic<uint64_t> m_stolen { 0 };
+        bool m_stop = false;
+        ExecutorStats m_stats;
+    };
+} // namespace hermes
+
+#endif // HAS_STD_THREAD_H
+
+#endif // HM_WORK_STEALING_POOL_H
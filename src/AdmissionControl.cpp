@@ -0,0 +1,147 @@
+/**
+ * Hermes - A RPC for IOT
+ * Copyright (C) 2023  Eduard Sargsyan and Andrey Ovodov
+ * 
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ * 
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ * 
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#include <hermes/AdmissionControl.h>
+
+#include <algorithm>
+
+using namespace hermes;
+
+namespace
+{
+    template<class Entry>
+    void expire(std::vector<Entry>& entries, uint32_t now)
+    {
+        entries.erase(std::remove_if(entries.begin(), entries.end(),
+                                     [now](const Entry& e) { return int32_t(now - e.expires) >= 0; }),
+                      entries.end());
+    }
+
+    template<class Entry>
+    Entry* find(std::vector<Entry>& entries, const serial_t& serial)
+    {
+        for (auto& e : entries) {
+            if (e.serial == serial)
+                return &e;
+        }
+        return nullptr;
+    }
+
+    template<class Entry>
+    void forget(std::vector<Entry>& entries, const serial_t& serial)
+    {
+        entries.erase(std::remove_if(entries.begin(), entries.end(),
+                                     [&serial](const Entry& e) { return e.serial == serial; }),
+                      entries.end());
+    }
+} // namespace
+
+AdmissionControl::AdmissionControl(const AdmissionLimits& limits)
+{
+    setLimits(limits);
+}
+
+void AdmissionControl::setLimits(const AdmissionLimits& limits)
+{
+    #ifdef HAS_STD_MUTEX
+    std::lock_guard<std::mutex> lock(m_mx);
+    #endif // HAS_STD_MUTEX
+    m_limits = limits;
+    if (m_limits.burst == 0)
+        m_limits.burst = 1;
+    m_tokens = m_limits.burst * 1000U;
+    m_started = false;
+}
+
+bool AdmissionControl::admit(uint32_t now, const serial_t& serial, uint16_t& retryAfterMs)
+{
+    #ifdef HAS_STD_MUTEX
+    std::lock_guard<std::mutex> lock(m_mx);
+    #endif // HAS_STD_MUTEX
+    refill(now);
+    expire(m_pending, now);
+    expire(m_deferred, now);
+
+    // Slave handshaking again before it was done keeps its place
+    Entry* pending = find(m_pending, serial);
+    const size_t others = m_pending.size() - (pending != nullptr ? 1 : 0);
+    const bool busy = m_limits.maxConcurrent > 0 && others >= m_limits.maxConcurrent;
+    const bool limited = m_limits.rate > 0 && m_tokens < 1000;
+    if (busy || limited) {
+        Entry* deferred = find(m_deferred, serial);
+        if (deferred == nullptr) {
+            m_deferred.push_back({ serial, now });
+            deferred = &m_deferred.back();
+        }
+        retryAfterMs = backoff();
+
+        // Slaves retry after half to full backoff, give them one more slot
+        deferred->expires = now + retryAfterMs + m_limits.retryAfterMs;
+        ++m_stats.deferred;
+        return false;
+    }
+
+    if (m_limits.rate > 0)
+        m_tokens -= 1000;
+    forget(m_deferred, serial);
+    if (pending == nullptr) {
+        m_pending.push_back({ serial, now });
+        pending = &m_pending.back();
+    }
+    pending->expires = now + HERMES_ADMISSION_TIMEOUT_MS;
+    ++m_stats.admitted;
+    if (m_pending.size() > m_stats.peakConcurrent)
+        m_stats.peakConcurrent = static_cast<uint16_t>(m_pending.size());
+    return true;
+}
+
+void AdmissionControl::done(const serial_t& serial)
+{
+    #ifdef HAS_STD_MUTEX
+    std::lock_guard<std::mutex> lock(m_mx);
+    #endif // HAS_STD_MUTEX
+    forget(m_pending, serial);
+}
+
+void AdmissionControl::refill(uint32_t now)
+{
+    if (!m_started) {
+        m_started = true;
+        m_lastRefill = now;
+        return;
+    }
+
+    // Rate is in handshakes per second, so it is thousandths per millisecond
+    const uint32_t cap = m_limits.burst * 1000U;
+    const uint64_t tokens = m_tokens + uint64_t(now - m_lastRefill) * m_limits.rate;
+    m_tokens = tokens > cap ? cap : static_cast<uint32_t>(tokens);
+    m_lastRefill = now;
+}
+
+uint16_t AdmissionControl::backoff() const
+{
+    // Time to serve everybody already waiting, spread over that time by
+    // slave side jitter. The slave asking is in m_deferred already.
+    const uint64_t backlog = m_deferred.size() - 1;
+    uint64_t ms = m_limits.retryAfterMs;
+    if (m_limits.rate > 0)
+        ms += (backlog * 1000 + (m_tokens < 1000 ? 1000 - m_tokens : 0)) / m_limits.rate;
+    else if (m_limits.maxConcurrent > 0)
+        ms += uint64_t(m_limits.retryAfterMs) * backlog / m_limits.maxConcurrent;
+    return static_cast<uint16_t>(ms > 0xFFFF ? 0xFFFF : ms);
+}
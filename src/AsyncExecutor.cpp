@@ -0,0 +1,239 @@
+/**
+ * Hermes - A RPC for IOT
+ * Copyright (C) 2023  Eduard Sargsyan and Andrey Ovodov
+ * 
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ * 
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ * 
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#include <hermes/AsyncExecutor.h>
+
+#ifdef HM_HAS_COROUTINES
+
+#ifdef HAS_LINUX_HEADERS
+#include <errno.h>
+#include <fcntl.h>
+#include <unistd.h>
+#endif // HAS_LINUX_HEADERS
+
+using namespace hermes;
+
+AsyncExecutor::AsyncExecutor(unsigned threads)
+{
+    #ifdef HAS_LINUX_HEADERS
+    if (::pipe2(m_wake, O_NONBLOCK | O_CLOEXEC) != 0) {
+        HM_WARN("Failed to create wake pipe, polling waiters");
+        m_wake[0] = m_wake[1] = -1;
+    }
+    #endif // HAS_LINUX_HEADERS
+
+    if (threads == 0)
+        threads = 1;
+    for (unsigned i = 0; i < threads; ++i)
+        m_threads.emplace_back(&AsyncExecutor::worker, this);
+}
+
+AsyncExecutor::~AsyncExecutor()
+{
+    stop();
+    #ifdef HAS_LINUX_HEADERS
+    if (m_wake[0] >= 0) {
+        ::close(m_wake[0]);
+        ::close(m_wake[1]);
+    }
+    #endif // HAS_LINUX_HEADERS
+}
+
+void AsyncExecutor::spawn(Task<void> task)
+{
+    {
+        std::lock_guard<std::mutex> lock(m_mx);
+        ++m_tasks;
+    }
+    schedule(run(std::move(task), this).handle);
+}
+
+void AsyncExecutor::schedule(std::coroutine_handle<> h)
+{
+    {
+        std::lock_guard<std::mutex> lock(m_mx);
+        m_ready.push_back(h);
+    }
+    m_cv.notify_one();
+}
+
+void AsyncExecutor::wait()
+{
+    std::unique_lock<std::mutex> lock(m_mx);
+    m_done.wait(lock, [this]() { return m_tasks == 0; });
+}
+
+void AsyncExecutor::stop()
+{
+    {
+        std::lock_guard<std::mutex> lock(m_mx);
+        m_stop = true;
+        wakePoller();
+    }
+    m_cv.notify_all();
+    for (auto& t : m_threads) {
+        if (t.joinable())
+            t.join();
+    }
+    m_threads.clear();
+}
+
+void AsyncExecutor::watch(IO* io, buffer_length_t length, std::coroutine_handle<> h)
+{
+    const auto deadline = std::chrono::steady_clock::now() + std::chrono::milliseconds(HERMES_ASYNC_TIMEOUT_MS);
+    {
+        std::lock_guard<std::mutex> lock(m_mx);
+        m_waiters.push_back({ io, length, deadline, h });
+        wakePoller();
+    }
+    m_cv.notify_one();
+}
+
+void AsyncExecutor::worker()
+{
+    std::unique_lock<std::mutex> lock(m_mx);
+    while (!m_stop) {
+        if (!m_ready.empty()) {
+            std::coroutine_handle<> h = m_ready.front();
+            m_ready.pop_front();
+            lock.unlock();
+            h.resume();
+            lock.lock();
+            continue;
+        }
+
+        // One thread checks parked coroutines, others sleep until work comes
+        if (!m_waiters.empty() && !m_polling) {
+            m_polling = true;
+            if (pollWaiters()) {
+                m_tick = HERMES_ASYNC_TICK_MS;
+                m_partial = false;
+            } else {
+                sleepWaiters(lock);
+            }
+            m_polling = false;
+            continue;
+        }
+
+        m_cv.wait(lock);
+    }
+}
+
+bool AsyncExecutor::pollWaiters()
+{
+    const auto now = std::chrono::steady_clock::now();
+    size_t woke = 0;
+    for (size_t i = 0; i < m_waiters.size();) {
+        const Waiter& w = m_waiters[i];
+        if (!w.io->good() || w.io->available() >= w.length || now >= w.deadline) {
+            m_ready.push_back(w.handle);
+            m_waiters[i] = m_waiters.back();
+            m_waiters.pop_back();
+            ++woke;
+        } else {
+            ++i;
+        }
+    }
+
+    if (woke > 1)
+        m_cv.notify_all();
+    return woke > 0;
+}
+
+void AsyncExecutor::sleepWaiters(std::unique_lock<std::mutex>& lock)
+{
+    using namespace std::chrono;
+
+    // Readable data was not a whole frame, wait for the rest instead of
+    // spinning on a descriptor which stays readable
+    const bool partial = m_partial;
+    m_partial = false;
+
+    auto wake = steady_clock::now() + milliseconds(partial ? HERMES_ASYNC_TICK_MS : HERMES_ASYNC_TIMEOUT_MS);
+    bool unwatched = partial;
+    #ifdef HAS_LINUX_HEADERS
+    m_fds.clear();
+    if (m_wake[0] >= 0)
+        m_fds.push_back({ m_wake[0], POLLIN, 0 });
+    #endif // HAS_LINUX_HEADERS
+    for (const Waiter& w : m_waiters) {
+        if (w.deadline < wake)
+            wake = w.deadline;
+        #ifdef HAS_LINUX_HEADERS
+        const int fd = w.io->descriptor();
+        if (fd >= 0 && m_wake[0] >= 0 && !partial) {
+            m_fds.push_back({ fd, POLLIN, 0 });
+            continue;
+        }
+        #endif // HAS_LINUX_HEADERS
+        unwatched = true;
+    }
+
+    // IOs without descriptor are checked with a growing tick
+    if (unwatched) {
+        if (steady_clock::now() + milliseconds(m_tick) < wake)
+            wake = steady_clock::now() + milliseconds(m_tick);
+        if (!partial && m_tick < HERMES_ASYNC_MAX_TICK_MS)
+            m_tick *= 2;
+    }
+
+    #ifdef HAS_LINUX_HEADERS
+    if (m_wake[0] >= 0) {
+        const auto left = duration_cast<milliseconds>(wake - steady_clock::now()).count() + 1;
+        lock.unlock();
+        const int ready = ::poll(m_fds.data(), m_fds.size(), left > 0 ? static_cast<int>(left) : 0);
+        lock.lock();
+
+        byte_t drop[16];
+        if (ready > 0 && m_fds[0].revents != 0) {
+            while (::read(m_wake[0], drop, sizeof(drop)) > 0) {}
+        }
+        for (size_t i = 1; ready > 0 && i < m_fds.size(); ++i) {
+            if (m_fds[i].revents != 0)
+                m_partial = true;
+        }
+        return;
+    }
+    #endif // HAS_LINUX_HEADERS
+
+    m_cv.wait_until(lock, wake);
+}
+
+void AsyncExecutor::wakePoller()
+{
+    #ifdef HAS_LINUX_HEADERS
+    const byte_t one = 1;
+    if (m_polling && m_wake[1] >= 0 && ::write(m_wake[1], &one, 1) < 0 && errno != EAGAIN)
+        HM_WARN("Failed to wake poller");
+    #endif // HAS_LINUX_HEADERS
+}
+
+detail::SpawnedTask AsyncExecutor::run(Task<void> task, AsyncExecutor* executor)
+{
+    co_await task;
+    executor->finished();
+}
+
+void AsyncExecutor::finished()
+{
+    std::lock_guard<std::mutex> lock(m_mx);
+    if (--m_tasks == 0)
+        m_done.notify_all();
+}
+
+#endif // HM_HAS_COROUTINES
@@ -0,0 +1,209 @@
+/**
+ * Hermes - A RPC for IOT
+ * Copyright (C) 2023  Eduard Sargsyan and Andrey Ovodov
+ * 
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ * 
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ * 
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#include <hermes/AsyncSlaveDescriptor.h>
+
+#ifdef HM_HAS_COROUTINES
+
+#include <hermes/MessageBuilder.h>
+
+#include <chrono>
+
+using namespace hermes;
+
+namespace
+{
+    /**
+     * Clock of SlaveDescriptor's cache
+    */
+    uint32_t millis()
+    {
+        using namespace std::chrono;
+        return static_cast<uint32_t>(duration_cast<milliseconds>(steady_clock::now().time_since_epoch()).count());
+    }
+} // namespace
+
+AsyncSlaveDescriptor::AsyncSlaveDescriptor(AsyncExecutor& executor, IO* io, serial_t serial)
+    : m_executor(executor)
+    , m_schema(&m_ownSchema)
+    , m_io(io)
+    , m_serial(serial)
+{}
+
+AsyncSlaveDescriptor::AsyncSlaveDescriptor(AsyncExecutor& executor, SlaveDescriptor& slave)
+    : m_executor(executor)
+    , m_slave(&slave)
+    , m_schema(&slave.m_schema)
+    , m_io(slave.m_io)
+    , m_serial(slave.m_serial)
+    , m_token(slave.m_token)
+{}
+
+Task<uint8_t> AsyncSlaveDescriptor::propertiesCount()
+{
+    uint8_t count;
+    if (m_schema->count(count))
+        co_return count;
+
+    Message resp = co_await request(command(Command::GetPropertiesCount));
+    if (resp.type != MessageType::Command || resp.payload.command.command != Command::GetPropertiesCount)
+        co_return 0;
+
+    count = resp.payload.command.data.count;
+    m_schema->setCount(count);
+    learned();
+    co_return count;
+}
+
+Task<bool> AsyncSlaveDescriptor::propertyName(uint8_t index, char* name)
+{
+    if (m_schema->name(index, name) || (m_slave != nullptr && m_slave->m_cache.name(index, name)))
+        co_return true;
+
+    Message req = command(Command::GetPropertyName);
+    req.payload.command.data.index = index;
+    Message resp = co_await request(req);
+    if (resp.type != MessageType::Command || resp.payload.command.command != Command::GetPropertyName)
+        co_return false;
+
+    strcpy(name, resp.payload.command.data.string);
+    m_schema->setName(index, name);
+    if (m_slave != nullptr)
+        m_slave->m_cache.setName(index, name);
+    learned();
+    co_return true;
+}
+
+Task<std::string> AsyncSlaveDescriptor::propertyName(uint8_t index)
+{
+    char name[HERMES_PROPERTY_NAME_MAX_LENGTH];
+    std::string res;
+    if (co_await propertyName(index, name))
+        res = name;
+    co_return res;
+}
+
+Task<int8_t> AsyncSlaveDescriptor::propertyIndex(const char* name)
+{
+    char tmpName[HERMES_PROPERTY_NAME_MAX_LENGTH];
+    const uint8_t count = co_await propertiesCount();
+    for (uint8_t i = 0; i < count; ++i) {
+        if (!co_await propertyName(i, tmpName))
+            continue;
+
+        if (strcmp(name, tmpName) == 0)
+            co_return static_cast<int8_t>(i);
+    }
+    co_return -1;
+}
+
+Task<bool> AsyncSlaveDescriptor::set(uint8_t property, const ValueData& value)
+{
+    Message req = command(Command::Set);
+    req.payload.command.data.value = value;
+    if (!co_await propertyName(property, req.payload.command.data.set.name))
+        co_return false;
+
+    const uint32_t now = millis();
+    Message resp = co_await request(req);
+    const bool ok = resp.type == MessageType::Command && resp.payload.command.command == Command::Set;
+    if (m_slave != nullptr) {
+        if (!ok) {
+            m_slave->m_cache.invalidate(property);
+        } else {
+            m_slave->m_cache.store(property, now, resp.payload.command.data.value);
+            m_slave->record(property, resp.payload.command.data.value);
+        }
+    }
+    co_return ok;
+}
+
+Task<bool> AsyncSlaveDescriptor::get(uint8_t property, ValueData& value)
+{
+    const uint32_t now = millis();
+    if (m_slave != nullptr && m_slave->m_cache.lookup(property, now, value))
+        co_return true;
+
+    Message req = command(Command::Get);
+    if (!co_await propertyName(property, req.payload.command.data.get.name))
+        co_return false;
+
+    Message resp = co_await request(req);
+    if (resp.type != MessageType::Command || resp.payload.command.command != Command::Get)
+        co_return false;
+
+    value = resp.payload.command.data.value;
+    if (m_slave != nullptr) {
+        m_slave->m_cache.store(property, now, value);
+        m_slave->record(property, value);
+    }
+    ValueType known;
+    if (!m_schema->type(property, known)) {
+        m_schema->setType(property, value.type);
+        learned();
+    }
+    co_return true;
+}
+
+void AsyncSlaveDescriptor::learned()
+{
+    if (m_slave != nullptr)
+        m_slave->learned();
+}
+
+Message AsyncSlaveDescriptor::command(Command cmd) const
+{
+    Message req;
+    memset(&req, 0, sizeof(req));
+    MessageBuilder::setSerial(req, m_serial.data);
+    MessageBuilder::setToken(req, m_token.data);
+    req.type = MessageType::Command;
+    req.payload.command.command = cmd;
+    req.payloadLength = sizeof(CommandData);
+    return req;
+}
+
+Task<Message> AsyncSlaveDescriptor::request(Message req)
+{
+    Message resp;
+    memset(&resp, 0, sizeof(resp));
+    MessageBuilder::setError(resp, ErrorType::Fail, "Request failed");
+
+    if (!m_io->write(req)) {
+        HM_ERR("Sending request %s to client failed", mt2str(req.type));
+        co_return resp;
+    }
+
+    for (;;) {
+        if (!co_await m_executor.readable(m_io, sizeof(Message)) || !m_io->read(resp)) {
+            HM_ERR("Failed to get response for request %s", mt2str(req.type));
+            MessageBuilder::setError(resp, ErrorType::Fail, "Request failed");
+            co_return resp;
+        }
+
+        if (resp.type != MessageType::Command || resp.payload.command.command != Command::Update)
+            co_return resp;
+
+        if (m_slave != nullptr)
+            m_slave->handle(resp);
+        else
+            HM_DBG("Skipping update while waiting for response");
+    }
+}
+
+#endif // HM_HAS_COROUTINES
@@ -0,0 +1,213 @@
+/**
+ * Hermes - A RPC for IOT
+ * Copyright (C) 2023  Eduard Sargsyan and Andrey Ovodov
+ * 
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ * 
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ * 
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#include <hermes/CompressedIO.h>
+
+#include <string.h>
+#include <algorithm>
+
+using namespace hermes;
+
+CompressedIO::CompressedIO(IO* io, Codec codec, uint16_t threshold)
+    : m_io(io)
+    , m_supported(codec)
+    , m_threshold(threshold)
+{
+}
+
+void CompressedIO::offer(HandshakePayload& handshake) const
+{
+    m_io->offer(handshake);
+    if (m_supported == Codec::None)
+        return;
+
+    handshake.capabilities |= CapCompression;
+    handshake.codec = m_supported;
+}
+
+bool CompressedIO::negotiate(const HandshakePayload& handshake)
+{
+    if (!m_io->negotiate(handshake))
+        return false;
+
+    // Older masters echo the offer back, codec in it is not agreed
+    const Codec codec = settled(handshake) && (handshake.capabilities & CapCompression)
+                        ? handshake.codec
+                        : Codec::None;
+    if (codec != Codec::None && codec != m_supported)
+        return false;
+
+    m_codec = codec;
+    m_inPos = sizeof(Message);
+    m_outPos = 0;
+    m_hasHeader = false;
+    return true;
+}
+
+void CompressedIO::flush()
+{
+    m_inPos = sizeof(Message);
+    m_outPos = 0;
+    m_hasHeader = false;
+    m_io->flush();
+}
+
+buffer_length_t CompressedIO::available() const
+{
+    if (m_codec == Codec::None)
+        return m_io->available();
+
+    // Header tells if the body of the next message is here already. It is
+    // kept until receive() reads the body.
+    if (!m_hasHeader && m_io->available() >= sizeof(CompressedHeader))
+        m_hasHeader = m_io->read(m_header);
+
+    size_t bytes = pending();
+    if (m_hasHeader) {
+        // Bad length is reported by read()
+        const size_t length = bodyLength(m_header);
+        if (length == 0 || length > MaxBodyLength || m_io->available() >= length)
+            bytes += sizeof(Message);
+    }
+    return static_cast<buffer_length_t>(bytes > 0xFFFF ? 0xFFFF : bytes);
+}
+
+buffer_length_t CompressedIO::wait(buffer_length_t length)
+{
+    if (m_codec == Codec::None)
+        return m_io->wait(length);
+
+    if (pending() < length && pending() == 0)
+        receive();
+    return available();
+}
+
+buffer_length_t CompressedIO::write(const byte_t* buf, buffer_length_t length)
+{
+    if (m_codec == Codec::None)
+        return m_io->write(buf, length);
+
+    buffer_length_t done = 0;
+    while (done < length) {
+        const size_t n = std::min<size_t>(length - done, sizeof(Message) - m_outPos);
+        memcpy(reinterpret_cast<byte_t*>(&m_out) + m_outPos, buf + done, n);
+        m_outPos += n;
+        done += n;
+        if (m_outPos == sizeof(Message)) {
+            m_outPos = 0;
+            if (!send())
+                return 0;
+        }
+    }
+    return done;
+}
+
+buffer_length_t CompressedIO::read(byte_t* buf, buffer_length_t length)
+{
+    if (m_codec == Codec::None)
+        return m_io->read(buf, length);
+
+    buffer_length_t done = 0;
+    while (done < length) {
+        if (pending() == 0 && !receive())
+            break;
+        const size_t n = std::min<size_t>(length - done, pending());
+        memcpy(buf + done, reinterpret_cast<const byte_t*>(&m_in) + m_inPos, n);
+        m_inPos += n;
+        done += n;
+    }
+    return done;
+}
+
+bool CompressedIO::send()
+{
+    CompressedHeader* header = reinterpret_cast<CompressedHeader*>(m_buffer);
+    byte_t* body = m_buffer + sizeof(CompressedHeader);
+    const byte_t* raw = reinterpret_cast<const byte_t*>(&m_out);
+
+    // Only worth it if the result is shorter than the message itself
+    size_t length = 0;
+    if (m_out.payloadLength >= m_threshold)
+        length = lzCompress(raw, sizeof(Message), body, sizeof(Message) - 1);
+
+    if (length > 0) {
+        header->codec = m_codec;
+        ++m_stats.compressed;
+    } else {
+        header->codec = Codec::None;
+        length = sizeof(Message);
+        memcpy(body, raw, length);
+    }
+    header->length[0] = length & 0xFF;
+    header->length[1] = (length >> 8) & 0xFF;
+
+    const buffer_length_t total = static_cast<buffer_length_t>(sizeof(CompressedHeader) + length);
+    if (m_io->write(m_buffer, total) != total)
+        return false;
+
+    ++m_stats.messagesSent;
+    m_stats.bytesIn += sizeof(Message);
+    m_stats.bytesOut += total;
+    return true;
+}
+
+bool CompressedIO::receive()
+{
+    if (!m_hasHeader && !m_io->read(m_header))
+        return false;
+    m_hasHeader = false;
+
+    const CompressedHeader header = m_header;
+    const size_t length = bodyLength(header);
+    if (length == 0 || length > MaxBodyLength) {
+        HM_ERR("Bad compressed message length %d", (int) length);
+        ++m_stats.errors;
+        return false;
+    }
+
+    byte_t* body = m_buffer + sizeof(CompressedHeader);
+    if (m_io->read(body, static_cast<buffer_length_t>(length)) != length)
+        return false;
+
+    byte_t* raw = reinterpret_cast<byte_t*>(&m_in);
+    size_t decoded = 0;
+    switch (header.codec) {
+    case Codec::None: {
+        if (length == sizeof(Message)) {
+            memcpy(raw, body, length);
+            decoded = length;
+        }
+        break;
+    }
+    case Codec::Lz: {
+        decoded = lzDecompress(body, length, raw, sizeof(Message));
+        break;
+    }
+    default: break;
+    }
+
+    if (decoded != sizeof(Message)) {
+        HM_ERR("Failed to decode compressed message");
+        ++m_stats.errors;
+        return false;
+    }
+
+    ++m_stats.messagesReceived;
+    m_inPos = 0;
+    return true;
+}
@@ -0,0 +1,182 @@
+/**
+ * Hermes - A RPC for IOT
+ * Copyright (C) 2023  Eduard Sargsyan and Andrey Ovodov
+ * 
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ * 
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ * 
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#include <hermes/Compression.h>
+
+#include <string.h>
+
+using namespace hermes;
+
+namespace
+{
+    constexpr size_t MinMatch = 4;
+    constexpr int HashBits = 8;
+
+    inline uint32_t read32(const byte_t* p)
+    {
+        uint32_t v;
+        memcpy(&v, p, sizeof(v));
+        return v;
+    }
+
+    inline uint32_t hash(const byte_t* p)
+    {
+        return (read32(p) * 2654435761U) >> (32 - HashBits);
+    }
+
+    /**
+     * Writes sequence fields, fails once output is full.
+    */
+    struct Writer
+    {
+        byte_t* p;
+        byte_t* end;
+
+        inline bool put(byte_t b)
+        {
+            if (p == end)
+                return false;
+            *p++ = b;
+            return true;
+        }
+
+        /**
+         * Rest of a length which did not fit into its token nibble.
+        */
+        inline bool putLength(size_t length)
+        {
+            for (; length >= 255; length -= 255) {
+                if (!put(255))
+                    return false;
+            }
+            return put(static_cast<byte_t>(length));
+        }
+
+        bool sequence(const byte_t* literals, size_t count, size_t offset, size_t match)
+        {
+            const size_t matchCode = match > 0 ? match - MinMatch : 0;
+            const byte_t token = static_cast<byte_t>(((count < 15 ? count : 15) << 4) | (matchCode < 15 ? matchCode : 15));
+            if (!put(token))
+                return false;
+            if (count >= 15 && !putLength(count - 15))
+                return false;
+            if (size_t(end - p) < count)
+                return false;
+            memcpy(p, literals, count);
+            p += count;
+            if (match == 0)
+                return true;
+            if (!put(offset & 0xFF) || !put(offset >> 8))
+                return false;
+            return matchCode < 15 || putLength(matchCode - 15);
+        }
+    };
+
+    /**
+     * Reads a length continued after its token nibble.
+    */
+    inline bool getLength(const byte_t*& p, const byte_t* end, size_t& length)
+    {
+        byte_t b;
+        do {
+            if (p == end)
+                return false;
+            b = *p++;
+            length += b;
+        } while (b == 255);
+        return true;
+    }
+} // namespace
+
+size_t hermes::lzCompress(const byte_t* src, size_t length, byte_t* dst, size_t capacity)
+{
+    if (length > 0xFFFF)
+        return 0;
+
+    // Positions are kept + 1, so zero means empty
+    uint16_t table[1 << HashBits];
+    memset(table, 0, sizeof(table));
+
+    Writer out { dst, dst + capacity };
+    size_t anchor = 0;
+    size_t pos = 0;
+    while (pos + MinMatch <= length) {
+        const uint32_t h = hash(src + pos);
+        const size_t ref = table[h];
+        table[h] = static_cast<uint16_t>(pos + 1);
+        if (ref == 0 || read32(src + ref - 1) != read32(src + pos)) {
+            ++pos;
+            continue;
+        }
+
+        // Match may overlap current position, e.g. a run of zeros
+        const size_t from = ref - 1;
+        size_t match = MinMatch;
+        while (pos + match < length && src[from + match] == src[pos + match])
+            ++match;
+
+        if (!out.sequence(src + anchor, pos - anchor, pos - from, match))
+            return 0;
+        pos += match;
+        anchor = pos;
+    }
+
+    if (!out.sequence(src + anchor, length - anchor, 0, 0))
+        return 0;
+    return out.p - dst;
+}
+
+size_t hermes::lzDecompress(const byte_t* src, size_t length, byte_t* dst, size_t capacity)
+{
+    const byte_t* p = src;
+    const byte_t* end = src + length;
+    size_t done = 0;
+    while (p < end) {
+        const byte_t token = *p++;
+        size_t count = token >> 4;
+        if (count == 15 && !getLength(p, end, count))
+            return 0;
+        if (size_t(end - p) < count || capacity - done < count)
+            return 0;
+        memcpy(dst + done, p, count);
+        p += count;
+        done += count;
+
+        // Last sequence has literals only
+        if (p == end)
+            break;
+
+        if (end - p < 2)
+            return 0;
+        const size_t offset = p[0] | (p[1] << 8);
+        p += 2;
+        size_t match = token & 0x0F;
+        if (match == 15 && !getLength(p, end, match))
+            return 0;
+        match += MinMatch;
+        if (offset == 0 || offset > done || capacity - done < match)
+            return 0;
+
+        // Byte by byte, source and destination may overlap
+        const byte_t* from = dst + done - offset;
+        for (size_t i = 0; i < match; ++i)
+            dst[done + i] = from[i];
+        done += match;
+    }
+    return done;
+}
@@ -0,0 +1,141 @@
+/**
+ * Hermes - A RPC for IOT
+ * Copyright (C) 2023  Eduard Sargsyan and Andrey Ovodov
+ * 
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ * 
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ * 
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#include <hermes/Crc32c.h>
+
+#include <string.h>
+
+#if defined(__x86_64__) && (defined(__GNUC__) || defined(__clang__))
+#define HM_CRC32C_SSE42 1
+#include <nmmintrin.h>
+#elif defined(__ARM_FEATURE_CRC32)
+#define HM_CRC32C_ARMV8 1
+#include <arm_acle.h>
+#endif
+
+using namespace hermes;
+
+namespace
+{
+    // Reflected Castagnoli polynomial
+    constexpr uint32_t Poly = 0x82F63B78;
+
+    struct Tables
+    {
+        uint32_t t[8][256];
+    };
+
+    constexpr Tables makeTables()
+    {
+        Tables tables {};
+        for (uint32_t i = 0; i < 256; ++i) {
+            uint32_t crc = i;
+            for (int k = 0; k < 8; ++k)
+                crc = (crc >> 1) ^ ((crc & 1) ? Poly : 0);
+            tables.t[0][i] = crc;
+        }
+        for (uint32_t i = 0; i < 256; ++i) {
+            for (int s = 1; s < 8; ++s) {
+                const uint32_t prev = tables.t[s - 1][i];
+                tables.t[s][i] = (prev >> 8) ^ tables.t[0][prev & 0xFF];
+            }
+        }
+        return tables;
+    }
+
+    constexpr Tables s_tables = makeTables();
+
+    inline uint32_t load32(const byte_t* p)
+    {
+        uint32_t v;
+        memcpy(&v, p, sizeof(v));
+        return v;
+    }
+
+#ifdef HM_CRC32C_SSE42
+    __attribute__((target("sse4.2")))
+    uint32_t crc32cSse42(uint32_t crc, const byte_t* p, size_t length)
+    {
+        while (length >= sizeof(uint64_t)) {
+            uint64_t v;
+            memcpy(&v, p, sizeof(v));
+            crc = static_cast<uint32_t>(_mm_crc32_u64(crc, v));
+            p += sizeof(v);
+            length -= sizeof(v);
+        }
+        while (length--)
+            crc = _mm_crc32_u8(crc, *p++);
+        return crc;
+    }
+#endif // HM_CRC32C_SSE42
+
+#ifdef HM_CRC32C_ARMV8
+    uint32_t crc32cArmv8(uint32_t crc, const byte_t* p, size_t length)
+    {
+        while (length >= sizeof(uint64_t)) {
+            uint64_t v;
+            memcpy(&v, p, sizeof(v));
+            crc = __crc32cd(crc, v);
+            p += sizeof(v);
+            length -= sizeof(v);
+        }
+        while (length--)
+            crc = __crc32cb(crc, *p++);
+        return crc;
+    }
+#endif // HM_CRC32C_ARMV8
+} // namespace
+
+uint32_t hermes::crc32cPortable(const byte_t* p, size_t length, uint32_t crc)
+{
+    crc = ~crc;
+
+#if defined(__BYTE_ORDER__) && __BYTE_ORDER__ == __ORDER_LITTLE_ENDIAN__
+    while (length >= 8) {
+        const uint32_t one = load32(p) ^ crc;
+        const uint32_t two = load32(p + 4);
+        crc = s_tables.t[7][one & 0xFF]
+            ^ s_tables.t[6][(one >> 8) & 0xFF]
+            ^ s_tables.t[5][(one >> 16) & 0xFF]
+            ^ s_tables.t[4][one >> 24]
+            ^ s_tables.t[3][two & 0xFF]
+            ^ s_tables.t[2][(two >> 8) & 0xFF]
+            ^ s_tables.t[1][(two >> 16) & 0xFF]
+            ^ s_tables.t[0][two >> 24];
+        p += 8;
+        length -= 8;
+    }
+#endif // __ORDER_LITTLE_ENDIAN__
+
+    while (length--)
+        crc = s_tables.t[0][(crc ^ *p++) & 0xFF] ^ (crc >> 8);
+
+    return ~crc;
+}
+
+uint32_t hermes::crc32c(const byte_t* p, size_t length, uint32_t crc)
+{
+#if defined(HM_CRC32C_SSE42)
+    static const bool hw = __builtin_cpu_supports("sse4.2");
+    if (hw)
+        return ~crc32cSse42(~crc, p, length);
+#elif defined(HM_CRC32C_ARMV8)
+    return ~crc32cArmv8(~crc, p, length);
+#endif
+    return crc32cPortable(p, length, crc);
+}
@@ -20,8 +20,16 @@
 #include <hermes/DummySlave.h>
 #include <hermes/MessageBuilder.h>
 #include <hermes/IO.h>
+#include <hermes/Router.h>
+#include <hermes/SchemaHash.h>
 #include <hermes/Config.h>
 #include <string.h>
+#include <math.h>
+
+#ifdef HAS_STD_THREAD_H
+#include <thread>
+#include <chrono>
+#endif // HAS_STD_THREAD_H
 
 using namespace hermes;
 
@@ -30,32 +38,102 @@ DummySlave::DummySlave(IO* io, const byte_t* serial, const byte_t* token)
     , m_serial(serial)
     , m_token(token)
 {
+    // Slaves rebooted together must not retry in lockstep, so jitter
+    // depends on the serial.
+    m_seed = 2166136261U;
+    for (size_t i = 0; i < sizeof(m_serial.data); ++i)
+        m_seed = (m_seed ^ m_serial.data[i]) * 16777619U;
 }
 
 bool DummySlave::handshake()
 {
-    Message msg = MessageBuilder::handshake(m_serial.data, 1, 0, 0, m_token.data);
-    if (!m_io->write(msg)) {
-        return false;
-    }
+    Message msg = MessageBuilder::handshake(m_serial.data, MinimumApiVersion, CurrentApiVersion, m_token.data);
+    m_io->offer(msg.payload.handshake);
+    msg.payload.handshake.schemaHash = schemaHash();
 
     Message response;
-    if (!m_io->read(response)) {
+    if (!m_io->write(msg) || !m_io->read(response))
+        return false;
+
+    if (response.type != MessageType::Handshake)
+        return false;
+
+    const HandshakePayload& agreed = response.payload.handshake;
+    if (agreed.result == HandshakeResult::RetryLater) {
+        const uint32_t wait = backoff(agreed.retryAfterMs);
+        HM_INFO("Master is busy, retry handshake in %u ms", (unsigned) wait);
+        delay(wait);
         return false;
     }
 
-    if (response.type == MessageType::Handshake) {
-        m_token = response.token;
+    m_retries = 0;
+    if (agreed.result != HandshakeResult::Ok)
+        return false;
+
+    m_token = response.token;
+
+    // Masters which do not know capabilities echo the offer back
+    // instead of settling on one version.
+    if (!settled(agreed))
         return true;
+
+    return m_io->negotiate(agreed);
+}
+
+void DummySlave::setIO(IO* io)
+{
+    m_io = io;
+    m_subscriptionsCount = 0;
+}
+
+uint32_t DummySlave::schemaHash()
+{
+    const uint8_t count = propertiesCount();
+    SchemaHasher hasher(count);
+    char name[HERMES_PROPERTY_NAME_MAX_LENGTH];
+    for (uint8_t i = 0; i < count; ++i) {
+        if (!propertyName(i, name))
+            return 0;
+        hasher.add(name, propertyType(i));
     }
+    return hasher.value();
+}
 
-    return false;
+uint32_t DummySlave::backoff(uint16_t suggested)
+{
+    uint32_t wait = HERMES_HANDSHAKE_BACKOFF_MAX_MS;
+    if (m_retries < 16 && (uint32_t(HERMES_HANDSHAKE_BACKOFF_MS) << m_retries) < wait)
+        wait = uint32_t(HERMES_HANDSHAKE_BACKOFF_MS) << m_retries;
+    if (suggested > wait)
+        wait = suggested;
+    if (m_retries < 0xFF)
+        ++m_retries;
+
+    // xorshift32, wait a random time between half and full backoff
+    m_seed ^= millis();
+    m_seed ^= m_seed << 13;
+    m_seed ^= m_seed >> 17;
+    m_seed ^= m_seed << 5;
+    return wait / 2 + m_seed % (wait / 2 + 1);
 }
 
 void DummySlave::loop()
 {
     bool getResult = false;
     do {
+        if (m_subscriptionsCount > 0) {
+            const uint32_t now = millis();
+            if (int32_t(now - m_nextPublish) >= 0) {
+                publish();
+                m_io->drain();
+                m_nextPublish = now + HERMES_SUBSCRIPTION_TICK_MS;
+            }
+            if (m_io->available() < sizeof(Message)) {
+                idle(m_nextPublish - now);
+                getResult = m_io->good();
+                continue;
+            }
+        }
         getResult = processNextMessage();
     } while (getResult && m_io->good());
 }
@@ -65,7 +143,21 @@ bool DummySlave::processNextMessage()
     bool getResult = false;
     Message rcv;
     getResult = m_io->read(rcv);
-    Message rpl;
+    if (getResult && isGroupSerial(rcv.serial)) {
+        handleGroupRequest(rcv);
+        return getResult;
+    }
+    if (getResult && m_router != nullptr && m_serial != rcv.serial) {
+        if (!m_router->forward(rcv, m_io)) {
+            Message rpl{};
+            MessageBuilder::setSerial(rpl, rcv.serial);
+            MessageBuilder::setToken(rpl, rcv.token);
+            MessageBuilder::setError(rpl, ErrorType::Unsupported, "No route to slave");
+            m_io->write(rpl);
+        }
+        return getResult;
+    }
+    Message rpl{};
     if (dispatch(&rcv, &rpl)) {
         if (m_io->good())
             m_io->write(rpl);
@@ -75,6 +167,168 @@ bool DummySlave::processNextMessage()
     return getResult;
 }
 
+bool DummySlave::joinGroup(group_t group)
+{
+    if (inGroup(group))
+        return true;
+
+    if (m_groupsCount == HERMES_MAX_GROUPS) {
+        HM_ERR("Too many groups");
+        return false;
+    }
+    m_groups[m_groupsCount++] = group;
+    return true;
+}
+
+void DummySlave::leaveGroup(group_t group)
+{
+    for (uint8_t i = 0; i < m_groupsCount; ++i) {
+        if (m_groups[i] == group) {
+            m_groups[i] = m_groups[--m_groupsCount];
+            return;
+        }
+    }
+}
+
+bool DummySlave::inGroup(group_t group) const
+{
+    if (group == BroadcastGroup)
+        return true;
+
+    for (uint8_t i = 0; i < m_groupsCount; ++i) {
+        if (m_groups[i] == group)
+            return true;
+    }
+    return false;
+}
+
+bool DummySlave::handleGroupRequest(const Message& msg)
+{
+    const Command cmd = msg.payload.command.command;
+    if (msg.type != MessageType::Command || (cmd != Command::Set && cmd != Command::GroupSet)) {
+        HM_WARN("Only Set can be addressed to a group");
+        return false;
+    }
+
+    const bool acked = cmd == Command::GroupSet;
+    GroupAckData ack = { 0, 0 };
+    if (m_router != nullptr)
+        m_router->broadcast(msg, acked ? &ack : nullptr);
+
+    if (inGroup(serialGroup(msg.serial))) {
+        Message req = msg;
+        Message rpl{};
+        req.payload.command.command = Command::Set;
+        rpl.type = MessageType::Command;
+        handleCommandRequest(&req, &rpl);
+        if (rpl.type == MessageType::Error)
+            ++ack.failed;
+        else
+            ++ack.applied;
+    }
+
+    if (!acked)
+        return true;
+
+    Message rpl{};
+    MessageBuilder::setSerial(rpl, msg.serial);
+    MessageBuilder::setToken(rpl, m_token.data);
+    rpl.type = MessageType::Command;
+    rpl.payload.command.command = Command::GroupSet;
+    rpl.payload.command.data.ack = ack;
+    rpl.payloadLength = sizeof(CommandData);
+    return m_io->write(rpl);
+}
+
+namespace
+{
+    bool changed(const ValueData& last, const ValueData& current, float deadband)
+    {
+        switch (current.type) {
+        case ValueType::Boolean:
+            return last.value.B != current.value.B;
+        case ValueType::Integer:
+            return fabsf((float) current.value.I - (float) last.value.I) > deadband;
+        case ValueType::UnsignedInteger:
+            return fabsf((float) current.value.U - (float) last.value.U) > deadband;
+        case ValueType::Float:
+            if (current.value.F.Precision == 0 || last.value.F.Precision == 0)
+                return current.value.F.V != last.value.F.V || current.value.F.Precision != last.value.F.Precision;
+            return fabsf((float) current.value.F.V / current.value.F.Precision
+                         - (float) last.value.F.V / last.value.F.Precision) > deadband;
+        case ValueType::String:
+            return strncmp(last.value.S, current.value.S, sizeof(current.value.S)) != 0;
+        }
+        return true;
+    }
+} // namespace
+
+uint8_t DummySlave::publish()
+{
+    uint8_t sent = 0;
+    const uint32_t now = millis();
+    for (uint8_t i = 0; i < m_subscriptionsCount; ++i) {
+        Subscription& sub = m_subscriptions[i];
+        const uint32_t elapsed = now - sub.lastSent;
+        if (elapsed < sub.minInterval)
+            continue;
+
+        Message update{};
+        if (!readProperty(sub.property, update.payload.command.data.value))
+            continue;
+
+        const bool heartbeat = sub.maxInterval != 0 && elapsed >= sub.maxInterval;
+        if (!heartbeat && !changed(sub.last, update.payload.command.data.value, sub.deadband))
+            continue;
+
+        MessageBuilder::setSerial(update, m_serial.data);
+        MessageBuilder::setToken(update, m_token.data);
+        update.type = MessageType::Command;
+        update.payload.command.command = Command::Update;
+        update.payloadLength = sizeof(CommandData);
+        if (!m_io->write(update)) {
+            HM_WARN("Sending update failed");
+            break;
+        }
+        sub.last = update.payload.command.data.value;
+        sub.lastSent = now;
+        ++sent;
+    }
+    return sent;
+}
+
+bool DummySlave::readProperty(uint8_t index, ValueData& value)
+{
+    if (!propertyName(index, value.name))
+        return false;
+    value.type = propertyType(index);
+    return get(index, value);
+}
+
+uint32_t DummySlave::millis()
+{
+    #ifdef HAS_STD_THREAD_H
+    using namespace std::chrono;
+    return static_cast<uint32_t>(duration_cast<milliseconds>(steady_clock::now().time_since_epoch()).count());
+    #else
+    return 0;
+    #endif // HAS_STD_THREAD_H
+}
+
+void DummySlave::idle(uint32_t ms)
+{
+    // Wake up early for a request, it should not wait for the next publish
+    for (uint32_t waited = 0; waited < ms && m_io->available() < sizeof(Message); ++waited)
+        delay(1);
+}
+
+void DummySlave::delay(uint32_t ms)
+{
+    #ifdef HAS_STD_THREAD_H
+    std::this_thread::sleep_for(std::chrono::milliseconds(ms));
+    #endif // HAS_STD_THREAD_H
+}
+
 bool DummySlave::dispatch(Message* message, Message* response)
 {
     HM_DBG("Got request with type: %s", mt2str(message->type));
@@ -93,6 +347,7 @@ bool DummySlave::handleCommandRequest(Message* msg, Message* response)
     bool handled = true;
     MessageBuilder::setSerial(*response, m_serial.data);
     MessageBuilder::setToken(*response, m_token.data);
+    response->payloadLength = sizeof(CommandData);
 
     switch (msg->payload.command.command) {
     case Command::GetPropertiesCount: {
@@ -106,14 +361,12 @@ bool DummySlave::handleCommandRequest(Message* msg, Message* response)
         response->type = MessageType::Command;
         response->payload.command.command = Command::GetPropertyName;
 
-        char pname[HERMES_PROPERTY_NAME_MAX_LENGTH];
+        char pname[sizeof(response->payload.command.data.string)];
 
         if (propertyName(msg->payload.command.data.index, pname)) {
             size_t len = strlen(pname);
             memcpy(response->payload.command.data.string, pname, len);
-            memset(response->payload.command.data.string + len, '\0', HERMES_STRING_LENGTH - len);
-            memcpy(response->payload.command.data.value.name, pname, len);
-            memset(response->payload.command.data.value.name + len, '\0', HERMES_PROPERTY_NAME_MAX_LENGTH - len);
+            memset(response->payload.command.data.string + len, '\0', sizeof(pname) - len);
         }
         else {
             HM_ERR("Requested property name with bad index %d", (int)msg->payload.command.data.index);
@@ -143,6 +396,9 @@ bool DummySlave::handleCommandRequest(Message* msg, Message* response)
     }
 
     case Command::Set: {
+        response->type = MessageType::Command;
+        response->payload.command.command = Command::Set;
+
         const int8_t idx = propertyIndex(msg->payload.command.data.get.name);
         bool ok = idx < propertiesCount() && idx >= 0;
         if (ok) {
@@ -159,6 +415,81 @@ bool DummySlave::handleCommandRequest(Message* msg, Message* response)
         break;
     }
 
+    case Command::GetRoutesCount: {
+        response->type = MessageType::Command;
+        response->payload.command.command = Command::GetRoutesCount;
+        response->payload.command.data.count = m_router ? m_router->routesCount() : 0;
+        break;
+    }
+
+    case Command::GetRoute: {
+        const uint8_t idx = msg->payload.command.data.index;
+        if (m_router != nullptr && idx < m_router->routesCount()) {
+            const Route& route = m_router->route(idx);
+            response->type = MessageType::Command;
+            response->payload.command.command = Command::GetRoute;
+            memcpy(response->payload.command.data.route.serial, route.serial.data, sizeof(route.serial.data));
+            response->payload.command.data.route.hops = route.hops;
+        }
+        else {
+            MessageBuilder::setError(*response, ErrorType::Unsupported, "Bad route index");
+        }
+        break;
+    }
+
+    case Command::Subscribe: {
+        const SubscribeData& req = msg->payload.command.data.subscribe;
+        const int8_t idx = propertyIndex(req.name);
+        if (idx < 0 || idx >= propertiesCount()) {
+            MessageBuilder::setError(*response, ErrorType::Unsupported, "Property does not exists");
+            break;
+        }
+
+        Subscription* sub = nullptr;
+        for (uint8_t i = 0; i < m_subscriptionsCount; ++i) {
+            if (m_subscriptions[i].property == idx)
+                sub = &m_subscriptions[i];
+        }
+        if (sub == nullptr && m_subscriptionsCount < HERMES_MAX_SUBSCRIPTIONS)
+            sub = &m_subscriptions[m_subscriptionsCount++];
+        if (sub == nullptr) {
+            MessageBuilder::setError(*response, ErrorType::Unsupported, "Too many subscriptions");
+            break;
+        }
+
+        sub->property = idx;
+        sub->deadband = req.deadband.Precision ? (float) req.deadband.V / req.deadband.Precision : 0.0f;
+        sub->minInterval = req.minInterval;
+        sub->maxInterval = req.maxInterval;
+        sub->lastSent = millis();
+
+        // Current value goes with the response, updates are relative to it
+        response->type = MessageType::Command;
+        response->payload.command.command = Command::Subscribe;
+        readProperty(idx, response->payload.command.data.value);
+        sub->last = response->payload.command.data.value;
+        break;
+    }
+
+    case Command::Unsubscribe: {
+        const int8_t idx = propertyIndex(msg->payload.command.data.subscribe.name);
+        bool found = false;
+        for (uint8_t i = 0; idx >= 0 && i < m_subscriptionsCount; ++i) {
+            if (m_subscriptions[i].property == idx) {
+                m_subscriptions[i] = m_subscriptions[--m_subscriptionsCount];
+                found = true;
+                break;
+            }
+        }
+        if (!found) {
+            MessageBuilder::setError(*response, ErrorType::Unsupported, "Property is not subscribed");
+            break;
+        }
+        response->type = MessageType::Command;
+        response->payload.command.command = Command::Unsubscribe;
+        break;
+    }
+
     case Command::Disconnect: {
         m_io->close();
         return true;
@@ -0,0 +1,244 @@
+/**
+ * Hermes - A RPC for IOT
+ * Copyright (C) 2023  Eduard Sargsyan and Andrey Ovodov
+ * 
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ * 
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ * 
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#include <hermes/FramedIO.h>
+#include <hermes/Crc32c.h>
+
+#include <string.h>
+
+using namespace hermes;
+
+namespace
+{
+    inline void put16le(byte_t* p, uint16_t v)
+    {
+        p[0] = v & 0xFF;
+        p[1] = (v >> 8) & 0xFF;
+    }
+
+    inline uint16_t get16le(const byte_t* p)
+    {
+        return p[0] | (p[1] << 8);
+    }
+
+    inline void put32le(byte_t* p, uint32_t v)
+    {
+        put16le(p, v & 0xFFFF);
+        put16le(p + 2, v >> 16);
+    }
+
+    inline uint32_t get32le(const byte_t* p)
+    {
+        return get16le(p) | (uint32_t(get16le(p + 2)) << 16);
+    }
+} // namespace
+
+constexpr byte_t FramedIO::FrameStart[2];
+
+FramedIO::FramedIO(IO* io, bool negotiated)
+    : m_io(io)
+    , m_negotiated(negotiated)
+    , m_enabled(!negotiated)
+{
+}
+
+void FramedIO::offer(HandshakePayload& handshake) const
+{
+    m_io->offer(handshake);
+    handshake.capabilities |= CapFraming | CapCrc;
+    if (handshake.maxFrameLength == 0 || handshake.maxFrameLength > MaxBodyLength)
+        handshake.maxFrameLength = MaxBodyLength;
+}
+
+bool FramedIO::negotiate(const HandshakePayload& handshake)
+{
+    if (!m_io->negotiate(handshake))
+        return false;
+
+    const bool agreed = (handshake.capabilities & (CapFraming | CapCrc)) == (CapFraming | CapCrc);
+    if (m_negotiated)
+        m_enabled = agreed;
+    if (agreed && handshake.maxFrameLength > 0)
+        m_maxBody = handshake.maxFrameLength < MaxBodyLength ? handshake.maxFrameLength : MaxBodyLength;
+    return true;
+}
+
+void FramedIO::flush()
+{
+    m_rxLen = 0;
+    m_bodyLen = m_bodyPos = 0;
+    m_io->flush();
+}
+
+buffer_length_t FramedIO::available() const
+{
+    if (!m_enabled)
+        return m_io->available();
+
+    // Header overhead of frames still in the stream is not known, so this is
+    // an upper estimate. read() blocks until data really arrives.
+    const size_t raw = m_rxLen + m_io->available();
+    const size_t bytes = pending() + (raw > sizeof(FrameHeader) ? raw - sizeof(FrameHeader) : 0);
+    return static_cast<buffer_length_t>(bytes > 0xFFFF ? 0xFFFF : bytes);
+}
+
+buffer_length_t FramedIO::wait(buffer_length_t length)
+{
+    if (!m_enabled)
+        return m_io->wait(length);
+
+    if (pending() < length && pending() == 0)
+        receive();
+    return available();
+}
+
+buffer_length_t FramedIO::write(const byte_t* buf, buffer_length_t length)
+{
+    if (!m_enabled)
+        return m_io->write(buf, length);
+
+    FrameHeader* header = reinterpret_cast<FrameHeader*>(m_tx);
+    buffer_length_t done = 0;
+    while (done < length) {
+        buffer_length_t n = length - done;
+        if (n > m_maxBody)
+            n = m_maxBody;
+
+        header->sof[0] = FrameStart[0];
+        header->sof[1] = FrameStart[1];
+        put16le(header->length, n);
+        memcpy(m_tx + sizeof(FrameHeader), buf + done, n);
+        put32le(header->crc, crc32c(header->length, sizeof(header->length) + n));
+
+        const buffer_length_t frameLength = sizeof(FrameHeader) + n;
+        if (m_io->write(m_tx, frameLength) != frameLength)
+            return done;
+        ++m_stats.framesSent;
+        done += n;
+    }
+    return done;
+}
+
+buffer_length_t FramedIO::read(byte_t* buf, buffer_length_t length)
+{
+    if (!m_enabled)
+        return m_io->read(buf, length);
+
+    buffer_length_t done = 0;
+    while (done < length) {
+        if (pending() == 0 && !receive())
+            break;
+        buffer_length_t n = length - done;
+        if (n > pending())
+            n = pending();
+        memcpy(buf + done, m_body + m_bodyPos, n);
+        m_bodyPos += n;
+        done += n;
+    }
+    return done;
+}
+
+bool FramedIO::receive()
+{
+    for (;;) {
+        // Skip everything before the next start of frame. A lone first
+        // marker byte at the end may be the beginning of a frame.
+        buffer_length_t start = 0;
+        while (start < m_rxLen) {
+            const byte_t* p = static_cast<const byte_t*>(memchr(m_rx + start, FrameStart[0], m_rxLen - start));
+            if (p == nullptr) {
+                start = m_rxLen;
+                break;
+            }
+            start = p - m_rx;
+            if (start + 1 == m_rxLen || m_rx[start + 1] == FrameStart[1])
+                break;
+            ++start;
+        }
+        if (start > 0) {
+            m_stats.bytesSkipped += start;
+            m_synced = false;
+            discard(start);
+        }
+
+        if (m_rxLen < sizeof(FrameHeader)) {
+            if (!fill(sizeof(FrameHeader)))
+                return false;
+            continue;
+        }
+
+        const FrameHeader* header = reinterpret_cast<const FrameHeader*>(m_rx);
+        const buffer_length_t length = get16le(header->length);
+        if (length == 0 || length > MaxBodyLength) {
+            HM_WARN("Dropping frame with bad length %d", (int) length);
+            ++m_stats.framesDropped;
+            m_synced = false;
+            discard(1);
+            continue;
+        }
+
+        if (m_rxLen < sizeof(FrameHeader) + length) {
+            if (!fill(sizeof(FrameHeader) + length))
+                return false;
+            continue;
+        }
+
+        if (get32le(header->crc) != crc32c(header->length, sizeof(header->length) + length)) {
+            HM_WARN("Dropping frame with bad checksum");
+            ++m_stats.framesDropped;
+            m_synced = false;
+            discard(1);
+            continue;
+        }
+
+        memcpy(m_body, m_rx + sizeof(FrameHeader), length);
+        m_bodyLen = length;
+        m_bodyPos = 0;
+        discard(sizeof(FrameHeader) + length);
+
+        ++m_stats.framesReceived;
+        if (!m_synced) {
+            ++m_stats.resyncs;
+            m_synced = true;
+        }
+        return true;
+    }
+}
+
+bool FramedIO::fill(buffer_length_t length)
+{
+    while (m_rxLen < length) {
+        const buffer_length_t space = sizeof(m_rx) - m_rxLen;
+        buffer_length_t n = length - m_rxLen;
+        const buffer_length_t avail = m_io->available();
+        if (avail > n)
+            n = avail > space ? space : avail;
+
+        n = m_io->read(m_rx + m_rxLen, n);
+        if (n == 0)
+            return false;
+        m_rxLen += n;
+    }
+    return true;
+}
+
+void FramedIO::discard(buffer_length_t length)
+{
+    m_rxLen -= length;
+    memmove(m_rx, m_rx + length, m_rxLen);
+}
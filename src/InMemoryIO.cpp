@@ -70,7 +70,26 @@ buffer_length_t InMemoryIO::write(const byte_t* buffer, buffer_length_t sz)
         #ifdef HAS_STD_MUTEX
         std::lock_guard<std::mutex> lock(m_mx);
         #endif // HAS_STD_MUTEX
-        sz = std::min(m_bufOut.size() + sz, m_max) - m_bufOut.size();
+        // Whole buffer or nothing, callers retry after would block
+        m_wouldBlock = m_bufOut.size() + sz > m_max;
+        if (m_wouldBlock)
+            return 0;
+        m_bufOut.insert(m_bufOut.end(), buffer, buffer + sz);
+        return sz;
+    }
+    return 0;
+}
+
+buffer_length_t InMemoryIO::tryWrite(const byte_t* buffer, buffer_length_t sz)
+{
+    if (good())
+    {
+        #ifdef HAS_STD_MUTEX
+        std::lock_guard<std::mutex> lock(m_mx);
+        #endif // HAS_STD_MUTEX
+        const size_t fits = std::min(m_bufOut.size() + sz, m_max) - m_bufOut.size();
+        m_wouldBlock = fits < sz;
+        sz = static_cast<buffer_length_t>(fits);
         m_bufOut.insert(m_bufOut.end(), buffer, buffer + sz);
         return sz;
     }
@@ -18,9 +18,93 @@
 
 #include <hermes/Master.h>
 #include <hermes/Message.h>
+#include <hermes/MessageBuilder.h>
+
+#ifdef HAS_STD_THREAD_H
+#include <chrono>
+#endif // HAS_STD_THREAD_H
 
 using namespace hermes;
 
+namespace
+{
+    uint32_t millis()
+    {
+        #ifdef HAS_STD_THREAD_H
+        using namespace std::chrono;
+        return static_cast<uint32_t>(duration_cast<milliseconds>(steady_clock::now().time_since_epoch()).count());
+        #else
+        return 0;
+        #endif // HAS_STD_THREAD_H
+    }
+
+    /**
+     * Ends an admitted handshake when accept() returns, unless it was handed
+     * over to the new slave callback.
+    */
+    struct AdmissionGuard
+    {
+        AdmissionControl* admission = nullptr;
+        serial_t serial;
+
+        ~AdmissionGuard()
+        {
+            if (admission != nullptr)
+                admission->done(serial);
+        }
+
+        inline AdmissionControl* release()
+        {
+            AdmissionControl* res = admission;
+            admission = nullptr;
+            return res;
+        }
+    };
+
+    /**
+     * Settle a handshake offer on one version and on features both the
+     * slave and io support.
+     * @return false if there is no common version
+    */
+    bool agree(const IO* io, HandshakePayload& hs)
+    {
+        const ApiVersion version = compare(hs.maximumVersion, CurrentApiVersion) < 0
+                                   ? hs.maximumVersion
+                                   : CurrentApiVersion;
+        if (compare(version, hs.minimumVersion) < 0 || compare(version, MinimumApiVersion) < 0) {
+            hs.result = HandshakeResult::Fail;
+            return false;
+        }
+
+        if (compare(version, SchemaApiVersion) < 0)
+            hs.schemaHash = 0;
+
+        if (compare(version, CapabilitiesApiVersion) < 0) {
+            // Fields below are not part of the offer
+            hs.capabilities = 0;
+            hs.codec = Codec::None;
+            hs.maxFrameLength = 0;
+        } else {
+            HandshakePayload own{};
+            io->offer(own);
+            hs.capabilities &= own.capabilities;
+            if (!(hs.capabilities & CapCompression) || hs.codec != own.codec) {
+                hs.capabilities &= ~CapCompression;
+                hs.codec = Codec::None;
+            }
+            if (own.maxFrameLength < hs.maxFrameLength)
+                hs.maxFrameLength = own.maxFrameLength;
+            if (hs.maxFrameLength == 0)
+                hs.capabilities &= ~(CapFraming | CapCrc);
+        }
+
+        hs.desiredVersion = hs.minimumVersion = hs.maximumVersion = version;
+        hs.result = HandshakeResult::Ok;
+        hs.retryAfterMs = 0;
+        return true;
+    }
+} // namespace
+
 Master::Master(IO* io)
     : m_io(io)
 {}
@@ -35,28 +119,46 @@ bool Master::accept(IO* io)
     
     HM_DBG("New message receive: %s", mt2str(msg.type));
     
-    
+    AdmissionGuard admitted;
     switch(msg.type)
     {
         case MessageType::Handshake:
         {
-            bool accept = true;
-            if (m_authenticator == nullptr)
+            uint16_t retryAfterMs = 0;
+            bool accept = agree(io, msg.payload.handshake);
+            if (!accept)
             {
-                HM_ERR("Authentificator is not set!");
+                HM_WARN("Client does not support any known API version");
+            }
+            else if (!m_admission.admit(millis(), serial_t(msg.serial), retryAfterMs))
+            {
+                HM_INFO("Too many handshakes, client should retry in %d ms", (int) retryAfterMs);
+                msg.payload.handshake.result = HandshakeResult::RetryLater;
+                msg.payload.handshake.retryAfterMs = retryAfterMs;
+                accept = false;
             }
             else
             {
-                token_t token = msg.token;
-                accept = m_authenticator(msg.serial, token);
-                if (accept)
+                admitted.admission = &m_admission;
+                admitted.serial = serial_t(msg.serial);
+                if (m_authenticator == nullptr)
                 {
-                    memcpy(msg.token, token.data, HERMES_TOKEN_LENGTH);
+                    HM_ERR("Authentificator is not set!");
                 }
                 else
                 {
-                    m_slaves.remove_if([msg](const SlaveDescriptor& slave) { return slave.serial() == msg.serial; });
-                    HM_WARN("Client rejected");
+                    token_t token = msg.token;
+                    accept = m_authenticator(msg.serial, token);
+                    if (accept)
+                    {
+                        memcpy(msg.token, token.data, sizeof(msg.token));
+                    }
+                    else
+                    {
+                        m_slaves.remove_if([msg](const SlaveDescriptor& slave) { return slave.serial() == msg.serial; });
+                        msg.payload.handshake.result = HandshakeResult::Fail;
+                        HM_WARN("Client rejected");
+                    }
                 }
             }
 
@@ -67,6 +169,8 @@ bool Master::accept(IO* io)
                 return false;
             }
 
+            io->negotiate(msg.payload.handshake);
+
             break;
         }
         case MessageType::Command:
@@ -90,21 +194,182 @@ bool Master::accept(IO* io)
         }
     }
 
-    if (descriptor == nullptr)
+    const bool created = descriptor == nullptr;
+    if (created)
     {
         m_slaves.emplace_back(io, msg.serial);
         descriptor = & *(m_slaves.rbegin());
-        if (m_new_client)
-        {
-            (*m_new_client)(descriptor);
+    }
+
+    if (msg.type == MessageType::Handshake)
+    {
+        if (!created)
+            rebind(descriptor, io);
+        descriptor->m_version = msg.payload.handshake.desiredVersion;
+        descriptor->m_capabilities = msg.payload.handshake.capabilities;
+        descriptor->m_cache.clear();
+
+        // A reconnecting slave with the same properties keeps its schema
+        RegistryEntry known;
+        const uint32_t hash = msg.payload.handshake.schemaHash;
+        if (hash == 0 || descriptor->m_schema.hash() != hash) {
+            descriptor->m_schema.clear();
+            if (m_registry != nullptr && hash != 0 && m_registry->find(serial_t(msg.serial), known)
+                && known.schemaHash == hash) {
+                HM_DBG("Schema of %d properties restored from registry", (int) known.properties.size());
+                descriptor->m_schema.assign(known.properties);
+            }
         }
+        if (m_registry != nullptr)
+            m_registry->remember(serial_t(msg.serial), token_t(msg.token));
+    }
+
+    if (created || msg.type == MessageType::Handshake)
+    {
+        announce(descriptor, admitted.release());
     }
 
     return true;
 }
 
+uint8_t Master::discover(SlaveDescriptor& proxy)
+{
+    uint8_t added = 0;
+    const uint8_t count = proxy.routesCount();
+    for (uint8_t i = 0; i < count; ++i) {
+        serial_t serial;
+        uint8_t hops = 0;
+        if (!proxy.route(i, serial, hops))
+            continue;
+
+        bool known = false;
+        for (auto& s : m_slaves) {
+            if (s.serial() == serial) {
+                known = true;
+                break;
+            }
+        }
+        if (known)
+            continue;
+
+        if (m_authenticator != nullptr) {
+            // Slave never handshaked with us, it is asking for a new token
+            token_t token;
+            if (!m_authenticator(serial, token)) {
+                HM_WARN("Slave behind proxy rejected");
+                continue;
+            }
+        }
+
+        HM_INFO("Slave reachable through proxy in %d hops", (int) hops);
+        m_slaves.emplace_back(proxy.m_io, serial);
+        #ifdef HAS_STD_MUTEX
+        m_slaves.back().m_requestMx = proxy.m_requestMx;
+        #endif // HAS_STD_MUTEX
+        ++added;
+        announce(&m_slaves.back());
+    }
+    return added;
+}
+
+void Master::announce(SlaveDescriptor* slave, AdmissionControl* admission)
+{
+    slave->setExecutor(m_executor);
+    slave->setJournal(m_journal);
+    slave->m_registry = m_registry;
+    const serial_t serial = slave->serial();
+    if (m_new_client == nullptr && m_journal == nullptr) {
+        if (admission != nullptr)
+            admission->done(serial);
+        return;
+    }
+
+    on_new_slave_fn_t callback = m_new_client;
+    PropertyJournal* journal = m_journal;
+    auto welcome = [slave, callback, journal, admission, serial]() {
+        if (callback != nullptr)
+            (*callback)(slave);
+        #ifdef HAS_LINUX_HEADERS
+        if (journal != nullptr)
+            journal->replay(*slave);
+        #endif // HAS_LINUX_HEADERS
+        if (admission != nullptr)
+            admission->done(serial);
+    };
+
+    if (m_executor == nullptr) {
+        welcome();
+        return;
+    }
+    m_executor->post(slave, welcome);
+}
+
+void Master::rebind(SlaveDescriptor* slave, IO* io)
+{
+    HM_INFO("Slave connected again, dropping its old connection");
+    {
+        #ifdef HAS_STD_MUTEX
+        // Wait for a request on the old connection, slaves behind a proxy
+        // move to the new one together with it
+        std::lock_guard<std::mutex> lock(*slave->m_requestMx);
+        for (auto& s : m_slaves) {
+            if (s.m_requestMx == slave->m_requestMx)
+                s.m_io = io;
+        }
+        #else
+        slave->m_io = io;
+        #endif // HAS_STD_MUTEX
+    }
+    slave->dropSets();
+}
+
 void Master::close(SlaveDescriptor& target)
 {
-    m_slaves.remove_if([&target](const SlaveDescriptor& slave) { return target.serial() == slave.serial(); });
     target.close();
-}
\ No newline at end of file
+
+    // Callbacks of the slave still queued use the descriptor
+    if (m_executor != nullptr)
+        m_executor->drain(&target);
+
+    serial_t serial = target.serial();
+    m_slaves.remove_if([&serial](const SlaveDescriptor& slave) { return serial == slave.serial(); });
+}
+
+bool Master::setGroup(IO* io, group_t group, const ValueData& value, GroupAckData* ack, uint16_t responders)
+{
+    const serial_t serial = groupSerial(group);
+    Message req{};
+    MessageBuilder::setSerial(req, serial.data);
+    memset(req.token, 0, sizeof(req.token));
+    req.type = MessageType::Command;
+    req.payload.command.command = ack ? Command::GroupSet : Command::Set;
+    req.payload.command.data.set = value;
+    req.payloadLength = sizeof(CommandData);
+
+    if (!io->write(req)) {
+        HM_ERR("Sending group request failed");
+        return false;
+    }
+
+    if (ack == nullptr)
+        return true;
+
+    ack->applied = 0;
+    ack->failed = 0;
+    while (responders > 0) {
+        Message rsp;
+        if (!io->read(rsp)) {
+            HM_WARN("Missing %d group acknowledgements", (int) responders);
+            return false;
+        }
+        if (rsp.type != MessageType::Command || rsp.payload.command.command != Command::GroupSet
+            || serial != rsp.serial) {
+            HM_WARN("Unexpected frame while waiting for group acknowledgements");
+            continue;
+        }
+        ack->applied += rsp.payload.command.data.ack.applied;
+        ack->failed += rsp.payload.command.data.ack.failed;
+        --responders;
+    }
+    return true;
+}
@@ -18,6 +18,9 @@
 
 #include <hermes/Message.h>
 
+#include <stdio.h>
+#include <string.h>
+
 const char* hermes::mt2str(const MessageType& type)
 {
     #define MT2_STR_HELPER(Type) case MessageType:: Type: { return #Type; }
@@ -34,47 +37,12 @@ const char* hermes::mt2str(const MessageType& type)
     return "UnknownType";
 }
 
-const char* hermes::vd2str(const hermes::ValueData& vd, char* str)
-{
-    switch (vd.type)
-    {
-    case hermes::ValueType::Boolean:
-    {
-        strncpy(str, vd.value.B ? "true\0" : "false", 6);
-        break;
-    }
-    case hermes::ValueType::Float:
-    {
-        snprintf(str, HERMES_STRING_LENGTH, "%f", float(vd.value.F.V) / float(vd.value.F.Precision));
-        break;
-    }
-    case hermes::ValueType::Integer:
-    {
-        snprintf(str, HERMES_STRING_LENGTH, "%d", vd.value.I);
-        break;
-    }
-    case hermes::ValueType::UnsignedInteger:
-    {
-        snprintf(str, HERMES_STRING_LENGTH, "%u", vd.value.U);
-        break;
-    }
-    case hermes::ValueType::String:
-    {
-        strcpy(str, vd.value.S);
-        break;
-    }
-    default: {
-        return nullptr;
-    }
-    }
-    
-    return str;
-}
-
 const char* hermes::vd2str(const hermes::ValueData& vd)
 {
+    #ifdef HAS_STD_THREAD_H
+    thread_local
+    #endif // HAS_STD_THREAD_H
     static char val[HERMES_STRING_LENGTH];
-    memset(val, '\0', HERMES_SERIAL_LENGTH);
     if(vd2str(vd, val) == nullptr)
     {
         return "";
@@ -93,6 +61,12 @@ const char* hermes::cmd2str(const Command& cmd)
         CMD2_STR_HELPER(GetPropertiesCount)
         CMD2_STR_HELPER(GetPropertyName)
         CMD2_STR_HELPER(PollEvents)
+        CMD2_STR_HELPER(GetRoutesCount)
+        CMD2_STR_HELPER(GetRoute)
+        CMD2_STR_HELPER(GroupSet)
+        CMD2_STR_HELPER(Subscribe)
+        CMD2_STR_HELPER(Unsubscribe)
+        CMD2_STR_HELPER(Update)
     default:
         break;
     }
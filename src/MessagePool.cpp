@@ -0,0 +1,96 @@
+/**
+ * Hermes - A RPC for IOT
+ * Copyright (C) 2023  Eduard Sargsyan and Andrey Ovodov
+ * 
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ * 
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ * 
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#include <hermes/MessagePool.h>
+
+using namespace hermes;
+
+MessagePool::MessagePool(uint16_t capacity)
+    : m_slab(new Node[capacity])
+    , m_capacity(capacity)
+{
+    for (uint16_t i = 0; i < capacity; ++i) {
+        m_slab[i].next = m_free;
+        m_free = &m_slab[i];
+    }
+}
+
+Message* MessagePool::acquire()
+{
+    #ifdef HAS_STD_MUTEX
+    std::lock_guard<std::mutex> lock(m_mx);
+    #endif // HAS_STD_MUTEX
+    if (m_free == nullptr) {
+        ++m_stats.exhausted;
+        return nullptr;
+    }
+
+    Node* n = m_free;
+    m_free = n->next;
+    n->next = nullptr;
+    ++m_stats.acquired;
+    if (++m_stats.inUse > m_stats.peak)
+        m_stats.peak = m_stats.inUse;
+    return &n->msg;
+}
+
+void MessagePool::release(Message* msg)
+{
+    if (msg == nullptr)
+        return;
+
+    #ifdef HAS_STD_MUTEX
+    std::lock_guard<std::mutex> lock(m_mx);
+    #endif // HAS_STD_MUTEX
+    Node* n = node(msg);
+    n->next = m_free;
+    m_free = n;
+    ++m_stats.released;
+    --m_stats.inUse;
+}
+
+void MessageQueue::push(Message* msg)
+{
+    MessagePool::Node* n = MessagePool::node(msg);
+    n->next = nullptr;
+    if (m_tail)
+        m_tail->next = n;
+    else
+        m_head = n;
+    m_tail = n;
+    ++m_size;
+}
+
+Message* MessageQueue::pop()
+{
+    if (m_head == nullptr)
+        return nullptr;
+
+    MessagePool::Node* n = m_head;
+    m_head = n->next;
+    if (m_head == nullptr)
+        m_tail = nullptr;
+    --m_size;
+    return &n->msg;
+}
+
+void MessageQueue::clear(MessagePool& pool)
+{
+    while (!empty())
+        pool.release(pop());
+}
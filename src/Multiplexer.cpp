@@ -0,0 +1,312 @@
+/**
+ * Hermes - A RPC for IOT
+ * Copyright (C) 2023  Eduard Sargsyan and Andrey Ovodov
+ * 
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ * 
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ * 
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#include <hermes/Multiplexer.h>
+#include <hermes/Group.h>
+
+using namespace hermes;
+
+MuxChannel::MuxChannel(Multiplexer* mux, const serial_t& serial)
+    : m_mux(mux)
+    , m_serial(serial)
+{
+}
+
+bool MuxChannel::good() const
+{
+    return m_open && m_mux->good();
+}
+
+void MuxChannel::flush()
+{
+    #ifdef HAS_STD_MUTEX
+    std::lock_guard<std::mutex> lock(m_mux->m_mx);
+    #endif // HAS_STD_MUTEX
+    m_in.clear(m_pool);
+}
+
+buffer_length_t MuxChannel::available() const
+{
+    #ifdef HAS_STD_MUTEX
+    std::lock_guard<std::mutex> lock(m_mux->m_mx);
+    #endif // HAS_STD_MUTEX
+    return static_cast<buffer_length_t>(m_in.size() * sizeof(Message));
+}
+
+buffer_length_t MuxChannel::wait(buffer_length_t length)
+{
+    m_mux->pumpUntil([this, length]() { return m_in.size() * sizeof(Message) >= length || !m_open; });
+    return available();
+}
+
+buffer_length_t MuxChannel::write(const byte_t* buf, buffer_length_t length)
+{
+    if (length != sizeof(Message)) {
+        HM_ERR("Multiplexed channels carry whole messages only");
+        return 0;
+    }
+    return m_mux->send(this, *reinterpret_cast<const Message*>(buf)) ? length : 0;
+}
+
+buffer_length_t MuxChannel::read(byte_t* buf, buffer_length_t length)
+{
+    if (length != sizeof(Message)) {
+        HM_ERR("Multiplexed channels carry whole messages only");
+        return 0;
+    }
+    return m_mux->receive(this, *reinterpret_cast<Message*>(buf)) ? length : 0;
+}
+
+bool MuxChannel::close()
+{
+    #ifdef HAS_STD_MUTEX
+    std::lock_guard<std::mutex> lock(m_mux->m_mx);
+    #endif // HAS_STD_MUTEX
+    m_open = false;
+    m_in.clear(m_pool);
+    #ifdef HAS_STD_MUTEX
+    m_mux->m_cv.notify_all();
+    #endif // HAS_STD_MUTEX
+    return true;
+}
+
+Multiplexer::Multiplexer(IO* io)
+    : m_io(io)
+{
+}
+
+MuxChannel* Multiplexer::channel(const serial_t& serial)
+{
+    #ifdef HAS_STD_MUTEX
+    std::lock_guard<std::mutex> lock(m_mx);
+    #endif // HAS_STD_MUTEX
+    MuxChannel* ch = find(serial.data);
+    if (ch == nullptr) {
+        m_channels.emplace_back(this, serial);
+        ch = &m_channels.back();
+    }
+    ch->m_open = true;
+    return ch;
+}
+
+MuxChannel* Multiplexer::accept()
+{
+    if (!pumpUntil([this]() { return !m_accepted.empty(); }))
+        return nullptr;
+
+    #ifdef HAS_STD_MUTEX
+    std::lock_guard<std::mutex> lock(m_mx);
+    #endif // HAS_STD_MUTEX
+    MuxChannel* ch = m_accepted.front();
+    m_accepted.pop_front();
+    return ch;
+}
+
+bool Multiplexer::poll()
+{
+    const uint32_t before = m_stats.framesIn + m_stats.framesDropped;
+    return pumpUntil([this, before]() { return m_stats.framesIn + m_stats.framesDropped != before; });
+}
+
+bool Multiplexer::send(MuxChannel* channel, const Message& msg)
+{
+    {
+        #ifdef HAS_STD_MUTEX
+        std::lock_guard<std::mutex> lock(m_mx);
+        #endif // HAS_STD_MUTEX
+        Message* slot = channel->m_pool.acquire();
+        if (slot == nullptr) {
+            HM_WARN("Send queue of channel is full");
+            return false;
+        }
+        *slot = msg;
+        channel->m_out.push(slot);
+    }
+
+    // Whoever holds the write lock drains all channels, so by the time we
+    // get it our frame may already be sent.
+    #ifdef HAS_STD_MUTEX
+    std::lock_guard<std::mutex> writeLock(m_writeMx);
+    #endif // HAS_STD_MUTEX
+    for (;;) {
+        MuxChannel* from = nullptr;
+        Message* out = nullptr;
+        {
+            #ifdef HAS_STD_MUTEX
+            std::lock_guard<std::mutex> lock(m_mx);
+            #endif // HAS_STD_MUTEX
+            from = nextOutbound();
+            if (from == nullptr)
+                break;
+            out = from->m_out.pop();
+        }
+
+        if (!m_io->write(*out))
+            HM_WARN("Writing to multiplexed IO failed");
+
+        #ifdef HAS_STD_MUTEX
+        std::lock_guard<std::mutex> lock(m_mx);
+        #endif // HAS_STD_MUTEX
+        from->m_pool.release(out);
+        ++m_stats.framesOut;
+    }
+    return m_io->good();
+}
+
+bool Multiplexer::receive(MuxChannel* channel, Message& msg)
+{
+    if (!pumpUntil([channel]() { return !channel->m_in.empty() || !channel->m_open; }))
+        return false;
+
+    #ifdef HAS_STD_MUTEX
+    std::lock_guard<std::mutex> lock(m_mx);
+    #endif // HAS_STD_MUTEX
+    Message* in = channel->m_in.pop();
+    if (in == nullptr)
+        return false;
+    msg = *in;
+    channel->m_pool.release(in);
+    return true;
+}
+
+template<class Pred>
+bool Multiplexer::pumpUntil(Pred pred)
+{
+    #ifdef HAS_STD_MUTEX
+    std::unique_lock<std::mutex> lock(m_mx);
+    #endif // HAS_STD_MUTEX
+    while (!pred()) {
+        if (!m_io->good())
+            return false;
+
+        if (m_reading) {
+            #ifdef HAS_STD_MUTEX
+            m_cv.wait(lock);
+            #endif // HAS_STD_MUTEX
+            continue;
+        }
+
+        m_reading = true;
+        #ifdef HAS_STD_MUTEX
+        lock.unlock();
+        #endif // HAS_STD_MUTEX
+        Message msg;
+        const bool ok = m_io->read(msg);
+        #ifdef HAS_STD_MUTEX
+        lock.lock();
+        #endif // HAS_STD_MUTEX
+        m_reading = false;
+        if (ok)
+            dispatch(msg);
+        #ifdef HAS_STD_MUTEX
+        m_cv.notify_all();
+        #endif // HAS_STD_MUTEX
+        if (!ok)
+            return pred();
+    }
+    return true;
+}
+
+void Multiplexer::dispatch(const Message& msg)
+{
+    MuxChannel* ch = find(msg.serial);
+    if (ch == nullptr && isGroupSerial(msg.serial)) {
+        // Every slave on the bus sees group frames and picks its own
+        ++m_stats.framesIn;
+        for (auto& member : m_channels) {
+            if (!member.m_open || isGroupSerial(member.m_serial.data))
+                continue;
+            Message* slot = member.m_pool.acquire();
+            if (slot == nullptr) {
+                HM_WARN("Receive queue of channel is full, dropping group frame");
+                ++m_stats.framesDropped;
+                continue;
+            }
+            *slot = msg;
+            member.m_in.push(slot);
+        }
+        return;
+    }
+
+    if (ch == nullptr) {
+        m_channels.emplace_back(this, serial_t(msg.serial));
+        ch = &m_channels.back();
+        m_accepted.push_back(ch);
+        ++m_stats.channelsOpened;
+    } else if (!ch->m_open) {
+        ch->m_open = true;
+        m_accepted.push_back(ch);
+        ++m_stats.channelsOpened;
+    }
+
+    Message* slot = ch->m_pool.acquire();
+    if (slot == nullptr) {
+        HM_WARN("Receive queue of channel is full, dropping frame");
+        ++m_stats.framesDropped;
+        return;
+    }
+    *slot = msg;
+    ch->m_in.push(slot);
+    ++m_stats.framesIn;
+}
+
+MuxChannel* Multiplexer::find(const byte_t* serial)
+{
+    for (auto& ch : m_channels) {
+        if (ch.m_serial == serial)
+            return &ch;
+    }
+    return nullptr;
+}
+
+MuxChannel* Multiplexer::nextOutbound()
+{
+    const size_t count = m_channels.size();
+    if (count == 0)
+        return nullptr;
+
+    auto it = m_channels.begin();
+    for (size_t i = 0; i < m_cursor % count; ++i)
+        ++it;
+
+    // First channel of every class, round-robin between channels of the same class
+    MuxChannel* first[MessageClassCount] = { nullptr };
+    size_t offset[MessageClassCount] = { 0 };
+    for (size_t i = 0; i < count; ++i) {
+        if (!it->m_out.empty()) {
+            const uint8_t cls = static_cast<uint8_t>(classify(*it->m_out.front()));
+            if (first[cls] == nullptr) {
+                first[cls] = &*it;
+                offset[cls] = i;
+            }
+        }
+        if (++it == m_channels.end())
+            it = m_channels.begin();
+    }
+
+    bool ready[MessageClassCount];
+    for (uint8_t c = 0; c < MessageClassCount; ++c)
+        ready[c] = first[c] != nullptr;
+
+    const uint8_t pick = pickLane(ready, m_bypassed);
+    if (pick == MessageClassCount)
+        return nullptr;
+
+    m_cursor = (m_cursor + offset[pick] + 1) % count;
+    return first[pick];
+}
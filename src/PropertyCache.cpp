@@ -0,0 +1,168 @@
+/**
+ * Hermes - A RPC for IOT
+ * Copyright (C) 2023  Eduard Sargsyan and Andrey Ovodov
+ * 
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ * 
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ * 
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#include <hermes/PropertyCache.h>
+
+#include <string.h>
+
+using namespace hermes;
+
+constexpr uint32_t PropertyCache::Default;
+
+void PropertyCache::setDefaultMaxAge(uint32_t ms)
+{
+    #ifdef HAS_STD_MUTEX
+    std::lock_guard<std::mutex> lock(m_mx);
+    #endif // HAS_STD_MUTEX
+    m_defaultMaxAge = ms;
+}
+
+void PropertyCache::setMaxAge(uint8_t property, uint32_t ms)
+{
+    #ifdef HAS_STD_MUTEX
+    std::lock_guard<std::mutex> lock(m_mx);
+    #endif // HAS_STD_MUTEX
+    entry(property).maxAge = ms;
+}
+
+uint32_t PropertyCache::maxAge(uint8_t property) const
+{
+    #ifdef HAS_STD_MUTEX
+    std::lock_guard<std::mutex> lock(m_mx);
+    #endif // HAS_STD_MUTEX
+    return maxAgeLocked(property);
+}
+
+bool PropertyCache::lookup(uint8_t property, uint32_t now, ValueData& value)
+{
+    #ifdef HAS_STD_MUTEX
+    std::lock_guard<std::mutex> lock(m_mx);
+    #endif // HAS_STD_MUTEX
+    const uint32_t age = maxAgeLocked(property);
+    if (age == 0)
+        return false;
+
+    const Entry& e = entry(property);
+    if (!e.valid || now - e.updated > age) {
+        ++m_stats.misses;
+        return false;
+    }
+
+    value = e.value;
+    ++m_stats.hits;
+    return true;
+}
+
+void PropertyCache::store(uint8_t property, uint32_t now, const ValueData& value)
+{
+    #ifdef HAS_STD_MUTEX
+    std::lock_guard<std::mutex> lock(m_mx);
+    #endif // HAS_STD_MUTEX
+    if (maxAgeLocked(property) == 0)
+        return;
+
+    Entry& e = entry(property);
+    e.value = value;
+    e.updated = now;
+    e.named = true;
+    e.valid = true;
+}
+
+bool PropertyCache::push(uint32_t now, const ValueData& value, uint8_t* property)
+{
+    #ifdef HAS_STD_MUTEX
+    std::lock_guard<std::mutex> lock(m_mx);
+    #endif // HAS_STD_MUTEX
+    for (size_t i = 0; i < m_entries.size(); ++i) {
+        Entry& e = m_entries[i];
+        if (!e.named || strncmp(e.value.name, value.name, sizeof(value.name)) != 0)
+            continue;
+        if (maxAgeLocked(static_cast<uint8_t>(i)) == 0)
+            return false;
+
+        e.value = value;
+        e.updated = now;
+        e.valid = true;
+        ++m_stats.pushed;
+        if (property != nullptr)
+            *property = static_cast<uint8_t>(i);
+        return true;
+    }
+    return false;
+}
+
+void PropertyCache::invalidate(uint8_t property)
+{
+    #ifdef HAS_STD_MUTEX
+    std::lock_guard<std::mutex> lock(m_mx);
+    #endif // HAS_STD_MUTEX
+    if (property >= m_entries.size() || !m_entries[property].valid)
+        return;
+
+    m_entries[property].valid = false;
+    ++m_stats.invalidated;
+}
+
+void PropertyCache::clear()
+{
+    #ifdef HAS_STD_MUTEX
+    std::lock_guard<std::mutex> lock(m_mx);
+    #endif // HAS_STD_MUTEX
+    for (auto& e : m_entries)
+        e.named = e.valid = false;
+}
+
+bool PropertyCache::name(uint8_t property, char* name) const
+{
+    #ifdef HAS_STD_MUTEX
+    std::lock_guard<std::mutex> lock(m_mx);
+    #endif // HAS_STD_MUTEX
+    if (property >= m_entries.size() || !m_entries[property].named)
+        return false;
+
+    strcpy(name, m_entries[property].value.name);
+    return true;
+}
+
+void PropertyCache::setName(uint8_t property, const char* name)
+{
+    #ifdef HAS_STD_MUTEX
+    std::lock_guard<std::mutex> lock(m_mx);
+    #endif // HAS_STD_MUTEX
+    if (maxAgeLocked(property) == 0)
+        return;
+
+    Entry& e = entry(property);
+    strncpy(e.value.name, name, sizeof(e.value.name) - 1);
+    e.value.name[sizeof(e.value.name) - 1] = '\0';
+    e.named = true;
+}
+
+PropertyCache::Entry& PropertyCache::entry(uint8_t property)
+{
+    if (property >= m_entries.size())
+        m_entries.resize(property + 1);
+    return m_entries[property];
+}
+
+uint32_t PropertyCache::maxAgeLocked(uint8_t property) const
+{
+    if (property >= m_entries.size() || m_entries[property].maxAge == Default)
+        return m_defaultMaxAge;
+    return m_entries[property].maxAge;
+}
@@ -0,0 +1,395 @@
+/**
+ * Hermes - A RPC for IOT
+ * Copyright (C) 2023  Eduard Sargsyan and Andrey Ovodov
+ * 
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ * 
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ * 
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#include <hermes/PropertyJournal.h>
+
+#ifdef HAS_LINUX_HEADERS
+
+#include <hermes/Crc32c.h>
+#include <hermes/SlaveDescriptor.h>
+
+#include <chrono>
+#include <errno.h>
+#include <fcntl.h>
+#include <stdio.h>
+#include <string.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#include <vector>
+
+using namespace hermes;
+
+namespace
+{
+    constexpr char Magic[4] = { 'H', 'M', 'J', 'L' };
+
+    uint64_t wallMillis()
+    {
+        using namespace std::chrono;
+        return static_cast<uint64_t>(duration_cast<milliseconds>(system_clock::now().time_since_epoch()).count());
+    }
+
+    /**
+     * Clock of SlaveDescriptor's cache
+    */
+    uint32_t millis()
+    {
+        using namespace std::chrono;
+        return static_cast<uint32_t>(duration_cast<milliseconds>(steady_clock::now().time_since_epoch()).count());
+    }
+
+    size_t roundUp(size_t length)
+    {
+        return (length + HERMES_JOURNAL_GROW_BYTES - 1) / HERMES_JOURNAL_GROW_BYTES * HERMES_JOURNAL_GROW_BYTES;
+    }
+} // namespace
+
+PropertyJournal::PropertyJournal(const char* path, uint32_t compactAt)
+    : m_path(path)
+    , m_compactAt(compactAt)
+{
+    if (open())
+        HM_INFO("Journal %s has %u records, %zu properties", path, m_stats.records, m_index.size());
+}
+
+PropertyJournal::~PropertyJournal()
+{
+    #if defined(HAS_STD_THREAD_H) && defined(HAS_STD_MUTEX)
+    {
+        std::lock_guard<std::mutex> lock(m_mx);
+        m_stop = true;
+    }
+    m_compactCv.notify_one();
+    if (m_compactor.joinable())
+        m_compactor.join();
+    #endif // HAS_STD_THREAD_H && HAS_STD_MUTEX
+    close();
+}
+
+bool PropertyJournal::append(const serial_t& serial, uint8_t property, const ValueData& value, uint64_t timestamp)
+{
+    Record rec{};
+    rec.timestamp = timestamp != 0 ? timestamp : wallMillis();
+    memcpy(rec.serial, serial.data, HERMES_SERIAL_LENGTH);
+    rec.property = property;
+    rec.value = value;
+    rec.checksum = checksum(rec);
+
+    {
+        #ifdef HAS_STD_MUTEX
+        std::lock_guard<std::mutex> lock(m_mx);
+        #endif // HAS_STD_MUTEX
+        if (!appendLocked(rec))
+            return false;
+        if (!compactionDue())
+            return true;
+
+        // Until this compaction is done, or after it failed, the file has
+        // to grow by another m_compactAt records before it is tried again
+        m_nextCompact = m_stats.records + m_compactAt;
+        #if defined(HAS_STD_THREAD_H) && defined(HAS_STD_MUTEX)
+        m_compactDue = true;
+        if (!m_compactor.joinable())
+            m_compactor = std::thread(&PropertyJournal::compactor, this);
+        #endif // HAS_STD_THREAD_H && HAS_STD_MUTEX
+    }
+
+    #if defined(HAS_STD_THREAD_H) && defined(HAS_STD_MUTEX)
+    m_compactCv.notify_one();
+    #else
+    compact();
+    #endif // HAS_STD_THREAD_H && HAS_STD_MUTEX
+    return true;
+}
+
+bool PropertyJournal::find(const serial_t& serial, uint8_t property, ValueData& value, uint64_t& timestamp) const
+{
+    #ifdef HAS_STD_MUTEX
+    std::lock_guard<std::mutex> lock(m_mx);
+    #endif // HAS_STD_MUTEX
+    auto it = m_index.find(key(serial.data, property));
+    if (it == m_index.end())
+        return false;
+
+    const Record* rec = record(it->second);
+    value = rec->value;
+    timestamp = rec->timestamp;
+    return true;
+}
+
+uint8_t PropertyJournal::replay(SlaveDescriptor& slave)
+{
+    #ifdef HAS_STD_MUTEX
+    std::lock_guard<std::mutex> lock(m_mx);
+    #endif // HAS_STD_MUTEX
+    const uint64_t wallNow = wallMillis();
+    const uint32_t now = millis();
+    const std::string prefix = key(slave.serial().data, 0);
+
+    uint8_t restored = 0;
+    for (auto it = m_index.lower_bound(prefix);
+         it != m_index.end() && it->first.compare(0, HERMES_SERIAL_LENGTH, prefix, 0, HERMES_SERIAL_LENGTH) == 0;
+         ++it)
+    {
+        const Record* rec = record(it->second);
+        const uint8_t property = rec->property;
+        const uint32_t maxAge = slave.cache().maxAge(property);
+        const uint64_t age = wallNow > rec->timestamp ? wallNow - rec->timestamp : 0;
+        if (maxAge == 0 || age > maxAge)
+            continue;
+
+        ValueData value = rec->value;
+        slave.cache().setName(property, value.name);
+        slave.cache().store(property, now - static_cast<uint32_t>(age), value);
+        ++restored;
+    }
+    m_stats.replayed += restored;
+    HM_DBG("Restored %d values from journal", (int) restored);
+    return restored;
+}
+
+bool PropertyJournal::compact()
+{
+    #ifdef HAS_STD_MUTEX
+    std::lock_guard<std::mutex> compacting(m_compactMx);
+    std::unique_lock<std::mutex> lock(m_mx);
+    #endif // HAS_STD_MUTEX
+    if (m_map == nullptr)
+        return false;
+
+    // Live records are copied with the lock held, but written and synced
+    // without it. Records appended meanwhile are moved over below.
+    std::vector<byte_t> data;
+    data.reserve(sizeof(Header) + m_index.size() * sizeof(Record));
+    data.insert(data.end(), m_map, m_map + sizeof(Header));
+    for (const auto& entry : m_index)
+    {
+        const byte_t* rec = m_map + entry.second;
+        data.insert(data.end(), rec, rec + sizeof(Record));
+    }
+    const size_t copied = m_tail;
+    #ifdef HAS_STD_MUTEX
+    lock.unlock();
+    #endif // HAS_STD_MUTEX
+
+    const std::string tmp = m_path + ".tmp";
+    int fd = ::open(tmp.c_str(), O_RDWR | O_CREAT | O_TRUNC | O_CLOEXEC, 0644);
+    bool written = fd >= 0
+                   && write(fd, data.data(), data.size()) == static_cast<ssize_t>(data.size())
+                   && fsync(fd) == 0;
+
+    #ifdef HAS_STD_MUTEX
+    lock.lock();
+    #endif // HAS_STD_MUTEX
+    // Later records win when the file is read, so the ones appended after
+    // the copy go to the end as they are. Like other appends they reach
+    // the disk with the next sync().
+    const size_t appended = m_tail - copied;
+    if (written && appended != 0)
+        written = write(fd, m_map + copied, appended) == static_cast<ssize_t>(appended);
+    if (fd >= 0)
+        ::close(fd);
+    if (!written || rename(tmp.c_str(), m_path.c_str()) != 0)
+    {
+        HM_ERR("Can't compact journal %s: %s", m_path.c_str(), strerror(errno));
+        unlink(tmp.c_str());
+        return false;
+    }
+
+    const JournalStats stats = m_stats;
+    close();
+    const bool reopened = open();
+    m_stats.compactions = stats.compactions + 1;
+    m_stats.appended = stats.appended;
+    m_stats.replayed = stats.replayed;
+    m_nextCompact = 0;
+    HM_DBG("Journal %s compacted to %u records", m_path.c_str(), m_stats.records);
+    return reopened;
+}
+
+bool PropertyJournal::sync()
+{
+    #ifdef HAS_STD_MUTEX
+    std::lock_guard<std::mutex> lock(m_mx);
+    #endif // HAS_STD_MUTEX
+    return m_map != nullptr && msync(m_map, m_tail, MS_SYNC) == 0;
+}
+
+JournalStats PropertyJournal::stats() const
+{
+    #ifdef HAS_STD_MUTEX
+    std::lock_guard<std::mutex> lock(m_mx);
+    #endif // HAS_STD_MUTEX
+    JournalStats stats = m_stats;
+    stats.live = static_cast<uint32_t>(m_index.size());
+    return stats;
+}
+
+std::string PropertyJournal::key(const byte_t* serial, uint8_t property)
+{
+    std::string k(reinterpret_cast<const char*>(serial), HERMES_SERIAL_LENGTH);
+    k.push_back(static_cast<char>(property));
+    return k;
+}
+
+uint32_t PropertyJournal::checksum(const Record& record)
+{
+    const byte_t* data = reinterpret_cast<const byte_t*>(&record);
+    return crc32c(data + sizeof(record.checksum), sizeof(Record) - sizeof(record.checksum));
+}
+
+bool PropertyJournal::open()
+{
+    m_fd = ::open(m_path.c_str(), O_RDWR | O_CREAT | O_CLOEXEC, 0644);
+    if (m_fd < 0)
+    {
+        HM_ERR("Can't open journal %s: %s", m_path.c_str(), strerror(errno));
+        return false;
+    }
+
+    struct stat st;
+    if (fstat(m_fd, &st) != 0)
+    {
+        close();
+        return false;
+    }
+
+    Header header{};
+    memcpy(header.magic, Magic, sizeof(Magic));
+    header.version = Version;
+    header.recordSize = sizeof(Record);
+    header.serialLength = HERMES_SERIAL_LENGTH;
+
+    size_t size = static_cast<size_t>(st.st_size);
+    Header existing{};
+    if (size < sizeof(Header) || pread(m_fd, &existing, sizeof(existing), 0) != sizeof(existing)
+        || memcmp(&existing, &header, sizeof(Header)) != 0)
+    {
+        if (size != 0)
+            HM_WARN("Journal %s has another format, starting over", m_path.c_str());
+        if (ftruncate(m_fd, 0) != 0 || pwrite(m_fd, &header, sizeof(header), 0) != sizeof(header))
+        {
+            close();
+            return false;
+        }
+        size = sizeof(Header);
+    }
+
+    if (!map(roundUp(size)))
+    {
+        close();
+        return false;
+    }
+
+    // Records end at the first one with a wrong checksum, zeros of the
+    // preallocated tail included
+    m_index.clear();
+    m_stats.records = 0;
+    size_t offset = sizeof(Header);
+    for (; offset + sizeof(Record) <= m_capacity; offset += sizeof(Record))
+    {
+        const Record* rec = record(offset);
+        if (rec->checksum != checksum(*rec))
+            break;
+        m_index[key(rec->serial, rec->property)] = offset;
+        ++m_stats.records;
+    }
+    m_tail = offset;
+    return true;
+}
+
+void PropertyJournal::close()
+{
+    if (m_map != nullptr)
+        munmap(m_map, m_capacity);
+    if (m_fd >= 0)
+        ::close(m_fd);
+    m_map = nullptr;
+    m_capacity = 0;
+    m_fd = -1;
+}
+
+bool PropertyJournal::map(size_t capacity)
+{
+    struct stat st;
+    if (fstat(m_fd, &st) != 0 || (static_cast<size_t>(st.st_size) < capacity && ftruncate(m_fd, capacity) != 0))
+    {
+        HM_ERR("Can't grow journal %s: %s", m_path.c_str(), strerror(errno));
+        return false;
+    }
+
+    void* addr = mmap(nullptr, capacity, PROT_READ | PROT_WRITE, MAP_SHARED, m_fd, 0);
+    if (addr == MAP_FAILED)
+    {
+        HM_ERR("Can't map journal %s: %s", m_path.c_str(), strerror(errno));
+        return false;
+    }
+
+    if (m_map != nullptr)
+        munmap(m_map, m_capacity);
+    m_map = static_cast<byte_t*>(addr);
+    m_capacity = capacity;
+    return true;
+}
+
+bool PropertyJournal::appendLocked(const Record& rec)
+{
+    if (m_map == nullptr)
+        return false;
+    if (m_tail + sizeof(Record) > m_capacity && !map(m_capacity + HERMES_JOURNAL_GROW_BYTES))
+        return false;
+
+    memcpy(m_map + m_tail, &rec, sizeof(Record));
+    m_index[key(rec.serial, rec.property)] = m_tail;
+    m_tail += sizeof(Record);
+    ++m_stats.records;
+    ++m_stats.appended;
+    return true;
+}
+
+bool PropertyJournal::compactionDue() const
+{
+    return m_stats.records >= m_compactAt
+           && m_stats.records >= m_nextCompact
+           && m_stats.records > 2 * m_index.size();
+}
+
+#if defined(HAS_STD_THREAD_H) && defined(HAS_STD_MUTEX)
+void PropertyJournal::compactor()
+{
+    std::unique_lock<std::mutex> lock(m_mx);
+    for (;;)
+    {
+        m_compactCv.wait(lock, [this]() { return m_compactDue || m_stop; });
+        if (m_stop)
+            return;
+        m_compactDue = false;
+        lock.unlock();
+        compact();
+        lock.lock();
+    }
+}
+#endif // HAS_STD_THREAD_H && HAS_STD_MUTEX
+
+PropertyJournal::Record* PropertyJournal::record(size_t offset) const
+{
+    return reinterpret_cast<Record*>(m_map + offset);
+}
+
+#endif // HAS_LINUX_HEADERS
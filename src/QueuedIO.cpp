@@ -0,0 +1,268 @@
+/**
+ * Hermes - A RPC for IOT
+ * Copyright (C) 2023  Eduard Sargsyan and Andrey Ovodov
+ * 
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ * 
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ * 
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#include <hermes/QueuedIO.h>
+
+#ifdef HAS_STD_THREAD_H
+#include <algorithm>
+#include <chrono>
+#endif // HAS_STD_THREAD_H
+
+using namespace hermes;
+
+#ifdef HAS_STD_THREAD_H
+namespace
+{
+    /// @brief Longest wait of a blocked writer before it retries sending itself
+    constexpr std::chrono::milliseconds MaxRetryInterval(16);
+} // namespace
+#endif // HAS_STD_THREAD_H
+
+QueuedIO::QueuedIO(IO* io, uint16_t capacity, uint16_t high, uint16_t low)
+    : m_io(io)
+    , m_pool(capacity > 0 ? capacity : 1)
+{
+    m_high = (high > 0 && high < m_pool.capacity()) ? high : m_pool.capacity();
+    m_low = (low > 0 && low < m_high) ? low : m_high / 2;
+
+    setPolicy(MessageClass::Control, OverflowPolicy::Block);
+    setPolicy(MessageClass::Query, OverflowPolicy::Block);
+    setPolicy(MessageClass::Event, OverflowPolicy::DropOldest);
+    setPolicy(MessageClass::Bulk, OverflowPolicy::Reject);
+}
+
+bool QueuedIO::drain()
+{
+    #ifdef HAS_STD_MUTEX
+    std::lock_guard<std::mutex> lock(m_mx);
+    #endif // HAS_STD_MUTEX
+    return drainLocked();
+}
+
+uint16_t QueuedIO::queued() const
+{
+    #ifdef HAS_STD_MUTEX
+    std::lock_guard<std::mutex> lock(m_mx);
+    #endif // HAS_STD_MUTEX
+    return pending();
+}
+
+bool QueuedIO::good() const
+{
+    return m_io->good();
+}
+
+void QueuedIO::flush()
+{
+    m_io->flush();
+}
+
+buffer_length_t QueuedIO::available() const
+{
+    return m_io->available();
+}
+
+buffer_length_t QueuedIO::wait(buffer_length_t length)
+{
+    drain();
+    return m_io->wait(length);
+}
+
+buffer_length_t QueuedIO::read(byte_t* buf, buffer_length_t length)
+{
+    // Peer may wait for queued requests before answering
+    drain();
+    return m_io->read(buf, length);
+}
+
+bool QueuedIO::close()
+{
+    #ifdef HAS_STD_MUTEX
+    std::lock_guard<std::mutex> lock(m_mx);
+    #endif // HAS_STD_MUTEX
+    for (auto& lane : m_lanes)
+        lane.clear(m_pool);
+    m_pool.release(m_sending);
+    m_sending = nullptr;
+    m_congested = false;
+    #ifdef HAS_STD_MUTEX
+    m_space.notify_all();
+    #endif // HAS_STD_MUTEX
+    return m_io->close();
+}
+
+buffer_length_t QueuedIO::write(const byte_t* buf, buffer_length_t length)
+{
+    if (length != sizeof(Message)) {
+        HM_ERR("Send queue carries whole messages only");
+        return 0;
+    }
+    const Message& msg = *reinterpret_cast<const Message*>(buf);
+
+    #ifdef HAS_STD_MUTEX
+    std::unique_lock<std::mutex> lock(m_mx);
+    #endif // HAS_STD_MUTEX
+    m_wouldBlock = false;
+    if (!m_io->good())
+        return 0;
+
+    if (drainLocked()) {
+        const buffer_length_t count = m_io->tryWrite(buf, length);
+        if (count == length) {
+            ++m_stats.sent;
+            return length;
+        }
+        if (!m_io->good())
+            return 0;
+
+        // Rest of the frame has to go before anything else
+        m_sending = m_pool.acquire();
+        *m_sending = msg;
+        m_offset = count;
+        ++m_stats.queued;
+        return length;
+    }
+
+    const MessageClass cls = classify(msg);
+    if (pending() >= m_pool.capacity())
+        evictBelow(cls);
+
+    if (m_congested || pending() >= m_pool.capacity()) {
+        switch (policy(cls)) {
+        case OverflowPolicy::Reject: {
+            ++m_stats.rejected;
+            m_wouldBlock = true;
+            return 0;
+        }
+
+        case OverflowPolicy::DropOldest: {
+            Message* oldest = lane(cls).pop();
+            if (oldest == nullptr) {
+                ++m_stats.rejected;
+                m_wouldBlock = true;
+                return 0;
+            }
+            m_pool.release(oldest);
+            ++m_stats.dropped;
+            break;
+        }
+
+        case OverflowPolicy::Block: {
+            ++m_stats.blocked;
+            #if defined(HAS_STD_THREAD_H) && defined(HAS_STD_MUTEX)
+            // Other writers and readers wake us when they send queued
+            // messages. Channel can't tell when it takes data again, so try
+            // sending on our own too, less often the longer it stays full.
+            using clock = std::chrono::steady_clock;
+            const auto deadline = clock::now() + std::chrono::milliseconds(HERMES_SEND_TIMEOUT_MS);
+            std::chrono::milliseconds retry(1);
+            while (pending() >= m_pool.capacity() && m_io->good() && clock::now() < deadline) {
+                m_space.wait_until(lock, std::min(deadline, clock::now() + retry));
+                retry = std::min(retry * 2, MaxRetryInterval);
+                drainLocked();
+            }
+            #endif // HAS_STD_THREAD_H && HAS_STD_MUTEX
+            if (pending() >= m_pool.capacity()) {
+                ++m_stats.rejected;
+                m_wouldBlock = true;
+                return 0;
+            }
+            break;
+        }
+        }
+    }
+
+    return push(msg) ? length : 0;
+}
+
+bool QueuedIO::push(const Message& msg)
+{
+    Message* slot = m_pool.acquire();
+    if (slot == nullptr)
+        return false;
+
+    *slot = msg;
+    lane(classify(msg)).push(slot);
+    ++m_stats.queued;
+    if (pending() > m_stats.peak)
+        m_stats.peak = pending();
+    if (pending() >= m_high)
+        m_congested = true;
+    return true;
+}
+
+bool QueuedIO::drainLocked()
+{
+    const uint16_t before = pending();
+    for (;;) {
+        if (m_sending == nullptr) {
+            m_sending = next();
+            m_offset = 0;
+            if (m_sending == nullptr)
+                break;
+        }
+
+        const byte_t* data = reinterpret_cast<const byte_t*>(m_sending);
+        m_offset += m_io->tryWrite(data + m_offset, sizeof(Message) - m_offset);
+        if (m_offset < sizeof(Message))
+            break;
+
+        ++m_stats.sentByClass[static_cast<uint8_t>(classify(*m_sending))];
+        m_pool.release(m_sending);
+        m_sending = nullptr;
+        ++m_stats.sent;
+    }
+
+    if (m_congested && pending() <= m_low)
+        m_congested = false;
+    #ifdef HAS_STD_MUTEX
+    if (pending() < before)
+        m_space.notify_all();
+    #endif // HAS_STD_MUTEX
+    return pending() == 0;
+}
+
+uint16_t QueuedIO::pending() const
+{
+    uint16_t count = m_sending ? 1 : 0;
+    for (const auto& lane : m_lanes)
+        count += lane.size();
+    return count;
+}
+
+Message* QueuedIO::next()
+{
+    bool ready[MessageClassCount];
+    for (uint8_t c = 0; c < MessageClassCount; ++c)
+        ready[c] = !m_lanes[c].empty();
+
+    const uint8_t pick = pickLane(ready, m_bypassed);
+    return pick == MessageClassCount ? nullptr : m_lanes[pick].pop();
+}
+
+bool QueuedIO::evictBelow(MessageClass cls)
+{
+    for (uint8_t c = MessageClassCount - 1; c > static_cast<uint8_t>(cls); --c) {
+        if (m_lanes[c].empty() || m_policies[c] != OverflowPolicy::DropOldest)
+            continue;
+        m_pool.release(m_lanes[c].pop());
+        ++m_stats.dropped;
+        return true;
+    }
+    return false;
+}
@@ -0,0 +1,173 @@
+/**
+ * Hermes - A RPC for IOT
+ * Copyright (C) 2023  Eduard Sargsyan and Andrey Ovodov
+ * 
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ * 
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ * 
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#include <hermes/Router.h>
+#include <hermes/MessageBuilder.h>
+
+using namespace hermes;
+
+bool Router::addRoute(const serial_t& serial, IO* link, uint8_t hops)
+{
+    for (uint8_t i = 0; i < m_count; ++i) {
+        if (m_routes[i].serial == serial) {
+            m_routes[i].link = link;
+            m_routes[i].hops = hops;
+            return true;
+        }
+    }
+
+    if (m_count == HERMES_MAX_ROUTES) {
+        HM_ERR("Routing table is full");
+        return false;
+    }
+
+    m_routes[m_count].serial = serial;
+    m_routes[m_count].link = link;
+    m_routes[m_count].hops = hops;
+    ++m_count;
+    return true;
+}
+
+bool Router::removeRoute(const serial_t& serial)
+{
+    for (uint8_t i = 0; i < m_count; ++i) {
+        if (m_routes[i].serial == serial) {
+            m_routes[i] = m_routes[--m_count];
+            return true;
+        }
+    }
+    return false;
+}
+
+uint8_t Router::discover(IO* link, const serial_t& proxy)
+{
+    Message req{};
+    Message rsp;
+    MessageBuilder::setSerial(req, proxy.data);
+    memset(req.token, 0, sizeof(req.token));
+    req.type = MessageType::Command;
+    req.payload.command.command = Command::GetRoutesCount;
+    req.payloadLength = sizeof(CommandData);
+
+    if (!link->write(req) || !link->read(rsp)
+        || rsp.type != MessageType::Command || rsp.payload.command.command != Command::GetRoutesCount) {
+        HM_WARN("Can't get routes from downstream proxy");
+        return 0;
+    }
+
+    uint8_t added = 0;
+    const uint8_t count = rsp.payload.command.data.count;
+    for (uint8_t i = 0; i < count; ++i) {
+        req.payload.command.command = Command::GetRoute;
+        req.payload.command.data.index = i;
+        if (!link->write(req) || !link->read(rsp))
+            break;
+        if (rsp.type != MessageType::Command || rsp.payload.command.command != Command::GetRoute)
+            continue;
+        if (addRoute(rsp.payload.command.data.route.serial, link, rsp.payload.command.data.route.hops + 1))
+            ++added;
+    }
+    return added;
+}
+
+IO* Router::find(const byte_t* serial) const
+{
+    for (uint8_t i = 0; i < m_count; ++i) {
+        if (m_routes[i].serial == serial)
+            return m_routes[i].link;
+    }
+    return nullptr;
+}
+
+bool Router::forward(const Message& frame, IO* upstream)
+{
+    IO* link = find(frame.serial);
+    if (link == nullptr)
+        return false;
+
+    if (!link->write(frame)) {
+        HM_WARN("Forwarding to downstream link failed");
+        return false;
+    }
+
+    // Disconnect has no response
+    if (frame.type == MessageType::Command && frame.payload.command.command == Command::Disconnect)
+        return true;
+
+    // Updates queued by subscriptions come first, pass them on as well
+    Message rsp;
+    do {
+        if (!link->read(rsp)) {
+            HM_WARN("No response from downstream link");
+            return false;
+        }
+        if (!upstream->write(rsp))
+            return false;
+    } while (rsp.type == MessageType::Command && rsp.payload.command.command == Command::Update);
+    return true;
+}
+
+bool Router::broadcast(const Message& frame, GroupAckData* ack)
+{
+    bool ok = true;
+    for (uint8_t i = 0; i < m_count; ++i) {
+        IO* link = m_routes[i].link;
+        uint16_t responders = 0;
+        bool sent = false;
+        for (uint8_t j = 0; j < m_count; ++j) {
+            if (m_routes[j].link != link)
+                continue;
+            if (j < i)
+                sent = true;
+            if (m_routes[j].hops == 1)
+                ++responders;
+        }
+        if (sent)
+            continue;
+
+        if (!link->write(frame)) {
+            HM_WARN("Broadcasting to downstream link failed");
+            ok = false;
+            continue;
+        }
+
+        if (ack == nullptr)
+            continue;
+
+        // Only slaves behind a proxy are known, proxy answers for them
+        if (responders == 0)
+            responders = 1;
+
+        while (responders > 0) {
+            Message rsp;
+            if (!link->read(rsp)) {
+                HM_WARN("Missing group acknowledgements from downstream link");
+                ok = false;
+                break;
+            }
+            if (rsp.type != MessageType::Command || rsp.payload.command.command != Command::GroupSet) {
+                HM_WARN("Unexpected frame while waiting for group acknowledgements");
+                continue;
+            }
+            ack->applied += rsp.payload.command.data.ack.applied;
+            ack->failed += rsp.payload.command.data.ack.failed;
+            --responders;
+        }
+    }
+    return ok;
+}
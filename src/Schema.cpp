@@ -0,0 +1,191 @@
+/**
+ * Hermes - A RPC for IOT
+ * Copyright (C) 2023  Eduard Sargsyan and Andrey Ovodov
+ * 
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ * 
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ * 
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#include <hermes/Schema.h>
+
+#include <string.h>
+
+using namespace hermes;
+
+uint32_t hermes::schemaHash(const PropertySchema* properties, uint8_t count)
+{
+    SchemaHasher hasher(count);
+    for (uint8_t i = 0; i < count; ++i)
+        hasher.add(properties[i].name, properties[i].type);
+    return hasher.value();
+}
+
+bool SlaveSchema::count(uint8_t& count) const
+{
+    #ifdef HAS_STD_MUTEX
+    std::lock_guard<std::mutex> lock(m_mx);
+    #endif // HAS_STD_MUTEX
+    if (!m_counted)
+        return false;
+    count = static_cast<uint8_t>(m_entries.size());
+    return true;
+}
+
+void SlaveSchema::setCount(uint8_t count)
+{
+    #ifdef HAS_STD_MUTEX
+    std::lock_guard<std::mutex> lock(m_mx);
+    #endif // HAS_STD_MUTEX
+    m_entries.resize(count);
+    m_counted = true;
+}
+
+bool SlaveSchema::name(uint8_t property, char* name) const
+{
+    #ifdef HAS_STD_MUTEX
+    std::lock_guard<std::mutex> lock(m_mx);
+    #endif // HAS_STD_MUTEX
+    if (property >= m_entries.size() || !m_entries[property].named)
+        return false;
+    strcpy(name, m_entries[property].property.name);
+    return true;
+}
+
+void SlaveSchema::setName(uint8_t property, const char* name)
+{
+    #ifdef HAS_STD_MUTEX
+    std::lock_guard<std::mutex> lock(m_mx);
+    #endif // HAS_STD_MUTEX
+    if (property >= m_entries.size())
+    {
+        // Count is not known yet, or slave has more properties than it said
+        if (m_counted)
+            return;
+        m_entries.resize(property + 1);
+    }
+    Entry& e = m_entries[property];
+    strncpy(e.property.name, name, sizeof(e.property.name) - 1);
+    e.property.name[sizeof(e.property.name) - 1] = '\0';
+    e.named = true;
+}
+
+int16_t SlaveSchema::index(const char* name) const
+{
+    #ifdef HAS_STD_MUTEX
+    std::lock_guard<std::mutex> lock(m_mx);
+    #endif // HAS_STD_MUTEX
+    for (size_t i = 0; i < m_entries.size(); ++i)
+    {
+        if (m_entries[i].named && strcmp(m_entries[i].property.name, name) == 0)
+            return static_cast<int16_t>(i);
+    }
+    return -1;
+}
+
+bool SlaveSchema::type(uint8_t property, ValueType& type) const
+{
+    #ifdef HAS_STD_MUTEX
+    std::lock_guard<std::mutex> lock(m_mx);
+    #endif // HAS_STD_MUTEX
+    if (property >= m_entries.size() || !m_entries[property].typed)
+        return false;
+    type = m_entries[property].property.type;
+    return true;
+}
+
+void SlaveSchema::setType(uint8_t property, ValueType type)
+{
+    #ifdef HAS_STD_MUTEX
+    std::lock_guard<std::mutex> lock(m_mx);
+    #endif // HAS_STD_MUTEX
+    if (property >= m_entries.size())
+    {
+        if (m_counted)
+            return;
+        m_entries.resize(property + 1);
+    }
+    m_entries[property].property.type = type;
+    m_entries[property].typed = true;
+}
+
+bool SlaveSchema::complete() const
+{
+    #ifdef HAS_STD_MUTEX
+    std::lock_guard<std::mutex> lock(m_mx);
+    #endif // HAS_STD_MUTEX
+    return completeLocked();
+}
+
+uint32_t SlaveSchema::hash() const
+{
+    #ifdef HAS_STD_MUTEX
+    std::lock_guard<std::mutex> lock(m_mx);
+    #endif // HAS_STD_MUTEX
+    if (!completeLocked())
+        return 0;
+
+    std::vector<PropertySchema> table;
+    table.reserve(m_entries.size());
+    for (const Entry& e : m_entries)
+        table.push_back(e.property);
+    return schemaHash(table.data(), static_cast<uint8_t>(table.size()));
+}
+
+std::vector<PropertySchema> SlaveSchema::properties() const
+{
+    #ifdef HAS_STD_MUTEX
+    std::lock_guard<std::mutex> lock(m_mx);
+    #endif // HAS_STD_MUTEX
+    std::vector<PropertySchema> table;
+    if (!completeLocked())
+        return table;
+    table.reserve(m_entries.size());
+    for (const Entry& e : m_entries)
+        table.push_back(e.property);
+    return table;
+}
+
+void SlaveSchema::assign(const std::vector<PropertySchema>& properties)
+{
+    #ifdef HAS_STD_MUTEX
+    std::lock_guard<std::mutex> lock(m_mx);
+    #endif // HAS_STD_MUTEX
+    m_entries.resize(properties.size());
+    for (size_t i = 0; i < properties.size(); ++i)
+    {
+        m_entries[i].property = properties[i];
+        m_entries[i].named = m_entries[i].typed = true;
+    }
+    m_counted = true;
+}
+
+void SlaveSchema::clear()
+{
+    #ifdef HAS_STD_MUTEX
+    std::lock_guard<std::mutex> lock(m_mx);
+    #endif // HAS_STD_MUTEX
+    m_entries.clear();
+    m_counted = false;
+}
+
+bool SlaveSchema::completeLocked() const
+{
+    if (!m_counted)
+        return false;
+    for (const Entry& e : m_entries)
+    {
+        if (!e.named || !e.typed)
+            return false;
+    }
+    return true;
+}
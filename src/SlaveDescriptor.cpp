@@ -22,30 +22,66 @@
 #include <hermes/Message.h>
 #include <hermes/Config.h>
 
+#ifdef HAS_STD_THREAD_H
+#include <chrono>
+#endif // HAS_STD_THREAD_H
+
 using namespace hermes;
 
+namespace
+{
+    uint32_t millis()
+    {
+        #ifdef HAS_STD_THREAD_H
+        using namespace std::chrono;
+        return static_cast<uint32_t>(duration_cast<milliseconds>(steady_clock::now().time_since_epoch()).count());
+        #else
+        return 0;
+        #endif // HAS_STD_THREAD_H
+    }
+
+    inline bool isUpdate(const Message& msg)
+    {
+        return msg.type == MessageType::Command && msg.payload.command.command == Command::Update;
+    }
+} // namespace
+
 SlaveDescriptor::SlaveDescriptor(IO* io, serial_t serial)
     : m_io(io)
     , m_serial(serial)
+    #ifdef HAS_STD_MUTEX
+    , m_requestMx(std::make_shared<std::mutex>())
+    #endif // HAS_STD_MUTEX
 {}
 
 uint8_t SlaveDescriptor::propertiesCount()
 {
-    Message req;
+    uint8_t count;
+    if (m_schema.count(count))
+        return count;
+
+    Message req{};
     MessageBuilder::setSerial(req, m_serial.data);
     MessageBuilder::setToken(req, m_token.data);
     req.type = MessageType::Command;
     req.payload.command.command = Command::GetPropertiesCount;
     req.payloadLength = sizeof(CommandData);
     Message resp = makeRequest(req);
-    return (resp.type == MessageType::Command && resp.payload.command.command == Command::GetPropertiesCount)
-            ? resp.payload.command.data.count
-            : 0;
+    if (resp.type != MessageType::Command || resp.payload.command.command != Command::GetPropertiesCount)
+        return 0;
+
+    count = resp.payload.command.data.count;
+    m_schema.setCount(count);
+    learned();
+    return count;
 }
 
 bool SlaveDescriptor::propertyName(uint8_t index, char* name)
 {
-    Message req;
+    if (m_schema.name(index, name))
+        return true;
+
+    Message req{};
     MessageBuilder::setSerial(req, m_serial.data);
     MessageBuilder::setToken(req, m_token.data);
     req.type = MessageType::Command;
@@ -55,6 +91,8 @@ bool SlaveDescriptor::propertyName(uint8_t index, char* name)
     Message resp = makeRequest(req);
     if (resp.type == MessageType::Command && resp.payload.command.command == Command::GetPropertyName) {
         strcpy(name, resp.payload.command.data.string);
+        m_schema.setName(index, name);
+        learned();
         return true;
     }
     return false;
@@ -71,10 +109,15 @@ std::string SlaveDescriptor::propertyName(uint8_t idx)
 
 int8_t SlaveDescriptor::propertyIndex(const char* name)
 {
-    static char tmpName[HERMES_PROPERTY_NAME_MAX_LENGTH];
-    for(int8_t i = 0; i < propertiesCount(); ++i)
+    const int16_t known = m_schema.index(name);
+    if (known >= 0 && known <= INT8_MAX)
+        return static_cast<int8_t>(known);
+
+    char tmpName[HERMES_PROPERTY_NAME_MAX_LENGTH];
+    const uint8_t count = propertiesCount();
+    for(uint8_t i = 0; i < count && i <= INT8_MAX; ++i)
     {
-        if(!propertyName(i, tmpName))
+        if(!nameOf(i, tmpName))
             continue;
 
         if(0 == strcmp(name, tmpName))
@@ -87,6 +130,10 @@ int8_t SlaveDescriptor::propertyIndex(const char* name)
 
 ValueType SlaveDescriptor::propertyType(uint8_t index)
 {
+    ValueType type;
+    if (m_schema.type(index, type))
+        return type;
+
     ValueData vt;
     if (get(index, vt))
     {
@@ -97,28 +144,128 @@ ValueType SlaveDescriptor::propertyType(uint8_t index)
 
 bool SlaveDescriptor::set(uint8_t property, const ValueData& value)
 {
-    Message req;
+    if (m_combineWindow == 0) {
+        ValueData applied;
+        return write(property, value, applied);
+    }
+
+    {
+        #ifdef HAS_STD_MUTEX
+        std::lock_guard<std::mutex> lock(m_setsMx);
+        #endif // HAS_STD_MUTEX
+        ++m_writeStats.queued;
+        bool queued = false;
+        for (auto& pending : m_pendingSets) {
+            if (pending.property == property) {
+                pending.value = value;
+                ++m_writeStats.combined;
+                queued = true;
+                break;
+            }
+        }
+        if (!queued)
+            m_pendingSets.push_back({ property, millis() + m_combineWindow, value });
+    }
+
+    flushSets();
+    return true;
+}
+
+bool SlaveDescriptor::write(uint8_t property, const ValueData& value, ValueData& applied)
+{
+    Message req{};
     MessageBuilder::setSerial(req, m_serial.data);
     MessageBuilder::setToken(req, m_token.data);
     req.type = MessageType::Command;
     req.payload.command.command = Command::Set;
-    if(!propertyName(property, req.payload.command.data.get.name))
+    if(!nameOf(property, req.payload.command.data.get.name))
         return false;
 
     req.payload.command.data.value = value;
     req.payloadLength = sizeof(CommandData);
+    const uint32_t now = millis();
     Message resp = makeRequest(req);
-    return resp.type == MessageType::Command && resp.payload.command.command == Command::Set;
+    {
+        #ifdef HAS_STD_MUTEX
+        std::lock_guard<std::mutex> lock(m_setsMx);
+        #endif // HAS_STD_MUTEX
+        ++m_writeStats.sent;
+    }
+
+    // Slave answers with the value it applied, which may differ from ours
+    if (resp.type != MessageType::Command || resp.payload.command.command != Command::Set) {
+        m_cache.invalidate(property);
+        return false;
+    }
+    applied = resp.payload.command.data.value;
+    m_cache.store(property, now, applied);
+    record(property, applied);
+    return true;
+}
+
+uint8_t SlaveDescriptor::flushSets(bool all)
+{
+    // One flush at a time, so values of a property are written in the order
+    // they were set. Others leave due sets to the running flush, which looks
+    // for them again after every write, except when asked to send all.
+    #ifdef HAS_STD_MUTEX
+    std::unique_lock<std::recursive_mutex> flushing(m_flushMx, std::defer_lock);
+    if (all)
+        flushing.lock();
+    else if (!flushing.try_lock())
+        return 0;
+    #endif // HAS_STD_MUTEX
+
+    uint8_t sent = 0;
+    const uint32_t now = millis();
+    for (;;) {
+        PendingSet pending;
+        {
+            #ifdef HAS_STD_MUTEX
+            std::lock_guard<std::mutex> lock(m_setsMx);
+            #endif // HAS_STD_MUTEX
+            auto it = m_pendingSets.begin();
+            while (it != m_pendingSets.end() && !all && int32_t(now - it->deadline) < 0)
+                ++it;
+            if (it == m_pendingSets.end())
+                break;
+            pending = *it;
+            m_pendingSets.erase(it);
+        }
+
+        ValueData applied;
+        const bool ok = write(pending.property, pending.value, applied);
+        completed(pending.property, ok ? applied : pending.value, ok);
+        ++sent;
+    }
+    return sent;
+}
+
+void SlaveDescriptor::dropSets()
+{
+    std::vector<PendingSet> dropped;
+    {
+        #ifdef HAS_STD_MUTEX
+        std::lock_guard<std::mutex> lock(m_setsMx);
+        #endif // HAS_STD_MUTEX
+        dropped.swap(m_pendingSets);
+    }
+    for (const auto& pending : dropped)
+        completed(pending.property, pending.value, false);
 }
 
 bool SlaveDescriptor::get(uint8_t property, ValueData& value)
 {
-    Message req;
+    const uint32_t now = millis();
+    if (m_cache.lookup(property, now, value))
+        return true;
+
+    Message req{};
     MessageBuilder::setSerial(req, m_serial.data);
     MessageBuilder::setToken(req, m_token.data);
     req.type = MessageType::Command;
     req.payload.command.command = Command::Get;
-    if(!propertyName(property, req.payload.command.data.get.name))
+    if(!nameOf(property, req.payload.command.data.get.name))
         return false;
     
     req.payloadLength = sizeof(CommandData);
@@ -127,38 +274,238 @@ bool SlaveDescriptor::get(uint8_t property, ValueData& value)
     if(resp.type == MessageType::Command && resp.payload.command.command == Command::Get)
     {
         value = resp.payload.command.data.value;
+        m_cache.store(property, now, value);
+        record(property, value);
+        ValueType known;
+        if (!m_schema.type(property, known)) {
+            m_schema.setType(property, value.type);
+            learned();
+        }
+        return true;
+    }
+    return false;
+}
+
+uint8_t SlaveDescriptor::routesCount()
+{
+    Message req{};
+    MessageBuilder::setSerial(req, m_serial.data);
+    MessageBuilder::setToken(req, m_token.data);
+    req.type = MessageType::Command;
+    req.payload.command.command = Command::GetRoutesCount;
+    req.payloadLength = sizeof(CommandData);
+    Message resp = makeRequest(req);
+    return (resp.type == MessageType::Command && resp.payload.command.command == Command::GetRoutesCount)
+            ? resp.payload.command.data.count
+            : 0;
+}
+
+bool SlaveDescriptor::route(uint8_t index, serial_t& serial, uint8_t& hops)
+{
+    Message req{};
+    MessageBuilder::setSerial(req, m_serial.data);
+    MessageBuilder::setToken(req, m_token.data);
+    req.type = MessageType::Command;
+    req.payload.command.command = Command::GetRoute;
+    req.payload.command.data.index = index;
+    req.payloadLength = sizeof(CommandData);
+    Message resp = makeRequest(req);
+    if (resp.type == MessageType::Command && resp.payload.command.command == Command::GetRoute) {
+        serial = resp.payload.command.data.route.serial;
+        hops = resp.payload.command.data.route.hops;
         return true;
     }
     return false;
 }
 
+bool SlaveDescriptor::subscribe(uint8_t property, float deadband, uint16_t minInterval, uint16_t maxInterval)
+{
+    Message req{};
+    MessageBuilder::setSerial(req, m_serial.data);
+    MessageBuilder::setToken(req, m_token.data);
+    req.type = MessageType::Command;
+    req.payload.command.command = Command::Subscribe;
+    if (!nameOf(property, req.payload.command.data.subscribe.name))
+        return false;
+
+    req.payload.command.data.subscribe.deadband.V = (int32_t) (deadband * 1000);
+    req.payload.command.data.subscribe.deadband.Precision = 1000;
+    req.payload.command.data.subscribe.minInterval = minInterval;
+    req.payload.command.data.subscribe.maxInterval = maxInterval;
+    req.payloadLength = sizeof(CommandData);
+    Message resp = makeRequest(req);
+    if (resp.type != MessageType::Command || resp.payload.command.command != Command::Subscribe)
+        return false;
+
+    notify(resp.payload.command.data.value);
+    return true;
+}
+
+bool SlaveDescriptor::unsubscribe(uint8_t property)
+{
+    Message req{};
+    MessageBuilder::setSerial(req, m_serial.data);
+    MessageBuilder::setToken(req, m_token.data);
+    req.type = MessageType::Command;
+    req.payload.command.command = Command::Unsubscribe;
+    if (!nameOf(property, req.payload.command.data.subscribe.name))
+        return false;
+
+    req.payloadLength = sizeof(CommandData);
+    Message resp = makeRequest(req);
+    return resp.type == MessageType::Command && resp.payload.command.command == Command::Unsubscribe;
+}
+
+uint8_t SlaveDescriptor::poll()
+{
+    flushSets();
+
+    // Updates are delivered once the request lock is released, callbacks
+    // posted while holding it could wait for executor jobs waiting for it
+    std::vector<ValueData> updates;
+    {
+        #ifdef HAS_STD_MUTEX
+        // A request in progress handles updates itself
+        std::unique_lock<std::mutex> lock(*m_requestMx, std::try_to_lock);
+        if (!lock.owns_lock())
+            return 0;
+        #endif // HAS_STD_MUTEX
+        m_io->drain();
+        while (m_io->good() && m_io->available() >= sizeof(Message)) {
+            Message msg;
+            if (!m_io->read(msg))
+                break;
+            if (isUpdate(msg))
+                updates.push_back(msg.payload.command.data.value);
+            else
+                HM_WARN("Unexpected %s from slave", mt2str(msg.type));
+        }
+    }
+
+    for (const auto& value : updates)
+        notify(value);
+    return static_cast<uint8_t>(updates.size());
+}
+
+bool SlaveDescriptor::handle(Message& msg)
+{
+    if (!isUpdate(msg))
+        return false;
+
+    notify(msg.payload.command.data.value);
+    return true;
+}
+
+void SlaveDescriptor::notify(const ValueData& value)
+{
+    uint8_t property;
+    if (m_cache.push(millis(), value, &property))
+        record(property, value);
+
+    if (m_on_update == nullptr)
+        return;
+
+    if (m_executor == nullptr) {
+        (*m_on_update)(this, value);
+        return;
+    }
+
+    on_update_fn_t callback = m_on_update;
+    m_executor->post(this, [this, callback, value]() { (*callback)(this, value); });
+}
+
+void SlaveDescriptor::record(uint8_t property, const ValueData& value)
+{
+    #ifdef HAS_LINUX_HEADERS
+    if (m_journal != nullptr)
+        m_journal->append(m_serial, property, value);
+    #endif // HAS_LINUX_HEADERS
+}
+
+void SlaveDescriptor::learned()
+{
+    if (m_registry != nullptr && m_schema.complete())
+        m_registry->setSchema(m_serial, m_schema.properties());
+}
+
+void SlaveDescriptor::completed(uint8_t property, const ValueData& applied, bool ok)
+{
+    if (m_on_set == nullptr)
+        return;
+
+    if (m_executor == nullptr) {
+        (*m_on_set)(this, property, applied, ok);
+        return;
+    }
+
+    on_set_fn_t callback = m_on_set;
+    m_executor->post(this, [this, callback, property, applied, ok]() { (*callback)(this, property, applied, ok); });
+}
+
+bool SlaveDescriptor::nameOf(uint8_t property, char* name)
+{
+    if (m_cache.name(property, name))
+        return true;
+
+    if (!propertyName(property, name))
+        return false;
+
+    m_cache.setName(property, name);
+    return true;
+}
+
 Message SlaveDescriptor::makeRequest(const Message& msg)
 {
-    m_rsp.type = MessageType::Error;
-    m_rsp.payload.error.e = ErrorType::Fail;
-    static uint8_t errLen = strlen("Request failed\0");
-    memcpy(m_rsp.payload.error.msg, "Request failed\0", errLen);
-    if(m_io->write(msg))
+    Message rsp{};
+    rsp.type = MessageType::Error;
+    MessageBuilder::setError(rsp, ErrorType::Fail, "Request failed");
+
+    // Updates coming in before the response are delivered once the lock is
+    // released, see poll()
+    std::vector<ValueData> updates;
     {
-        memset(&m_rsp, 0, sizeof(m_rsp));
-        if(!m_io->read(m_rsp)) {
-            HM_ERR("Failed to get response for request %s", mt2str(msg.type));
+        #ifdef HAS_STD_MUTEX
+        std::lock_guard<std::mutex> lock(*m_requestMx);
+        #endif // HAS_STD_MUTEX
+        if(m_io->write(msg))
+        {
+            bool received = false;
+            for (;;) {
+                memset(&rsp, 0, sizeof(rsp));
+                received = m_io->read(rsp);
+                if (!received || !isUpdate(rsp))
+                    break;
+                updates.push_back(rsp.payload.command.data.value);
+            }
+
+            if(!received) {
+                HM_ERR("Failed to get response for request %s", mt2str(msg.type));
+                MessageBuilder::setError(rsp, ErrorType::Fail, "Request failed");
+            }
+        } else{
+            HM_ERR("Sending request %s to client failed", mt2str(msg.type));
         }
-    } else{
-        HM_ERR("Sending request %s to client failed", mt2str(msg.type));
     }
-    return m_rsp;
+
+    for (const auto& value : updates)
+        notify(value);
+    return rsp;
 }
 
 void SlaveDescriptor::close()
 {
-    Message req;
+    flushSets(true);
+
+    Message req{};
     MessageBuilder::setSerial(req, m_serial.data);
     MessageBuilder::setToken(req, m_token.data);
     req.type = MessageType::Command;
     req.payload.command.command = Command::Disconnect;
     req.payloadLength = sizeof(CommandData);
 
+    #ifdef HAS_STD_MUTEX
+    std::lock_guard<std::mutex> lock(*m_requestMx);
+    #endif // HAS_STD_MUTEX
     m_io->write(req);
     m_io->close();
 }
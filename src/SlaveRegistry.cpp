@@ -0,0 +1,257 @@
+/**
+ * Hermes - A RPC for IOT
+ * Copyright (C) 2023  Eduard Sargsyan and Andrey Ovodov
+ * 
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ * 
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ * 
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#include <hermes/SlaveRegistry.h>
+#include <hermes/Crc32c.h>
+
+#include <stdio.h>
+#include <string.h>
+
+using namespace hermes;
+
+namespace
+{
+    constexpr char Magic[4] = { 'H', 'M', 'R', 'S' };
+    constexpr uint16_t Version = 1;
+
+    struct Header
+    {
+        char magic[4];
+        uint16_t version;
+        uint8_t serialLength;
+        uint8_t tokenLength;
+        uint32_t count;
+        uint32_t checksum;
+    } __attribute__((packed));
+
+    template<typename T>
+    void put(std::vector<byte_t>& out, const T& value)
+    {
+        const byte_t* data = reinterpret_cast<const byte_t*>(&value);
+        out.insert(out.end(), data, data + sizeof(T));
+    }
+
+    /**
+     * Bounds checked reader of a snapshot
+    */
+    struct Reader
+    {
+        const byte_t* pos;
+        const byte_t* end;
+
+        bool take(void* dst, size_t length)
+        {
+            if (size_t(end - pos) < length)
+                return false;
+            memcpy(dst, pos, length);
+            pos += length;
+            return true;
+        }
+    };
+} // namespace
+
+bool SlaveRegistry::load(const char* path)
+{
+    FILE* file = fopen(path, "rb");
+    if (file == nullptr)
+        return false;
+
+    std::vector<byte_t> data;
+    byte_t chunk[4096];
+    size_t read;
+    while ((read = fread(chunk, 1, sizeof(chunk), file)) > 0)
+        data.insert(data.end(), chunk, chunk + read);
+    fclose(file);
+
+    Header header;
+    Reader in { data.data(), data.data() + data.size() };
+    if (!in.take(&header, sizeof(header))
+        || memcmp(header.magic, Magic, sizeof(Magic)) != 0
+        || header.version != Version
+        || header.serialLength != HERMES_SERIAL_LENGTH
+        || header.tokenLength != HERMES_TOKEN_LENGTH
+        || header.checksum != crc32c(in.pos, in.end - in.pos))
+    {
+        HM_WARN("Registry snapshot %s is not valid", path);
+        return false;
+    }
+
+    std::map<std::string, RegistryEntry> entries;
+    for (uint32_t i = 0; i < header.count; ++i)
+    {
+        RegistryEntry e;
+        uint8_t count;
+        if (!in.take(e.serial.data, HERMES_SERIAL_LENGTH)
+            || !in.take(e.token.data, HERMES_TOKEN_LENGTH)
+            || !in.take(&e.schemaHash, sizeof(e.schemaHash))
+            || !in.take(&count, sizeof(count)))
+        {
+            HM_WARN("Registry snapshot %s has a truncated entry %u", path, i);
+            return false;
+        }
+
+        e.properties.resize(count);
+        for (PropertySchema& property : e.properties)
+        {
+            uint8_t length;
+            if (!in.take(&length, sizeof(length)) || length >= sizeof(property.name)
+                || !in.take(property.name, length) || !in.take(&property.type, sizeof(property.type)))
+            {
+                HM_WARN("Registry snapshot %s has a bad property in entry %u", path, i);
+                return false;
+            }
+            property.name[length] = '\0';
+        }
+        entries[key(e.serial)] = e;
+    }
+
+    #ifdef HAS_STD_MUTEX
+    std::lock_guard<std::mutex> lock(m_mx);
+    #endif // HAS_STD_MUTEX
+    m_entries.swap(entries);
+    m_dirty = false;
+    HM_INFO("Loaded %zu slaves from %s", m_entries.size(), path);
+    return true;
+}
+
+bool SlaveRegistry::save(const char* path) const
+{
+    std::vector<byte_t> data(sizeof(Header));
+    Header header{};
+    memcpy(header.magic, Magic, sizeof(Magic));
+    header.version = Version;
+    header.serialLength = HERMES_SERIAL_LENGTH;
+    header.tokenLength = HERMES_TOKEN_LENGTH;
+    {
+        #ifdef HAS_STD_MUTEX
+        std::lock_guard<std::mutex> lock(m_mx);
+        #endif // HAS_STD_MUTEX
+        for (const auto& it : m_entries)
+        {
+            const RegistryEntry& e = it.second;
+            data.insert(data.end(), e.serial.data, e.serial.data + HERMES_SERIAL_LENGTH);
+            data.insert(data.end(), e.token.data, e.token.data + HERMES_TOKEN_LENGTH);
+            put(data, e.schemaHash);
+            put(data, static_cast<uint8_t>(e.properties.size()));
+            for (const PropertySchema& property : e.properties)
+            {
+                const uint8_t length = static_cast<uint8_t>(strnlen(property.name, sizeof(property.name) - 1));
+                put(data, length);
+                data.insert(data.end(), property.name, property.name + length);
+                put(data, property.type);
+            }
+        }
+        header.count = static_cast<uint32_t>(m_entries.size());
+        m_dirty = false;
+    }
+    header.checksum = crc32c(data.data() + sizeof(Header), data.size() - sizeof(Header));
+    memcpy(data.data(), &header, sizeof(header));
+
+    const std::string tmp = std::string(path) + ".tmp";
+    FILE* file = fopen(tmp.c_str(), "wb");
+    bool written = file != nullptr && fwrite(data.data(), 1, data.size(), file) == data.size();
+    if (file != nullptr)
+        written = fclose(file) == 0 && written;
+    if (!written || rename(tmp.c_str(), path) != 0)
+    {
+        HM_ERR("Can't write registry snapshot %s", path);
+        remove(tmp.c_str());
+        #ifdef HAS_STD_MUTEX
+        std::lock_guard<std::mutex> lock(m_mx);
+        #endif // HAS_STD_MUTEX
+        m_dirty = true;
+        return false;
+    }
+    return true;
+}
+
+void SlaveRegistry::remember(const serial_t& serial, const token_t& token)
+{
+    #ifdef HAS_STD_MUTEX
+    std::lock_guard<std::mutex> lock(m_mx);
+    #endif // HAS_STD_MUTEX
+    RegistryEntry& e = entry(serial);
+    if (e.token == token)
+        return;
+    e.token = token;
+    m_dirty = true;
+}
+
+void SlaveRegistry::setSchema(const serial_t& serial, const std::vector<PropertySchema>& properties)
+{
+    const uint32_t hash = schemaHash(properties.data(), static_cast<uint8_t>(properties.size()));
+
+    #ifdef HAS_STD_MUTEX
+    std::lock_guard<std::mutex> lock(m_mx);
+    #endif // HAS_STD_MUTEX
+    RegistryEntry& e = entry(serial);
+    if (e.schemaHash == hash)
+        return;
+    e.schemaHash = hash;
+    e.properties = properties;
+    m_dirty = true;
+}
+
+bool SlaveRegistry::find(const serial_t& serial, RegistryEntry& entry) const
+{
+    #ifdef HAS_STD_MUTEX
+    std::lock_guard<std::mutex> lock(m_mx);
+    #endif // HAS_STD_MUTEX
+    auto it = m_entries.find(key(serial));
+    if (it == m_entries.end())
+        return false;
+    entry = it->second;
+    return true;
+}
+
+void SlaveRegistry::forget(const serial_t& serial)
+{
+    #ifdef HAS_STD_MUTEX
+    std::lock_guard<std::mutex> lock(m_mx);
+    #endif // HAS_STD_MUTEX
+    if (m_entries.erase(key(serial)) != 0)
+        m_dirty = true;
+}
+
+size_t SlaveRegistry::size() const
+{
+    #ifdef HAS_STD_MUTEX
+    std::lock_guard<std::mutex> lock(m_mx);
+    #endif // HAS_STD_MUTEX
+    return m_entries.size();
+}
+
+bool SlaveRegistry::dirty() const
+{
+    #ifdef HAS_STD_MUTEX
+    std::lock_guard<std::mutex> lock(m_mx);
+    #endif // HAS_STD_MUTEX
+    return m_dirty;
+}
+
+std::string SlaveRegistry::key(const serial_t& serial)
+{
+    return std::string(reinterpret_cast<const char*>(serial.data), HERMES_SERIAL_LENGTH);
+}
+
+RegistryEntry& SlaveRegistry::entry(const serial_t& serial)
+{
+    RegistryEntry& e = m_entries[key(serial)];
+    e.serial = serial;
+    return e;
+}
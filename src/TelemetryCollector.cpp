@@ -0,0 +1,250 @@
+/**
+ * Hermes - A RPC for IOT
+ * Copyright (C) 2023  Eduard Sargsyan and Andrey Ovodov
+ * 
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ * 
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ * 
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#include <hermes/TelemetryCollector.h>
+#include <hermes/SlaveDescriptor.h>
+
+#include <string.h>
+
+#if defined(__BYTE_ORDER__) && __BYTE_ORDER__ != __ORDER_LITTLE_ENDIAN__
+#error "TelemetryCollector writes columns in host order, which must be little endian"
+#endif
+
+using namespace hermes;
+
+namespace
+{
+    constexpr size_t Alignment = 8;
+
+    template<typename T>
+    void append(std::vector<byte_t>& block, const T& value)
+    {
+        const byte_t* data = reinterpret_cast<const byte_t*>(&value);
+        block.insert(block.end(), data, data + sizeof(T));
+    }
+
+    template<typename T>
+    void put(std::vector<byte_t>& block, size_t offset, const T& value)
+    {
+        memcpy(block.data() + offset, &value, sizeof(T));
+    }
+} // namespace
+
+FileTelemetrySink::FileTelemetrySink(const char* path)
+    : m_file(fopen(path, "ab"))
+{
+    if (m_file == nullptr)
+        HM_ERR("Can't open telemetry file %s", path);
+}
+
+FileTelemetrySink::~FileTelemetrySink()
+{
+    if (m_file != nullptr)
+        fclose(m_file);
+}
+
+bool FileTelemetrySink::write(const byte_t* data, size_t length)
+{
+    if (m_file == nullptr)
+        return false;
+    if (fwrite(data, 1, length, m_file) != length)
+    {
+        HM_ERR("Can't write telemetry block of %zu bytes", length);
+        return false;
+    }
+    return fflush(m_file) == 0;
+}
+
+TelemetryCollector::TelemetryCollector(TelemetrySink* sink, size_t batch)
+    : m_sink(sink)
+    , m_batch(batch == 0 ? 1 : batch)
+{
+}
+
+TelemetryCollector::~TelemetryCollector()
+{
+    flush();
+}
+
+bool TelemetryCollector::add(const serial_t& serial, uint8_t property, uint64_t timestamp, const ValueData& value)
+{
+    #ifdef HAS_STD_MUTEX
+    std::lock_guard<std::mutex> lock(m_mx);
+    #endif // HAS_STD_MUTEX
+
+    uint8_t type = value.type;
+    if (type >= TypesCount)
+    {
+        ++m_stats.dropped;
+        return false;
+    }
+
+    Group& group = m_groups[type];
+    group.serials.insert(group.serials.end(), serial.data, serial.data + HERMES_SERIAL_LENGTH);
+    group.properties.push_back(property);
+    group.timestamps.push_back(timestamp);
+    switch (value.type)
+    {
+    case ValueType::Boolean:
+        group.values.push_back(value.value.B);
+        break;
+    case ValueType::Integer:
+        append(group.values, int32_t(value.value.I));
+        break;
+    case ValueType::UnsignedInteger:
+        append(group.values, uint32_t(value.value.U));
+        break;
+    case ValueType::Float:
+        append(group.values, int32_t(value.value.F.V));
+        group.precisions.push_back(value.value.F.Precision);
+        break;
+    case ValueType::String:
+    {
+        if (group.offsets.empty())
+            group.offsets.push_back(0);
+        size_t length = strnlen(value.value.S, sizeof(value.value.S));
+        group.values.insert(group.values.end(), value.value.S, value.value.S + length);
+        group.offsets.push_back(uint32_t(group.values.size()));
+        break;
+    }
+    }
+    ++group.rows;
+
+    if (++m_rows >= m_batch)
+        return flushLocked();
+    return true;
+}
+
+uint8_t TelemetryCollector::collect(SlaveDescriptor& slave, uint64_t timestamp)
+{
+    uint8_t count = slave.propertiesCount();
+    uint8_t added = 0;
+    ValueData value;
+    for (uint8_t i = 0; i < count; ++i)
+    {
+        if (slave.get(i, value) && add(slave.serial(), i, timestamp, value))
+            ++added;
+    }
+    return added;
+}
+
+bool TelemetryCollector::flush()
+{
+    #ifdef HAS_STD_MUTEX
+    std::lock_guard<std::mutex> lock(m_mx);
+    #endif // HAS_STD_MUTEX
+    return flushLocked();
+}
+
+size_t TelemetryCollector::pending() const
+{
+    #ifdef HAS_STD_MUTEX
+    std::lock_guard<std::mutex> lock(m_mx);
+    #endif // HAS_STD_MUTEX
+    return m_rows;
+}
+
+TelemetryStats TelemetryCollector::stats() const
+{
+    #ifdef HAS_STD_MUTEX
+    std::lock_guard<std::mutex> lock(m_mx);
+    #endif // HAS_STD_MUTEX
+    return m_stats;
+}
+
+bool TelemetryCollector::flushLocked()
+{
+    if (m_rows == 0)
+        return true;
+
+    m_block.clear();
+    m_block.insert(m_block.end(), { 'H', 'M', 'T', 'B' });
+    append(m_block, Version);
+    append(m_block, uint8_t(HERMES_SERIAL_LENGTH));
+    append(m_block, uint8_t(0));
+    append(m_block, uint32_t(m_rows));
+    append(m_block, uint32_t(0));
+
+    uint8_t groups = 0;
+    for (uint8_t type = 0; type < TypesCount; ++type)
+    {
+        if (m_groups[type].rows == 0)
+            continue;
+        encode(type, m_groups[type]);
+        ++groups;
+    }
+    put(m_block, 7, groups);
+    put(m_block, 12, uint32_t(m_block.size()));
+
+    bool written = m_sink != nullptr && m_sink->write(m_block.data(), m_block.size());
+    if (written)
+    {
+        m_stats.rows += m_rows;
+        ++m_stats.blocks;
+        m_stats.bytes += m_block.size();
+    }
+    else
+    {
+        HM_WARN("Telemetry block of %zu samples is dropped", m_rows);
+        m_stats.dropped += m_rows;
+    }
+
+    // clear() keeps capacity, so steady batches do not allocate
+    for (Group& group : m_groups)
+    {
+        group.serials.clear();
+        group.properties.clear();
+        group.timestamps.clear();
+        group.values.clear();
+        group.precisions.clear();
+        group.offsets.clear();
+        group.rows = 0;
+    }
+    m_rows = 0;
+    return written;
+}
+
+void TelemetryCollector::encode(uint8_t type, const Group& group)
+{
+    uint8_t columns = 4;
+    if (type == ValueType::Float || type == ValueType::String)
+        columns = 5;
+
+    append(m_block, type);
+    append(m_block, columns);
+    append(m_block, uint16_t(0));
+    append(m_block, group.rows);
+
+    column(group.serials.data(), group.serials.size());
+    column(group.properties.data(), group.properties.size());
+    column(group.timestamps.data(), group.timestamps.size() * sizeof(uint64_t));
+    if (type == ValueType::String)
+        column(group.offsets.data(), group.offsets.size() * sizeof(uint32_t));
+    column(group.values.data(), group.values.size());
+    if (type == ValueType::Float)
+        column(group.precisions.data(), group.precisions.size() * sizeof(uint16_t));
+}
+
+void TelemetryCollector::column(const void* data, size_t length)
+{
+    append(m_block, uint32_t(length));
+    append(m_block, uint32_t(0));
+    const byte_t* bytes = static_cast<const byte_t*>(data);
+    m_block.insert(m_block.end(), bytes, bytes + length);
+    m_block.resize((m_block.size() + Alignment - 1) / Alignment * Alignment, 0);
+}
@@ -60,6 +60,12 @@ UnixTCPSocketIO::UnixTCPSocketIO(int sc, int timeoutSeconds)
         HM_WARN("Can't set read timeout for socket: %d", (int) errno);
         m_good = false;
     };
+
+    tv.tv_sec = HERMES_TCP_SOCK_WRITE_TIMEOUT_SEC;
+    if (setsockopt(m_sfd, SOL_SOCKET, SO_SNDTIMEO, (const char*)&tv, sizeof(tv)) != 0)
+    {
+        HM_WARN("Can't set write timeout for socket: %d", (int) errno);
+    }
 }
 
 void UnixTCPSocketIO::flush()
@@ -82,28 +88,37 @@ buffer_length_t UnixTCPSocketIO::wait(buffer_length_t length)
     if (!m_good) {
         return 0;
     }
-    if (m_buffer.size() >= length) {
-        return length;
+    if (buffered() >= length) {
+        return buffered();
     }
-    buffer_length_t remain = length - m_buffer.size();
-    buffer_length_t avail = available();
+
+    if (m_begin > 0) {
+        memmove(m_buffer, m_buffer + m_begin, buffered());
+        m_end -= m_begin;
+        m_begin = 0;
+    }
+
+    const buffer_length_t space = sizeof(m_buffer) - m_end;
+    buffer_length_t remain = length - buffered();
+    buffer_length_t avail = available() - buffered();
     if (avail > remain) {
         remain = avail;
     }
-    m_buffer.resize(m_buffer.size() + remain);
+    if (remain > space) {
+        remain = space;
+    }
 
-    int count = ::read(m_sfd, m_buffer.data() + (m_buffer.size() - remain), remain);
+    int count = ::read(m_sfd, m_buffer + m_end, remain);
 
     if (count < 1)
     {
         HM_DBG("Read failed with: %s", strerror(errno));
-    }
-
-    if (count <= 0) {
         m_good = false;
+    } else {
+        m_end += count;
     }
 
-    return m_buffer.size();
+    return buffered();
 }
 
 buffer_length_t UnixTCPSocketIO::available() const
@@ -115,28 +130,68 @@ buffer_length_t UnixTCPSocketIO::available() const
         count = 0;
     }
 
-    return static_cast<buffer_length_t>(count + m_buffer.size());
+    return static_cast<buffer_length_t>(count + buffered());
 }
 
 buffer_length_t UnixTCPSocketIO::write(const byte_t* buffer, buffer_length_t sz)
 {
-    int count = ::write(m_sfd, buffer, sz);
-    return count > 0 ? count : 0;
+    return send(buffer, sz, MSG_NOSIGNAL);
+}
+
+buffer_length_t UnixTCPSocketIO::tryWrite(const byte_t* buffer, buffer_length_t sz)
+{
+    return send(buffer, sz, MSG_NOSIGNAL | MSG_DONTWAIT);
+}
+
+buffer_length_t UnixTCPSocketIO::send(const byte_t* buffer, buffer_length_t sz, int flags)
+{
+    m_wouldBlock = false;
+    buffer_length_t len = 0;
+    while (len < sz) {
+        const ssize_t count = ::send(m_sfd, buffer + len, sz - len, flags);
+        if (count > 0) {
+            len += count;
+            continue;
+        }
+        if (count < 0 && errno == EINTR)
+            continue;
+        if (count < 0 && (errno == EAGAIN || errno == EWOULDBLOCK)
+            && (len == 0 || (flags & MSG_DONTWAIT))) {
+            m_wouldBlock = true;
+        } else if (count < 0 && (errno == EAGAIN || errno == EWOULDBLOCK)) {
+            // Part of the frame is on the wire already, anything sent after
+            // it would be parsed as its rest
+            HM_WARN("Write timed out after %d of %d bytes", (int) len, (int) sz);
+            m_good = false;
+        } else {
+            HM_WARN("Write failed with %d", (int) errno);
+            m_good = false;
+        }
+        break;
+    }
+    return len;
 }
 
 buffer_length_t UnixTCPSocketIO::read(byte_t* buffer, buffer_length_t sz)
 {
-    if (m_buffer.size() < sz) {
-        buffer_length_t remain = sz - m_buffer.size();
-        HM_DBG("Waiting for %d bytes", (int) remain);
-        wait(remain);
+    buffer_length_t len = 0;
+    while (len < sz) {
+        if (buffered() == 0) {
+            HM_DBG("Waiting for %d bytes", (int) (sz - len));
+            if (wait(sz - len) == 0)
+                break;
+        }
+        buffer_length_t chunk = sz - len > buffered() ? buffered() : sz - len;
+        memcpy(buffer + len, m_buffer + m_begin, chunk);
+        m_begin += chunk;
+        len += chunk;
     }
 
-    buffer_length_t len = sz > m_buffer.size() ? m_buffer.size() : sz;
-    if (len > 0) {
-        memcpy(buffer, m_buffer.data(), len);
-        m_buffer.erase(m_buffer.begin(), m_buffer.begin() + len);
-    } else {
+    if (buffered() == 0) {
+        m_begin = m_end = 0;
+    }
+
+    if (len < sz) {
         HM_WARN("Read failed with %d. Got %d bytes", (int) errno, (int)len);
     }
     return len;
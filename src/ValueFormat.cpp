@@ -0,0 +1,285 @@
+/**
+ * Hermes - A RPC for IOT
+ * Copyright (C) 2023  Eduard Sargsyan and Andrey Ovodov
+ * 
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ * 
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ * 
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#include <hermes/ValueFormat.h>
+
+#ifdef HAS_CHARCONV
+#include <charconv>
+#endif // HAS_CHARCONV
+
+#include <math.h>
+#include <stdio.h>
+#include <stdlib.h>
+
+using namespace hermes;
+
+namespace
+{
+    constexpr uint16_t Pow10[] = { 1, 10, 100, 1000, 10000 };
+
+    /**
+     * @return Count of fraction digits of precision, -1 if it is not a power of ten
+    */
+    int decimals(uint16_t precision)
+    {
+        for (int i = 0; i < int(sizeof(Pow10) / sizeof(Pow10[0])); ++i)
+        {
+            if (Pow10[i] == precision)
+                return i;
+        }
+        return -1;
+    }
+
+    char* writeUnsigned(char* first, char* last, uint32_t value)
+    {
+        #ifdef HAS_CHARCONV
+        std::to_chars_result res = std::to_chars(first, last, value);
+        return res.ec == std::errc() ? res.ptr : nullptr;
+        #else
+        char digits[10];
+        int count = 0;
+        do {
+            digits[count++] = char('0' + value % 10);
+            value /= 10;
+        } while (value != 0);
+        if (last - first < count)
+            return nullptr;
+        while (count > 0)
+            *first++ = digits[--count];
+        return first;
+        #endif // HAS_CHARCONV
+    }
+
+    /**
+     * Parse digits of [first, last) without sign, stopping at the first
+     * non digit.
+     * @return Pointer to the first character not parsed, nullptr on overflow
+     *         or if there are no digits
+    */
+    const char* readUnsigned(const char* first, const char* last, uint32_t& value)
+    {
+        #ifdef HAS_CHARCONV
+        if (first == last || *first < '0' || *first > '9')
+            return nullptr;
+        std::from_chars_result res = std::from_chars(first, last, value);
+        return res.ec == std::errc() ? res.ptr : nullptr;
+        #else
+        uint64_t acc = 0;
+        const char* p = first;
+        for (; p != last && *p >= '0' && *p <= '9'; ++p)
+        {
+            acc = acc * 10 + uint64_t(*p - '0');
+            if (acc > UINT32_MAX)
+                return nullptr;
+        }
+        if (p == first)
+            return nullptr;
+        value = uint32_t(acc);
+        return p;
+        #endif // HAS_CHARCONV
+    }
+
+    /**
+     * Parse floats in other notations than plain decimals, e.g. "1e-3",
+     * taking the highest precision the value fits with.
+    */
+    bool parseGeneralFloat(const char* first, const char* last, FloatValue& value)
+    {
+        float f;
+        #if defined(HAS_CHARCONV) && defined(__cpp_lib_to_chars)
+        std::from_chars_result res = std::from_chars(first, last, f);
+        if (res.ec != std::errc() || res.ptr != last)
+            return false;
+        #else
+        char tmp[32];
+        size_t length = last - first;
+        if (length == 0 || length >= sizeof(tmp))
+            return false;
+        memcpy(tmp, first, length);
+        tmp[length] = '\0';
+        char* end;
+        f = strtof(tmp, &end);
+        if (end != tmp + length)
+            return false;
+        #endif
+        if (!isfinite(f))
+            return false;
+        for (int i = int(sizeof(Pow10) / sizeof(Pow10[0])) - 1; i >= 0; --i)
+        {
+            double scaled = double(f) * Pow10[i];
+            if (scaled >= double(INT32_MIN) && scaled <= double(INT32_MAX))
+            {
+                value.V = int32_t(lround(scaled));
+                value.Precision = Pow10[i];
+                return true;
+            }
+        }
+        return false;
+    }
+}
+
+char* hermes::formatBoolean(char* first, char* last, bool value)
+{
+    const char* str = value ? "true" : "false";
+    size_t length = value ? 4 : 5;
+    if (size_t(last - first) < length)
+        return nullptr;
+    memcpy(first, str, length);
+    return first + length;
+}
+
+char* hermes::formatInteger(char* first, char* last, int32_t value)
+{
+    if (value >= 0)
+        return writeUnsigned(first, last, uint32_t(value));
+    if (first == last)
+        return nullptr;
+    *first = '-';
+    return writeUnsigned(first + 1, last, uint32_t(0) - uint32_t(value));
+}
+
+char* hermes::formatUnsigned(char* first, char* last, uint32_t value)
+{
+    return writeUnsigned(first, last, value);
+}
+
+char* hermes::formatFloat(char* first, char* last, const FloatValue& value)
+{
+    int32_t v = value.V;
+    uint16_t precision = value.Precision;
+    if (precision == 0)
+        return nullptr;
+
+    int digits = decimals(precision);
+    if (digits < 0)
+    {
+        float f = float(v) / float(precision);
+        #if defined(HAS_CHARCONV) && defined(__cpp_lib_to_chars)
+        std::to_chars_result res = std::to_chars(first, last, f);
+        return res.ec == std::errc() ? res.ptr : nullptr;
+        #else
+        char tmp[32];
+        int length = snprintf(tmp, sizeof(tmp), "%g", f);
+        if (length <= 0 || last - first < length)
+            return nullptr;
+        memcpy(first, tmp, length);
+        return first + length;
+        #endif
+    }
+
+    uint32_t abs = v < 0 ? uint32_t(0) - uint32_t(v) : uint32_t(v);
+    if (v < 0)
+    {
+        if (first == last)
+            return nullptr;
+        *first++ = '-';
+    }
+    first = writeUnsigned(first, last, abs / precision);
+    if (first == nullptr || digits == 0)
+        return first;
+    if (last - first < digits + 1)
+        return nullptr;
+    *first = '.';
+    uint32_t fraction = abs % precision;
+    for (int i = digits; i > 0; --i)
+    {
+        first[i] = char('0' + fraction % 10);
+        fraction /= 10;
+    }
+    return first + digits + 1;
+}
+
+bool hermes::parseBoolean(const char* first, const char* last, uint8_t& value)
+{
+    size_t length = last - first;
+    if ((length == 4 && memcmp(first, "true", 4) == 0) || (length == 1 && *first == '1'))
+    {
+        value = 1;
+        return true;
+    }
+    if ((length == 5 && memcmp(first, "false", 5) == 0) || (length == 1 && *first == '0'))
+    {
+        value = 0;
+        return true;
+    }
+    return false;
+}
+
+bool hermes::parseInteger(const char* first, const char* last, int32_t& value)
+{
+    bool negative = first != last && *first == '-';
+    uint32_t abs;
+    if (readUnsigned(first + (negative ? 1 : 0), last, abs) != last)
+        return false;
+    if (abs > uint32_t(INT32_MAX) + (negative ? 1 : 0))
+        return false;
+    value = negative ? int32_t(uint32_t(0) - abs) : int32_t(abs);
+    return true;
+}
+
+bool hermes::parseUnsigned(const char* first, const char* last, uint32_t& value)
+{
+    return readUnsigned(first, last, value) == last;
+}
+
+bool hermes::parseFloat(const char* first, const char* last, FloatValue& value)
+{
+    const char* p = first;
+    bool negative = p != last && *p == '-';
+    if (negative)
+        ++p;
+
+    uint32_t whole = 0;
+    const char* next = readUnsigned(p, last, whole);
+    bool hasWhole = next != nullptr;
+    p = hasWhole ? next : p;
+
+    // Up to 4 fraction digits are kept, the 5th one rounds
+    uint8_t fraction[5] = { 0 };
+    int fractionCount = 0;
+    bool hasFraction = false;
+    if (p != last && *p == '.')
+    {
+        for (++p; p != last && *p >= '0' && *p <= '9'; ++p, hasFraction = true)
+        {
+            if (fractionCount < 5)
+                fraction[fractionCount++] = uint8_t(*p - '0');
+        }
+    }
+
+    if (p != last || (!hasWhole && !hasFraction))
+        return parseGeneralFloat(first, last, value);
+
+    // Drop fraction digits until the value fits
+    const uint64_t limit = uint64_t(INT32_MAX) + (negative ? 1 : 0);
+    for (int digits = fractionCount < 4 ? fractionCount : 4; digits >= 0; --digits)
+    {
+        uint64_t v = whole;
+        for (int i = 0; i < digits; ++i)
+            v = v * 10 + fraction[i];
+        if (digits < fractionCount && fraction[digits] >= 5)
+            ++v;
+        if (v <= limit)
+        {
+            value.V = negative ? int32_t(uint32_t(0) - uint32_t(v)) : int32_t(v);
+            value.Precision = Pow10[digits];
+            return true;
+        }
+    }
+    return false;
+}
@@ -0,0 +1,257 @@
+/**
+ * Hermes - A RPC for IOT
+ * Copyright (C) 2023  Eduard Sargsyan and Andrey Ovodov
+ * 
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ * 
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ * 
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#include <hermes/WorkStealingPool.h>
+
+#ifdef HAS_STD_THREAD_H
+
+using namespace hermes;
+
+namespace
+{
+    // Worker the current thread belongs to
+    thread_local const WorkStealingPool* t_pool = nullptr;
+    thread_local size_t t_self = 0;
+
+    // Key of the strand job running on the current thread
+    thread_local const void* t_key = nullptr;
+} // namespace
+
+WorkStealingPool::WorkStealingPool(unsigned threads, size_t capacity)
+    : m_capacity(capacity > 0 ? capacity : 1)
+{
+    if (threads == 0)
+        threads = std::thread::hardware_concurrency();
+    if (threads == 0)
+        threads = 1;
+
+    for (unsigned i = 0; i < threads; ++i)
+        m_workers.emplace_back(new Worker());
+    for (unsigned i = 0; i < threads; ++i)
+        m_threads.emplace_back(&WorkStealingPool::run, this, i);
+}
+
+WorkStealingPool::~WorkStealingPool()
+{
+    stop();
+}
+
+bool WorkStealingPool::post(const void* key, job_t job)
+{
+    return enqueue(key, std::move(job), true);
+}
+
+bool WorkStealingPool::tryPost(const void* key, job_t job)
+{
+    return enqueue(key, std::move(job), false);
+}
+
+void WorkStealingPool::wait()
+{
+    std::unique_lock<std::mutex> lock(m_mx);
+    m_idle.wait(lock, [this]() { return m_stats.pending == 0 || m_stop; });
+}
+
+void WorkStealingPool::drain(const void* key)
+{
+    if (key == nullptr)
+        return;
+
+    std::unique_lock<std::mutex> lock(m_mx);
+    if (t_pool == this && t_key == key) {
+        auto it = m_strands.find(key);
+        if (it == m_strands.end())
+            return;
+        const size_t dropped = it->second.jobs.size();
+        it->second.jobs.clear();
+        m_stats.pending -= dropped;
+        lock.unlock();
+        m_space.notify_all();
+        return;
+    }
+    m_drained.wait(lock, [this, key]() { return m_strands.find(key) == m_strands.end() || m_stop; });
+}
+
+void WorkStealingPool::stop()
+{
+    {
+        std::lock_guard<std::mutex> lock(m_mx);
+        m_stop = true;
+    }
+    m_work.notify_all();
+    m_space.notify_all();
+    m_idle.notify_all();
+    m_drained.notify_all();
+    for (auto& t : m_threads) {
+        if (t.joinable())
+            t.join();
+    }
+    m_threads.clear();
+}
+
+ExecutorStats WorkStealingPool::stats() const
+{
+    std::lock_guard<std::mutex> lock(m_mx);
+    ExecutorStats stats = m_stats;
+    stats.stolen = m_stolen.load();
+    return stats;
+}
+
+bool WorkStealingPool::enqueue(const void* key, job_t&& job, bool block)
+{
+    std::unique_lock<std::mutex> lock(m_mx);
+    if (m_stats.pending >= m_capacity) {
+        if (!block) {
+            ++m_stats.rejected;
+            return false;
+        }
+        if (t_pool != this) {
+            ++m_stats.blocked;
+            m_space.wait(lock, [this]() { return m_stats.pending < m_capacity || m_stop; });
+        }
+    }
+    if (m_stop)
+        return false;
+
+    ++m_stats.posted;
+    if (++m_stats.pending > m_stats.peak)
+        m_stats.peak = m_stats.pending;
+
+    if (key == nullptr) {
+        lock.unlock();
+        push({ nullptr, nullptr, std::move(job) });
+        return true;
+    }
+
+    Strand& strand = m_strands[key];
+    strand.jobs.push_back(std::move(job));
+    if (strand.scheduled)
+        return true;
+
+    strand.scheduled = true;
+    lock.unlock();
+    push({ key, &strand, job_t() });
+    return true;
+}
+
+void WorkStealingPool::push(Item&& item)
+{
+    // Jobs posted from a worker stay on it, others are spread round-robin
+    const size_t index = t_pool == this ? t_self : m_next++ % m_workers.size();
+    {
+        std::lock_guard<std::mutex> lock(m_workers[index]->mx);
+        m_workers[index]->items.push_back(std::move(item));
+    }
+
+    // Pairs with the check of m_queued by a worker going to sleep
+    ++m_queued;
+    if (m_sleeping > 0) {
+        std::lock_guard<std::mutex> lock(m_mx);
+        m_work.notify_one();
+    }
+}
+
+bool WorkStealingPool::take(size_t self, Item& item)
+{
+    {
+        Worker& own = *m_workers[self];
+        std::lock_guard<std::mutex> lock(own.mx);
+        if (!own.items.empty()) {
+            item = std::move(own.items.back());
+            own.items.pop_back();
+            return true;
+        }
+    }
+
+    const size_t count = m_workers.size();
+    for (size_t i = 1; i < count; ++i) {
+        Worker& victim = *m_workers[(self + i) % count];
+        std::lock_guard<std::mutex> lock(victim.mx);
+        if (!victim.items.empty()) {
+            item = std::move(victim.items.front());
+            victim.items.pop_front();
+            ++m_stolen;
+            return true;
+        }
+    }
+    return false;
+}
+
+void WorkStealingPool::run(size_t self)
+{
+    t_pool = this;
+    t_self = self;
+    for (;;) {
+        Item item;
+        if (take(self, item)) {
+            --m_queued;
+            execute(item);
+            continue;
+        }
+
+        std::unique_lock<std::mutex> lock(m_mx);
+        ++m_sleeping;
+        m_work.wait(lock, [this]() { return m_queued > 0 || m_stop; });
+        --m_sleeping;
+        if (m_stop)
+            return;
+    }
+}
+
+void WorkStealingPool::execute(Item& item)
+{
+    if (item.strand == nullptr) {
+        item.job();
+        std::unique_lock<std::mutex> lock(m_mx);
+        done(lock);
+        return;
+    }
+
+    std::unique_lock<std::mutex> lock(m_mx);
+    job_t job = std::move(item.strand->jobs.front());
+    item.strand->jobs.pop_front();
+    lock.unlock();
+
+    t_key = item.key;
+    job();
+    t_key = nullptr;
+
+    lock.lock();
+    const bool more = !item.strand->jobs.empty();
+    if (!more)
+        m_strands.erase(item.key);
+    done(lock);
+    if (!more)
+        m_drained.notify_all();
+
+    // One job per turn, so a busy strand does not starve the others
+    if (more)
+        push(std::move(item));
+}
+
+void WorkStealingPool::done(std::unique_lock<std::mutex>& lock)
+{
+    ++m_stats.executed;
+    const bool idle = --m_stats.pending == 0;
+    lock.unlock();
+    m_space.notify_one();
+    if (idle)
+        m_idle.notify_all();
+}
+
+#endif // HAS_STD_THREAD_H
@@ -0,0 +1,130 @@
+/**
+ * Hermes - A RPC for IOT
+ * Copyright (C) 2023  Eduard Sargsyan and Andrey Ovodov
+ * 
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ * 
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ * 
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#include "TestHelpers.h"
+
+#include <hermes/AdmissionControl.h>
+
+using namespace hermes;
+using namespace hermes::test;
+
+namespace
+{
+    serial_t serialOf(byte_t n)
+    {
+        serial_t serial;
+        memset(serial.data, 0, sizeof(serial.data));
+        serial.data[0] = n;
+        return serial;
+    }
+
+    AdmissionLimits concurrent(uint16_t maxConcurrent)
+    {
+        AdmissionLimits limits;
+        limits.maxConcurrent = maxConcurrent;
+        limits.retryAfterMs = 100;
+        return limits;
+    }
+
+    void deferOverConcurrencyLimit()
+    {
+        AdmissionControl admission(concurrent(1));
+        uint16_t retryAfterMs = 0;
+        HM_CHECK(admission.admit(0, serialOf(1), retryAfterMs));
+
+        HM_CHECK(!admission.admit(0, serialOf(2), retryAfterMs));
+        HM_CHECK(retryAfterMs >= 100);
+        HM_CHECK(admission.stats().admitted == 1);
+        HM_CHECK(admission.stats().deferred == 1);
+    }
+
+    void doneReleasesSlot()
+    {
+        AdmissionControl admission(concurrent(1));
+        uint16_t retryAfterMs = 0;
+        HM_REQUIRE(admission.admit(0, serialOf(1), retryAfterMs));
+        HM_REQUIRE(!admission.admit(0, serialOf(2), retryAfterMs));
+
+        admission.done(serialOf(1));
+        HM_CHECK(admission.admit(10, serialOf(2), retryAfterMs));
+        HM_CHECK(admission.stats().peakConcurrent == 1);
+    }
+
+    void handshakingAgainKeepsSlot()
+    {
+        AdmissionControl admission(concurrent(1));
+        uint16_t retryAfterMs = 0;
+        HM_REQUIRE(admission.admit(0, serialOf(1), retryAfterMs));
+        HM_CHECK(admission.admit(5, serialOf(1), retryAfterMs));
+        HM_CHECK(admission.stats().peakConcurrent == 1);
+    }
+
+    void forgetSlotAfterTimeout()
+    {
+        AdmissionControl admission(concurrent(1));
+        uint16_t retryAfterMs = 0;
+        HM_REQUIRE(admission.admit(0, serialOf(1), retryAfterMs));
+        HM_REQUIRE(!admission.admit(1, serialOf(2), retryAfterMs));
+        HM_CHECK(admission.admit(HERMES_ADMISSION_TIMEOUT_MS, serialOf(2), retryAfterMs));
+    }
+
+    void backoffGrowsWithBacklog()
+    {
+        AdmissionControl admission(concurrent(1));
+        uint16_t first = 0;
+        uint16_t second = 0;
+        uint16_t again = 0;
+        HM_REQUIRE(admission.admit(0, serialOf(1), first));
+        HM_REQUIRE(!admission.admit(0, serialOf(2), first));
+        HM_REQUIRE(!admission.admit(0, serialOf(3), second));
+        HM_CHECK(second > first);
+
+        // A slave retrying is not counted twice
+        HM_REQUIRE(!admission.admit(1, serialOf(2), again));
+        HM_CHECK(again == second);
+    }
+
+    void rateLimitRefills()
+    {
+        AdmissionLimits limits;
+        limits.rate = 10;
+        limits.burst = 1;
+        limits.retryAfterMs = 50;
+        AdmissionControl admission(limits);
+
+        uint16_t retryAfterMs = 0;
+        HM_REQUIRE(admission.admit(0, serialOf(1), retryAfterMs));
+        HM_REQUIRE(!admission.admit(0, serialOf(2), retryAfterMs));
+        HM_CHECK(retryAfterMs >= 50 + 100);
+
+        // One handshake per 100 ms
+        HM_CHECK(!admission.admit(50, serialOf(2), retryAfterMs));
+        HM_CHECK(admission.admit(100, serialOf(2), retryAfterMs));
+    }
+} // namespace
+
+int main()
+{
+    run("AdmissionControl defers over the concurrency limit", deferOverConcurrencyLimit);
+    run("AdmissionControl done releases the slot", doneReleasesSlot);
+    run("AdmissionControl slave handshaking again keeps its slot", handshakingAgainKeepsSlot);
+    run("AdmissionControl forgets a slot after timeout", forgetSlotAfterTimeout);
+    run("AdmissionControl backoff grows with backlog", backoffGrowsWithBacklog);
+    run("AdmissionControl rate limit refills", rateLimitRefills);
+    return result();
+}
@@ -0,0 +1,132 @@
+/**
+ * Hermes - A RPC for IOT
+ * Copyright (C) 2023  Eduard Sargsyan and Andrey Ovodov
+ * 
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ * 
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ * 
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#include "TestHelpers.h"
+
+#include <hermes/CompressedIO.h>
+
+using namespace hermes;
+using namespace hermes::test;
+
+namespace
+{
+    /**
+     * Handshake as master answers it, with Lz agreed
+    */
+    HandshakePayload agreed()
+    {
+        HandshakePayload hs{};
+        hs.desiredVersion = hs.minimumVersion = hs.maximumVersion = CurrentApiVersion;
+        hs.result = HandshakeResult::Ok;
+        hs.capabilities = CapCompression;
+        hs.codec = Codec::Lz;
+        return hs;
+    }
+
+    struct CompressedLink
+    {
+        Pipe pipe;
+        CompressedIO tx { &pipe.a };
+        CompressedIO rx { &pipe.b };
+
+        CompressedLink()
+        {
+            tx.negotiate(agreed());
+            rx.negotiate(agreed());
+        }
+
+        /**
+         * Put a header with length on the wire, bypassing tx
+        */
+        bool sendHeader(size_t length)
+        {
+            CompressedHeader header{};
+            header.codec = Codec::Lz;
+            header.length[0] = length & 0xFF;
+            header.length[1] = (length >> 8) & 0xFF;
+            return pipe.a.IO::write(header);
+        }
+    };
+
+    void roundTrip()
+    {
+        CompressedLink link;
+        HM_REQUIRE(link.tx.codec() == Codec::Lz);
+        HM_REQUIRE(link.rx.codec() == Codec::Lz);
+
+        const Message sent = setMessage("temperature", 42);
+        HM_REQUIRE(static_cast<IO&>(link.tx).write(sent));
+        HM_CHECK(link.tx.stats().compressed == 1);
+        HM_CHECK(link.pipe.ab.size() < sizeof(Message));
+
+        Message received;
+        HM_CHECK(link.rx.available() == sizeof(Message));
+        HM_REQUIRE(static_cast<IO&>(link.rx).read(received));
+        HM_CHECK(memcmp(&sent, &received, sizeof(Message)) == 0);
+        HM_CHECK(link.rx.stats().messagesReceived == 1);
+        HM_CHECK(link.rx.stats().errors == 0);
+    }
+
+    void passThroughUntilNegotiated()
+    {
+        Pipe pipe;
+        CompressedIO tx(&pipe.a);
+        HM_REQUIRE(static_cast<IO&>(tx).write(setMessage("temperature", 42)));
+        HM_CHECK(tx.codec() == Codec::None);
+        HM_CHECK(pipe.ab.size() == sizeof(Message));
+    }
+
+    void rejectZeroLength()
+    {
+        CompressedLink link;
+        HM_REQUIRE(link.sendHeader(0));
+        HM_REQUIRE(static_cast<IO&>(link.tx).write(setMessage("temperature", 7)));
+
+        // A bad header is reported as a message, so readers do not wait forever
+        HM_CHECK(link.rx.available() >= sizeof(Message));
+
+        Message received;
+        HM_CHECK(!static_cast<IO&>(link.rx).read(received));
+        HM_CHECK(link.rx.stats().errors == 1);
+
+        // The header had no body, the next message is intact
+        HM_REQUIRE(static_cast<IO&>(link.rx).read(received));
+        HM_CHECK(received.payload.command.data.value.value.I == 7);
+    }
+
+    void rejectOversizedLength()
+    {
+        CompressedLink link;
+        HM_REQUIRE(link.sendHeader(CompressedIO::MaxBodyLength + 1));
+        HM_CHECK(link.rx.available() >= sizeof(Message));
+
+        Message received;
+        HM_CHECK(!static_cast<IO&>(link.rx).read(received));
+        HM_CHECK(link.rx.stats().errors == 1);
+        HM_CHECK(link.rx.stats().messagesReceived == 0);
+    }
+} // namespace
+
+int main()
+{
+    run("CompressedIO round trip", roundTrip);
+    run("CompressedIO passes through until negotiated", passThroughUntilNegotiated);
+    run("CompressedIO rejects a zero length", rejectZeroLength);
+    run("CompressedIO rejects an oversized length", rejectOversizedLength);
+    return result();
+}
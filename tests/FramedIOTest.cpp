@@ -0,0 +1,128 @@
+/**
+ * Hermes - A RPC for IOT
+ * Copyright (C) 2023  Eduard Sargsyan and Andrey Ovodov
+ * 
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ * 
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ * 
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#include "TestHelpers.h"
+
+#include <hermes/FramedIO.h>
+
+using namespace hermes;
+using namespace hermes::test;
+
+namespace
+{
+    constexpr int Frames = 3;
+
+    /**
+     * Send Frames messages through a FramedIO and let tamper change the
+     * bytes on the wire.
+    */
+    template<class Tamper>
+    bool sendFrames(Pipe& pipe, Tamper tamper)
+    {
+        FramedIO tx(&pipe.a);
+        for (int i = 0; i < Frames; ++i) {
+            if (!static_cast<IO&>(tx).write(setMessage("value", i)))
+                return false;
+        }
+        if (pipe.ab.size() != Frames * (sizeof(FrameHeader) + sizeof(Message)))
+            return false;
+        tamper(pipe.ab);
+        return true;
+    }
+
+    int32_t valueOf(const Message& msg)
+    {
+        return msg.payload.command.data.value.value.I;
+    }
+
+    void roundTrip()
+    {
+        Pipe pipe;
+        HM_REQUIRE(sendFrames(pipe, [](std::vector<byte_t>&) {}));
+
+        FramedIO rx(&pipe.b);
+        for (int i = 0; i < Frames; ++i) {
+            Message msg;
+            HM_REQUIRE(static_cast<IO&>(rx).read(msg));
+            HM_CHECK(valueOf(msg) == i);
+        }
+        HM_CHECK(rx.stats().framesReceived == Frames);
+        HM_CHECK(rx.stats().framesDropped == 0);
+        HM_CHECK(rx.stats().resyncs == 0);
+    }
+
+    void resyncAfterCorruptedByte()
+    {
+        Pipe pipe;
+        HM_REQUIRE(sendFrames(pipe, [](std::vector<byte_t>& wire) {
+            wire[sizeof(FrameHeader) + 10] ^= 0xFF;
+        }));
+
+        FramedIO rx(&pipe.b);
+        Message msg;
+        HM_REQUIRE(static_cast<IO&>(rx).read(msg));
+        HM_CHECK(valueOf(msg) == 1);
+        HM_REQUIRE(static_cast<IO&>(rx).read(msg));
+        HM_CHECK(valueOf(msg) == 2);
+        HM_CHECK(rx.stats().framesDropped == 1);
+        HM_CHECK(rx.stats().resyncs == 1);
+        HM_CHECK(rx.stats().bytesSkipped > 0);
+    }
+
+    void resyncAfterDroppedByte()
+    {
+        Pipe pipe;
+        HM_REQUIRE(sendFrames(pipe, [](std::vector<byte_t>& wire) {
+            wire.erase(wire.begin() + sizeof(FrameHeader) + 10);
+        }));
+
+        FramedIO rx(&pipe.b);
+        Message msg;
+        HM_REQUIRE(static_cast<IO&>(rx).read(msg));
+        HM_CHECK(valueOf(msg) == 1);
+        HM_REQUIRE(static_cast<IO&>(rx).read(msg));
+        HM_CHECK(valueOf(msg) == 2);
+        HM_CHECK(rx.stats().framesReceived == 2);
+        HM_CHECK(rx.stats().resyncs == 1);
+    }
+
+    void skipGarbageBeforeFrame()
+    {
+        Pipe pipe;
+        HM_REQUIRE(sendFrames(pipe, [](std::vector<byte_t>& wire) {
+            const byte_t noise[] = { 0x00, FramedIO::FrameStart[0], 0x13, 0x37 };
+            wire.insert(wire.begin(), noise, noise + sizeof(noise));
+        }));
+
+        FramedIO rx(&pipe.b);
+        Message msg;
+        HM_REQUIRE(static_cast<IO&>(rx).read(msg));
+        HM_CHECK(valueOf(msg) == 0);
+        HM_CHECK(rx.stats().bytesSkipped == 4);
+        HM_CHECK(rx.stats().resyncs == 1);
+    }
+} // namespace
+
+int main()
+{
+    run("FramedIO round trip", roundTrip);
+    run("FramedIO resync after a corrupted byte", resyncAfterCorruptedByte);
+    run("FramedIO resync after a dropped byte", resyncAfterDroppedByte);
+    run("FramedIO skips garbage before a frame", skipGarbageBeforeFrame);
+    return result();
+}
@@ -0,0 +1,245 @@
+/**
+ * Hermes - A RPC for IOT
+ * Copyright (C) 2023  Eduard Sargsyan and Andrey Ovodov
+ * 
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ * 
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ * 
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#include "TestHelpers.h"
+
+#include <hermes/EasySlave.h>
+#include <hermes/EasySlaveProperty.h>
+#include <hermes/Master.h>
+#include <hermes/SlaveDescriptor.h>
+
+#if defined(HAS_LINUX_HEADERS) && defined(HAS_STD_THREAD_H)
+
+#include <hermes/UnixTCPSocketIO.h>
+
+#include <sys/socket.h>
+#include <atomic>
+#include <chrono>
+#include <thread>
+
+using namespace hermes;
+using namespace hermes::test;
+
+namespace
+{
+    static const byte_t kToken[HERMES_TOKEN_LENGTH] = { 0 };
+    static const byte_t kOther[HERMES_SERIAL_LENGTH] = { 'T', 'E', 'S', 'T', '0', '0', '0', '2' };
+
+    /**
+     * Slave with two integer properties, counts names it is asked for and
+     * backoffs instead of sleeping.
+    */
+    class TestSlave : public EasySlave<2>
+    {
+    public:
+        TestSlave(const byte_t* serial, int32_t first, int32_t second)
+            : EasySlave<2>(m_ptrs, nullptr, serial, kToken)
+            , m_first("first", first)
+            , m_second("second", second)
+        {
+            m_ptrs[0] = &m_first;
+            m_ptrs[1] = &m_second;
+        }
+
+        bool propertyName(uint8_t index, char* name) override
+        {
+            ++names;
+            return EasySlave<2>::propertyName(index, name);
+        }
+
+        std::atomic<int> names { 0 };
+        std::atomic<int> delays { 0 };
+
+    protected:
+        void delay(uint32_t) override { ++delays; }
+
+    private:
+        CachedSlaveProperty<int32_t> m_first;
+        CachedSlaveProperty<int32_t> m_second;
+        SlaveProperty* m_ptrs[2];
+    };
+
+    /**
+     * Master and slave ends of a connection, the slave handshakes and
+     * answers on a thread of its own until the connection is closed.
+    */
+    struct Connection
+    {
+        Connection()
+            : master(open(0))
+            , slaveIo(open(1))
+        {}
+
+        ~Connection()
+        {
+            master.close();
+            join();
+            slaveIo.close();
+        }
+
+        void start(TestSlave& slave)
+        {
+            slave.setIO(&slaveIo);
+            thread = std::thread([this, &slave]() {
+                if (!slave.handshake())
+                    return;
+                while (slaveIo.good())
+                    slave.loop();
+            });
+        }
+
+        void join()
+        {
+            if (thread.joinable())
+                thread.join();
+        }
+
+        int open(int end)
+        {
+            if (end == 0 && socketpair(AF_UNIX, SOCK_STREAM, 0, fds) != 0)
+                fds[0] = fds[1] = -1;
+            return fds[end];
+        }
+
+        int fds[2];
+        UnixTCPSocketIO master;
+        UnixTCPSocketIO slaveIo;
+        std::thread thread;
+    };
+
+    SlaveDescriptor* g_announced = nullptr;
+    int g_announcements = 0;
+    int g_dropped = 0;
+
+    bool acceptAll(const serial_t&, token_t&)
+    {
+        return true;
+    }
+
+    void onNewSlave(SlaveDescriptor* slave)
+    {
+        g_announced = slave;
+        ++g_announcements;
+    }
+
+    void onSet(SlaveDescriptor*, uint8_t, const ValueData&, bool ok)
+    {
+        if (!ok)
+            ++g_dropped;
+    }
+
+    void reconnectKeepsSchema()
+    {
+        g_announced = nullptr;
+        g_announcements = 0;
+        g_dropped = 0;
+
+        Master master(nullptr);
+        master.setAuthenticator(acceptAll);
+        master.setOnNewSlaveCallback(onNewSlave);
+
+        TestSlave first(kSerial, 1, 2);
+        Connection before;
+        before.start(first);
+        HM_REQUIRE(master.accept(&before.master));
+        HM_REQUIRE(g_announced != nullptr);
+        SlaveDescriptor* descriptor = g_announced;
+
+        // Learn the whole schema over the first connection
+        ValueData vd;
+        HM_REQUIRE(descriptor->propertiesCount() == 2);
+        HM_REQUIRE(descriptor->get(0, vd) && vd.value.I == 1);
+        HM_REQUIRE(descriptor->get(1, vd) && vd.value.I == 2);
+        HM_REQUIRE(descriptor->schema().complete());
+
+        // A set still waiting for its window when the connection goes away
+        descriptor->setSetCallback(onSet);
+        descriptor->setWriteCombining(60000);
+        vd.value.I = 5;
+        HM_CHECK(descriptor->set(0, vd));
+
+        TestSlave second(kSerial, 10, 20);
+        Connection after;
+        after.start(second);
+        HM_REQUIRE(master.accept(&after.master));
+        before.master.close();
+
+        HM_CHECK(g_announcements == 2);
+        HM_CHECK(g_announced == descriptor);
+        HM_CHECK(g_dropped == 1);
+        HM_CHECK(descriptor->flushSets(true) == 0);
+
+        // Requests go over the new connection, names come from the schema kept
+        const int names = second.names;
+        HM_CHECK(descriptor->get(0, vd) && vd.value.I == 10);
+        HM_CHECK(descriptor->get(1, vd) && vd.value.I == 20);
+        HM_CHECK(second.names == names);
+    }
+
+    void deferredSlaveReconnects()
+    {
+        Master master(nullptr);
+        master.setAuthenticator(acceptAll);
+        AdmissionLimits limits;
+        limits.rate = 1;
+        master.setAdmissionLimits(limits);
+
+        // Takes the only handshake of this second
+        TestSlave busy(kOther, 1, 2);
+        Connection taken;
+        taken.start(busy);
+        HM_REQUIRE(master.accept(&taken.master));
+
+        // Master drops deferred connections, the slave backs off and
+        // comes back over new ones
+        TestSlave slave(kSerial, 1, 2);
+        for (int i = 1; i <= 2; ++i) {
+            Connection deferred;
+            deferred.start(slave);
+            HM_CHECK(!master.accept(&deferred.master));
+            deferred.join();
+            HM_CHECK(slave.retries() == i);
+            HM_CHECK(slave.delays == i);
+        }
+        HM_CHECK(master.admissionStats().deferred == 2);
+
+        std::this_thread::sleep_for(std::chrono::milliseconds(1100));
+        Connection admitted;
+        admitted.start(slave);
+        HM_CHECK(master.accept(&admitted.master));
+        admitted.master.close();
+        admitted.join();
+        HM_CHECK(slave.retries() == 0);
+    }
+} // namespace
+
+int main()
+{
+    run("reconnect keeps schema", reconnectKeepsSchema);
+    run("deferred slave reconnects", deferredSlaveReconnects);
+    return result();
+}
+
+#else
+
+int main()
+{
+    return 0;
+}
+
+#endif // HAS_LINUX_HEADERS && HAS_STD_THREAD_H
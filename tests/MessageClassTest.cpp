@@ -0,0 +1,61 @@
+/**
+ * Hermes - A RPC for IOT
+ * Copyright (C) 2023  Eduard Sargsyan and Andrey Ovodov
+ * 
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ * 
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ * 
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#include "TestHelpers.h"
+
+#include <hermes/MessageClass.h>
+
+using namespace hermes;
+using namespace hermes::test;
+
+namespace
+{
+    constexpr uint8_t Control = static_cast<uint8_t>(MessageClass::Control);
+    constexpr uint8_t Event = static_cast<uint8_t>(MessageClass::Event);
+
+    void highestClassFirst()
+    {
+        bool ready[MessageClassCount] = { true, true, true, true };
+        uint8_t bypassed[MessageClassCount] = { 0 };
+        HM_CHECK(pickLane(ready, bypassed) == Control);
+        HM_CHECK(bypassed[Control] == 0);
+        HM_CHECK(bypassed[Event] == 1);
+
+        bool none[MessageClassCount] = { false };
+        HM_CHECK(pickLane(none, bypassed) == MessageClassCount);
+    }
+
+    void lowerClassIsNotStarved()
+    {
+        bool ready[MessageClassCount] = { true, false, true, false };
+        uint8_t bypassed[MessageClassCount] = { 0 };
+        for (int i = 0; i < HERMES_LANE_MAX_BYPASS; ++i)
+            HM_REQUIRE(pickLane(ready, bypassed) == Control);
+
+        HM_CHECK(pickLane(ready, bypassed) == Event);
+        HM_CHECK(bypassed[Event] == 0);
+        HM_CHECK(pickLane(ready, bypassed) == Control);
+    }
+} // namespace
+
+int main()
+{
+    run("pickLane sends the highest class first", highestClassFirst);
+    run("pickLane serves a lower class passed over too often", lowerClassIsNotStarved);
+    return result();
+}
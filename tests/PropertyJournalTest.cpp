@@ -0,0 +1,200 @@
+/**
+ * Hermes - A RPC for IOT
+ * Copyright (C) 2023  Eduard Sargsyan and Andrey Ovodov
+ * 
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ * 
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ * 
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#include "TestHelpers.h"
+
+#include <hermes/PropertyJournal.h>
+
+#ifdef HAS_LINUX_HEADERS
+
+#include <algorithm>
+#include <chrono>
+#include <fstream>
+#include <iterator>
+#include <string>
+#include <thread>
+#include <unistd.h>
+
+using namespace hermes;
+using namespace hermes::test;
+
+namespace
+{
+    /// @brief Value no other record holds, to find a record in the file
+    constexpr int32_t Marker = 0x5A5A1234;
+
+    ValueData integer(int32_t v)
+    {
+        ValueData value{};
+        strcpy(value.name, "value");
+        value.type = ValueType::Integer;
+        value.value.I = v;
+        return value;
+    }
+
+    /**
+     * Journal file removed before and after a test case
+    */
+    struct JournalFile
+    {
+        std::string path;
+
+        explicit JournalFile(const char* name)
+            : path(std::string("hermes_") + name + ".journal")
+        {
+            remove();
+        }
+
+        ~JournalFile() { remove(); }
+
+        void remove()
+        {
+            unlink(path.c_str());
+            unlink((path + ".tmp").c_str());
+        }
+
+        /**
+         * @return Offset of the first occurrence of v in the file
+        */
+        size_t find(int32_t v) const
+        {
+            std::ifstream in(path, std::ios::binary);
+            std::vector<char> data((std::istreambuf_iterator<char>(in)), std::istreambuf_iterator<char>());
+            const char* needle = reinterpret_cast<const char*>(&v);
+            auto it = std::search(data.begin(), data.end(), needle, needle + sizeof(v));
+            return it == data.end() ? std::string::npos : static_cast<size_t>(it - data.begin());
+        }
+    };
+
+    int32_t latest(PropertyJournal& journal, uint8_t property)
+    {
+        ValueData value;
+        uint64_t timestamp;
+        if (!journal.find(serial_t(kSerial), property, value, timestamp))
+            return -1;
+        return value.value.I;
+    }
+
+    void keepLatestValuesAcrossReopen()
+    {
+        JournalFile file("reopen");
+        {
+            PropertyJournal journal(file.path.c_str());
+            HM_REQUIRE(journal.isOpen());
+            for (int32_t i = 0; i < 5; ++i)
+                HM_REQUIRE(journal.append(serial_t(kSerial), i % 2, integer(i)));
+        }
+
+        PropertyJournal journal(file.path.c_str());
+        HM_CHECK(journal.stats().records == 5);
+        HM_CHECK(journal.stats().live == 2);
+        HM_CHECK(latest(journal, 0) == 4);
+        HM_CHECK(latest(journal, 1) == 3);
+    }
+
+    void recoverFromTornTail()
+    {
+        JournalFile file("torn");
+        {
+            PropertyJournal journal(file.path.c_str());
+            HM_REQUIRE(journal.append(serial_t(kSerial), 0, integer(1)));
+            HM_REQUIRE(journal.append(serial_t(kSerial), 1, integer(2)));
+            HM_REQUIRE(journal.append(serial_t(kSerial), 0, integer(Marker)));
+        }
+
+        // Cut the file in the middle of the last record, as a crash would
+        const size_t torn = file.find(Marker);
+        HM_REQUIRE(torn != std::string::npos);
+        HM_REQUIRE(truncate(file.path.c_str(), static_cast<off_t>(torn)) == 0);
+
+        {
+            PropertyJournal journal(file.path.c_str());
+            HM_REQUIRE(journal.isOpen());
+            HM_CHECK(journal.stats().records == 2);
+            HM_CHECK(latest(journal, 0) == 1);
+            HM_CHECK(latest(journal, 1) == 2);
+
+            // The torn record is overwritten by the next one
+            HM_REQUIRE(journal.append(serial_t(kSerial), 1, integer(3)));
+        }
+
+        PropertyJournal journal(file.path.c_str());
+        HM_CHECK(journal.stats().records == 3);
+        HM_CHECK(latest(journal, 0) == 1);
+        HM_CHECK(latest(journal, 1) == 3);
+    }
+
+    void compactToLatestValues()
+    {
+        JournalFile file("compact");
+        PropertyJournal journal(file.path.c_str(), 1000);
+        for (int32_t i = 0; i < 40; ++i)
+            HM_REQUIRE(journal.append(serial_t(kSerial), i % 2, integer(i)));
+        HM_REQUIRE(journal.stats().records == 40);
+
+        HM_REQUIRE(journal.compact());
+        HM_CHECK(journal.stats().records == 2);
+        HM_CHECK(journal.stats().compactions == 1);
+        HM_CHECK(journal.stats().appended == 40);
+        HM_CHECK(latest(journal, 0) == 38);
+        HM_CHECK(latest(journal, 1) == 39);
+
+        // Appends go to the compacted file
+        HM_REQUIRE(journal.append(serial_t(kSerial), 0, integer(40)));
+        PropertyJournal reopened(file.path.c_str());
+        HM_CHECK(reopened.stats().records == 3);
+        HM_CHECK(latest(reopened, 0) == 40);
+        HM_CHECK(latest(reopened, 1) == 39);
+    }
+
+    void compactWhenMostRecordsAreOutdated()
+    {
+        JournalFile file("auto");
+        PropertyJournal journal(file.path.c_str(), 16);
+        for (int32_t i = 0; i < 64; ++i)
+            HM_REQUIRE(journal.append(serial_t(kSerial), i % 2, integer(i)));
+
+        // Compaction may run on a thread of the journal
+        const auto deadline = std::chrono::steady_clock::now() + std::chrono::seconds(5);
+        while (journal.stats().compactions == 0 && std::chrono::steady_clock::now() < deadline)
+            std::this_thread::sleep_for(std::chrono::milliseconds(1));
+
+        HM_CHECK(journal.stats().compactions > 0);
+        HM_CHECK(journal.stats().records < 64);
+        HM_CHECK(latest(journal, 0) == 62);
+        HM_CHECK(latest(journal, 1) == 63);
+    }
+} // namespace
+
+int main()
+{
+    run("PropertyJournal keeps latest values across reopen", keepLatestValuesAcrossReopen);
+    run("PropertyJournal recovers from a torn tail", recoverFromTornTail);
+    run("PropertyJournal compacts to latest values", compactToLatestValues);
+    run("PropertyJournal compacts when most records are outdated", compactWhenMostRecordsAreOutdated);
+    return result();
+}
+
+#else
+
+int main()
+{
+    return 0;
+}
+
+#endif // HAS_LINUX_HEADERS
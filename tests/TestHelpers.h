@@ -0,0 +1,125 @@
+/**
+ * Hermes - A RPC for IOT
+ * Copyright (C) 2023  Eduard Sargsyan and Andrey Ovodov
+ * 
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ * 
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ * 
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#ifndef HM_TEST_HELPERS_H
+#define HM_TEST_HELPERS_H
+
+#include <hermes/InMemoryIO.h>
+#include <hermes/Message.h>
+#include <hermes/MessageBuilder.h>
+
+#include <stdio.h>
+#include <string.h>
+#include <vector>
+
+/**
+ * Report a failed check and go on with the test case
+*/
+#define HM_CHECK(cond) \
+    do { \
+        if (!(cond)) { \
+            fprintf(stderr, "%s:%d: check failed: %s\n", __FILE__, __LINE__, #cond); \
+            ++hermes::test::failures(); \
+        } \
+    } while (0)
+
+/**
+ * Report a failed check and end the test case
+*/
+#define HM_REQUIRE(cond) \
+    do { \
+        if (!(cond)) { \
+            fprintf(stderr, "%s:%d: requirement failed: %s\n", __FILE__, __LINE__, #cond); \
+            ++hermes::test::failures(); \
+            return; \
+        } \
+    } while (0)
+
+namespace hermes
+{
+namespace test
+{
+    static const byte_t kSerial[HERMES_SERIAL_LENGTH] = { 'T', 'E', 'S', 'T', '0', '0', '0', '1' };
+
+    /**
+     * @return Count of failed checks so far
+    */
+    inline int& failures()
+    {
+        static int count = 0;
+        return count;
+    }
+
+    /**
+     * Run a test case and print its result.
+    */
+    template<class Fn>
+    void run(const char* name, Fn fn)
+    {
+        const int before = failures();
+        fn();
+        printf("%s %s\n", failures() == before ? "PASS" : "FAIL", name);
+    }
+
+    /**
+     * @return Exit code of a test executable
+    */
+    inline int result()
+    {
+        return failures() == 0 ? 0 : 1;
+    }
+
+    /**
+     * Two ends of an in-memory link, what one end writes the other reads.
+     * Reads block until data is there, so tests write before reading.
+    */
+    struct Pipe
+    {
+        static constexpr size_t Capacity = 64 * 1024;
+
+        std::vector<byte_t> ab;
+        std::vector<byte_t> ba;
+        #ifdef HAS_STD_MUTEX
+        std::mutex mx;
+        InMemoryIO a { ab, ba, mx, Capacity };
+        InMemoryIO b { ba, ab, mx, Capacity };
+        #else
+        InMemoryIO a { ab, ba, Capacity };
+        InMemoryIO b { ba, ab, Capacity };
+        #endif // HAS_STD_MUTEX
+    };
+
+    /**
+     * @return Set command for property name with an integer value
+    */
+    inline Message setMessage(const char* name, int32_t value)
+    {
+        Message msg{};
+        MessageBuilder::setSerial(msg, kSerial);
+        msg.type = MessageType::Command;
+        msg.payload.command.command = Command::Set;
+        strncpy(msg.payload.command.data.value.name, name, sizeof(msg.payload.command.data.value.name) - 1);
+        msg.payload.command.data.value.type = ValueType::Integer;
+        msg.payload.command.data.value.value.I = value;
+        msg.payloadLength = sizeof(CommandData);
+        return msg;
+    }
+} // namespace test
+} // namespace hermes
+
+#endif // HM_TEST_HELPERS_H
@@ -0,0 +1,89 @@
+/**
+ * Hermes - A RPC for IOT
+ * Copyright (C) 2023  Eduard Sargsyan and Andrey Ovodov
+ * 
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ * 
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ * 
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#include "TestHelpers.h"
+
+#include <hermes/WorkStealingPool.h>
+
+#ifdef HAS_STD_THREAD_H
+
+#include <atomic>
+#include <chrono>
+#include <thread>
+
+using namespace hermes;
+using namespace hermes::test;
+
+namespace
+{
+    void drainWaitsForStrand()
+    {
+        WorkStealingPool pool(2);
+        std::atomic<int> done { 0 };
+        int key = 0;
+        for (int i = 0; i < 8; ++i) {
+            HM_REQUIRE(pool.post(&key, [&done]() {
+                std::this_thread::sleep_for(std::chrono::milliseconds(2));
+                ++done;
+            }));
+        }
+
+        pool.drain(&key);
+        HM_CHECK(done == 8);
+    }
+
+    void drainFromStrandDropsTheRest()
+    {
+        WorkStealingPool pool(2);
+        std::atomic<int> done { 0 };
+        std::atomic<bool> go { false };
+        int key = 0;
+        HM_REQUIRE(pool.post(&key, [&pool, &done, &go, &key]() {
+            while (!go)
+                std::this_thread::yield();
+            ++done;
+            pool.drain(&key);
+        }));
+        for (int i = 0; i < 4; ++i)
+            HM_REQUIRE(pool.post(&key, [&done]() { ++done; }));
+        go = true;
+
+        pool.wait();
+        HM_CHECK(done == 1);
+        HM_CHECK(pool.stats().pending == 0);
+
+        // The strand is gone, draining returns right away
+        pool.drain(&key);
+    }
+} // namespace
+
+int main()
+{
+    run("WorkStealingPool drain waits for jobs of the strand", drainWaitsForStrand);
+    run("WorkStealingPool drain from the strand drops its queued jobs", drainFromStrandDropsTheRest);
+    return result();
+}
+
+#else
+
+int main()
+{
+    return 0;
+}
+
+#endif // HAS_STD_THREAD_H
@@ -0,0 +1,574 @@
+/**
+ * Hermes - A RPC for IOT
+ * Copyright (C) 2023  Eduard Sargsyan and Andrey Ovodov
+ * 
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ * 
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ * 
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+/**
+ * Load generator: spawns N simulated slaves in a few processes, connects them
+ * over loopback TCP to a single Master and polls them the way an application
+ * would, optionally subscribed to their properties. Slaves reconnect with the
+ * same serial. Reports achieved throughput, latency distribution and memory
+ * used per slave on both sides.
+ *
+ * Build with -DENABLE_LOGGING=OFF, otherwise per-message debug logging
+ * dominates the numbers.
+*/
+
+#include <hermes/DummySlave.h>
+#include <hermes/Master.h>
+#include <hermes/UnixTCPSocketIO.h>
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <getopt.h>
+#include <mutex>
+#include <signal.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <string>
+#include <thread>
+#include <unordered_map>
+#include <vector>
+
+#include <arpa/inet.h>
+#include <netinet/in.h>
+#include <netinet/tcp.h>
+#include <poll.h>
+#include <sys/socket.h>
+#include <sys/wait.h>
+#include <unistd.h>
+
+static_assert(HERMES_SERIAL_LENGTH >= 4, "Load generator encodes process and slave into serial");
+
+using namespace hermes;
+using clock_type = std::chrono::steady_clock;
+
+struct Options
+{
+    unsigned slaves = 100;
+    unsigned procs = 4;
+    unsigned props = 8;
+    unsigned duration = 10;
+    unsigned port = 0;
+    double pollHz = 10;
+    double setHz = 0;
+    double eventHz = 0;
+    double churnHz = 1;
+    double lifetime = 0;
+    unsigned handshakeRate = 0;
+    unsigned handshakeBurst = 1;
+};
+
+static Options g_opts;
+
+static size_t rssKb()
+{
+    size_t pages = 0, resident = 0;
+    FILE* f = fopen("/proc/self/statm", "r");
+    if (f != nullptr) {
+        if (fscanf(f, "%zu %zu", &pages, &resident) != 2)
+            resident = 0;
+        fclose(f);
+    }
+    return resident * sysconf(_SC_PAGESIZE) / 1024;
+}
+
+static void setNoDelay(int fd)
+{
+    const int one = 1;
+    setsockopt(fd, IPPROTO_TCP, TCP_NODELAY, &one, sizeof(one));
+}
+
+/**
+ * Slave with a runtime number of integer properties named "p<index>".
+ * Values drift at churnHz so every Get returns fresh data.
+*/
+class SimSlave : public DummySlave
+{
+public:
+    SimSlave(IO* io, const byte_t* serial, const byte_t* token, uint8_t count, double churnHz)
+        : DummySlave(io, serial, token)
+        , m_count(count)
+        , m_churnHz(churnHz)
+        , m_start(clock_type::now())
+        , m_offsets(count, 0)
+    {}
+
+    uint8_t propertiesCount() override { return m_count; }
+
+    bool propertyName(uint8_t index, char* name) override
+    {
+        if (index >= m_count)
+            return false;
+        snprintf(name, HERMES_PROPERTY_NAME_MAX_LENGTH, "p%u", (unsigned) index);
+        return true;
+    }
+
+    int8_t propertyIndex(const char* name) override
+    {
+        if (name[0] != 'p')
+            return -1;
+        int idx = atoi(name + 1);
+        return idx < m_count ? static_cast<int8_t>(idx) : -1;
+    }
+
+    ValueType propertyType(uint8_t) override { return ValueType::Integer; }
+
+    bool set(uint8_t property, const ValueData& value) override
+    {
+        if (property >= m_count || value.type != ValueType::Integer)
+            return false;
+        m_offsets[property] = value.value.I - drift();
+        return true;
+    }
+
+    bool get(uint8_t property, ValueData& value) override
+    {
+        if (property >= m_count)
+            return false;
+        value.type = ValueType::Integer;
+        value.value.I = m_offsets[property] + drift();
+        return true;
+    }
+
+private:
+    int32_t drift() const
+    {
+        std::chrono::duration<double> elapsed = clock_type::now() - m_start;
+        return static_cast<int32_t>(elapsed.count() * m_churnHz);
+    }
+
+private:
+    uint8_t m_count;
+    double m_churnHz;
+    clock_type::time_point m_start;
+    std::vector<int32_t> m_offsets;
+};
+
+static int connectLoopback(unsigned port)
+{
+    int fd = socket(AF_INET, SOCK_STREAM, 0);
+    if (fd < 0)
+        return -1;
+
+    struct sockaddr_in addr;
+    memset(&addr, 0, sizeof(addr));
+    addr.sin_family = AF_INET;
+    addr.sin_addr.s_addr = htonl(INADDR_LOOPBACK);
+    addr.sin_port = htons(port);
+    if (connect(fd, (struct sockaddr*)&addr, sizeof(addr)) != 0) {
+        ::close(fd);
+        return -1;
+    }
+    setNoDelay(fd);
+    return fd;
+}
+
+/**
+ * Answer requests and push updates of subscriptions until the connection
+ * breaks or until passes.
+*/
+static void serve(SimSlave& slave, UnixTCPSocketIO& io, clock_type::time_point until)
+{
+    const auto tick = std::chrono::milliseconds(HERMES_SUBSCRIPTION_TICK_MS);
+    auto nextPublish = clock_type::now();
+    while (io.good() && clock_type::now() < until) {
+        const bool subscribed = slave.subscriptionsCount() > 0;
+        if (subscribed && clock_type::now() >= nextPublish) {
+            slave.publish();
+            nextPublish = clock_type::now() + tick;
+        }
+        if (io.available() < sizeof(Message)) {
+            struct pollfd pfd = { io.descriptor(), POLLIN, 0 };
+            poll(&pfd, 1, subscribed ? HERMES_SUBSCRIPTION_TICK_MS : 100);
+            continue;
+        }
+        if (!slave.processNextMessage())
+            break;
+    }
+}
+
+static void slaveRoutine(unsigned proc, unsigned idx, clock_type::time_point deadline)
+{
+    // One device per routine, it comes back with the same serial, values and
+    // handshake backoff after every disconnect.
+    byte_t serial[HERMES_SERIAL_LENGTH] = { 'L' };
+    serial[1] = static_cast<byte_t>(proc);
+    serial[2] = static_cast<byte_t>(idx >> 8);
+    serial[3] = static_cast<byte_t>(idx);
+    byte_t token[HERMES_TOKEN_LENGTH] = { 0 };
+    SimSlave slave(nullptr, serial, token, g_opts.props, g_opts.churnHz);
+    std::chrono::duration<double> lifetime(g_opts.lifetime);
+
+    while (clock_type::now() < deadline) {
+        int fd = connectLoopback(g_opts.port);
+        if (fd < 0) {
+            std::this_thread::sleep_for(std::chrono::milliseconds(100));
+            continue;
+        }
+
+        UnixTCPSocketIO io(fd);
+        slave.setIO(&io);
+        if (slave.handshake()) {
+            clock_type::time_point until = deadline;
+            if (g_opts.lifetime > 0) {
+                auto jitter = lifetime * (0.5 + (rand() % 1000) / 1000.0);
+                until = std::min(deadline, clock_type::now() + std::chrono::duration_cast<clock_type::duration>(jitter));
+            }
+            serve(slave, io, until);
+        } else if (slave.retries() == 0) {
+            // Rejected or disconnected, not deferred with a backoff
+            std::this_thread::sleep_for(std::chrono::milliseconds(100));
+        }
+        io.close();
+    }
+}
+
+static void runSlaveProcess(unsigned proc, unsigned count)
+{
+    const size_t baseline = rssKb();
+    auto deadline = clock_type::now() + std::chrono::seconds(g_opts.duration);
+    srand(getpid());
+
+    std::vector<std::thread> threads;
+    for (unsigned i = 0; i < count; ++i)
+        threads.emplace_back(slaveRoutine, proc, i, deadline);
+    for (auto& t : threads)
+        t.detach();
+
+    std::this_thread::sleep_until(deadline);
+    const size_t rss = rssKb();
+    printf("slave process %u: %u slaves, RSS %zu KB (+%zu KB, %.1f KB/slave)\n",
+           proc, count, rss, rss - baseline, count ? double(rss - baseline) / count : 0.0);
+    fflush(stdout);
+    // Slave threads are blocked on sockets, there is nothing to join.
+    _exit(0);
+}
+
+/**
+ * Master side state. Master itself is only touched from the accept thread,
+ * driver threads hand finished connections back through reap. A slave which
+ * reconnected keeps its descriptor, only the driver of its current
+ * connection closes it.
+*/
+struct MasterStats
+{
+    std::mutex mx;
+    std::vector<uint32_t> latencies;
+    uint64_t ok = 0;
+    uint64_t failed = 0;
+    std::vector<std::pair<SlaveDescriptor*, IO*>> reap;
+    std::unordered_map<SlaveDescriptor*, IO*> current;
+    unsigned reconnects = 0;
+
+    std::atomic<uint64_t> updates { 0 };
+    std::atomic<bool> stop { false };
+    std::atomic<unsigned> live { 0 };
+    std::atomic<unsigned> connected { 0 };
+    unsigned peakConnected = 0;
+    unsigned accepted = 0;
+};
+
+static MasterStats g_stats;
+static Master g_master(nullptr);
+static IO* g_pendingIo = nullptr;
+
+static bool acceptAll(const serial_t&, token_t& token)
+{
+    for (int i = 0; i < HERMES_TOKEN_LENGTH; ++i)
+        token.data[i] = rand();
+    return true;
+}
+
+static void driveSlave(SlaveDescriptor* slave, IO* io)
+{
+    std::vector<uint32_t> latencies;
+    uint64_t ok = 0, failed = 0;
+
+    const uint8_t count = slave->propertiesCount();
+    std::vector<std::string> names;
+    for (uint8_t i = 0; i < count; ++i)
+        names.push_back(slave->propertyName(i));
+
+    // Slave forgot subscriptions of its previous connection
+    if (g_opts.eventHz > 0) {
+        const uint16_t interval = static_cast<uint16_t>(std::max(1.0, 1000.0 / g_opts.eventHz));
+        for (uint8_t i = 0; i < count; ++i)
+            slave->subscribe(i, 0, interval, interval);
+    }
+
+    const auto pollInterval = g_opts.pollHz > 0
+        ? std::chrono::duration_cast<clock_type::duration>(std::chrono::duration<double>(1.0 / g_opts.pollHz))
+        : clock_type::duration::zero();
+    const auto setInterval = g_opts.setHz > 0
+        ? std::chrono::duration_cast<clock_type::duration>(std::chrono::duration<double>(1.0 / g_opts.setHz))
+        : clock_type::duration::max();
+
+    auto nextPoll = clock_type::now();
+    auto nextSet = g_opts.setHz > 0 ? nextPoll + setInterval : clock_type::time_point::max();
+    uint8_t idx = 0;
+    ValueData vd;
+
+    while (count > 0 && !g_stats.stop && io->good()) {
+        if (pollInterval != clock_type::duration::zero()) {
+            std::this_thread::sleep_until(nextPoll);
+            nextPoll += pollInterval;
+        }
+
+        slave->poll();
+        const auto start = clock_type::now();
+        bool res;
+        if (start >= nextSet) {
+            nextSet += setInterval;
+            strncpy(vd.name, names[idx].c_str(), HERMES_PROPERTY_NAME_MAX_LENGTH - 1);
+            vd.name[HERMES_PROPERTY_NAME_MAX_LENGTH - 1] = '\0';
+            vd.type = ValueType::Integer;
+            vd.value.I = rand();
+            res = slave->set(idx, vd);
+        } else {
+            res = slave->get(idx, vd);
+        }
+        latencies.push_back(static_cast<uint32_t>(
+            std::chrono::duration_cast<std::chrono::microseconds>(clock_type::now() - start).count()));
+        res ? ++ok : ++failed;
+        idx = (idx + 1) % count;
+    }
+
+    {
+        std::lock_guard<std::mutex> lock(g_stats.mx);
+        g_stats.latencies.insert(g_stats.latencies.end(), latencies.begin(), latencies.end());
+        g_stats.ok += ok;
+        g_stats.failed += failed;
+        g_stats.reap.emplace_back(slave, io);
+    }
+    --g_stats.connected;
+    --g_stats.live;
+}
+
+static void onUpdate(SlaveDescriptor*, const ValueData&)
+{
+    ++g_stats.updates;
+}
+
+static void onNewSlave(SlaveDescriptor* slave)
+{
+    {
+        std::lock_guard<std::mutex> lock(g_stats.mx);
+        IO*& current = g_stats.current[slave];
+        // Requests go over the new connection now, stop the old driver
+        if (current != nullptr) {
+            current->close();
+            ++g_stats.reconnects;
+        }
+        current = g_pendingIo;
+    }
+    slave->setUpdateCallback(onUpdate);
+    ++g_stats.live;
+    g_stats.peakConnected = std::max(g_stats.peakConnected, ++g_stats.connected);
+    std::thread(driveSlave, slave, g_pendingIo).detach();
+}
+
+static void reapSlaves()
+{
+    std::vector<std::pair<SlaveDescriptor*, IO*>> reap;
+    {
+        std::lock_guard<std::mutex> lock(g_stats.mx);
+        reap.swap(g_stats.reap);
+    }
+    for (auto& r : reap) {
+        bool current = false;
+        {
+            std::lock_guard<std::mutex> lock(g_stats.mx);
+            auto it = g_stats.current.find(r.first);
+            if (it != g_stats.current.end() && it->second == r.second) {
+                g_stats.current.erase(it);
+                current = true;
+            }
+        }
+        // Connections replaced by a reconnect are closed already
+        if (current)
+            g_master.close(*r.first);
+        delete r.second;
+    }
+}
+
+static void runMaster(int listenFd)
+{
+    g_master.setAuthenticator(acceptAll);
+    g_master.setOnNewSlaveCallback(onNewSlave);
+
+    AdmissionLimits limits;
+    limits.rate = static_cast<uint16_t>(g_opts.handshakeRate);
+    limits.burst = static_cast<uint16_t>(g_opts.handshakeBurst);
+    g_master.setAdmissionLimits(limits);
+
+    struct timeval tv = { 0, 100 * 1000 };
+    setsockopt(listenFd, SOL_SOCKET, SO_RCVTIMEO, &tv, sizeof(tv));
+
+    const size_t baseline = rssKb();
+    const auto started = clock_type::now();
+    const auto deadline = started + std::chrono::seconds(g_opts.duration);
+
+    while (clock_type::now() < deadline) {
+        reapSlaves();
+        int fd = accept(listenFd, nullptr, nullptr);
+        if (fd < 0)
+            continue;
+        setNoDelay(fd);
+        UnixTCPSocketIO* io = new UnixTCPSocketIO(fd);
+        g_pendingIo = io;
+        ++g_stats.accepted;
+        if (!g_master.accept(io)) {
+            io->close();
+            delete io;
+        }
+    }
+
+    const size_t rss = rssKb();
+    const double elapsed = std::chrono::duration<double>(clock_type::now() - started).count();
+    g_stats.stop = true;
+
+    // Slave processes exit at the same deadline, which unblocks drivers
+    // waiting for a response.
+    for (unsigned i = 0; i < g_opts.procs; ++i)
+        wait(nullptr);
+    while (g_stats.live > 0)
+        std::this_thread::sleep_for(std::chrono::milliseconds(10));
+    reapSlaves();
+
+    std::vector<uint32_t>& lat = g_stats.latencies;
+    std::sort(lat.begin(), lat.end());
+    auto pct = [&lat](double p) { return lat.empty() ? 0u : lat[static_cast<size_t>(p * (lat.size() - 1))]; };
+
+    printf("\n%u slaves x %u properties in %u processes, %.1f s\n", g_opts.slaves, g_opts.props, g_opts.procs, elapsed);
+    printf("poll %.1f Hz, set %.1f Hz, event %.1f Hz, churn %.1f Hz, lifetime %.1f s per slave\n",
+           g_opts.pollHz, g_opts.setHz, g_opts.eventHz, g_opts.churnHz, g_opts.lifetime);
+    printf("connections accepted : %u (peak connected %u, %u reconnects)\n",
+           g_stats.accepted, g_stats.peakConnected, g_stats.reconnects);
+    printf("handshakes           : %u admitted, %u deferred\n",
+           g_master.admissionStats().admitted, g_master.admissionStats().deferred);
+    printf("requests             : %llu ok, %llu failed, %.1f req/s\n",
+           (unsigned long long) g_stats.ok, (unsigned long long) g_stats.failed, g_stats.ok / elapsed);
+    printf("updates              : %llu, %.1f upd/s\n",
+           (unsigned long long) g_stats.updates, g_stats.updates / elapsed);
+    printf("latency (us)         : p50 %u  p90 %u  p99 %u  p99.9 %u  max %u\n",
+           pct(0.5), pct(0.9), pct(0.99), pct(0.999), lat.empty() ? 0u : lat.back());
+    printf("master memory        : RSS %zu KB (+%zu KB, %.1f KB/slave)\n", rss, rss - baseline,
+           g_stats.peakConnected ? double(rss - baseline) / g_stats.peakConnected : 0.0);
+}
+
+static void usage(const char* self)
+{
+    fprintf(stderr,
+        "Usage: %s [options]\n"
+        "  --slaves N      simulated slaves (default 100)\n"
+        "  --procs N       slave processes (default 4)\n"
+        "  --props N       properties per slave, 1..127 (default 8)\n"
+        "  --duration S    test duration in seconds (default 10)\n"
+        "  --poll-hz F     Get requests per slave per second, 0 = flat out (default 10)\n"
+        "  --set-hz F      Set requests per slave per second (default 0)\n"
+        "  --event-hz F    updates per property per second slaves push to subscriptions, 0 = none (default 0)\n"
+        "  --churn-hz F    value changes per property per second (default 1)\n"
+        "  --lifetime S    mean seconds before a slave reconnects, 0 = never (default 0)\n"
+        "  --port N        listen port, 0 = any (default 0)\n"
+        "  --handshake-rate N   handshakes master admits per second, 0 = unlimited (default 0)\n"
+        "  --handshake-burst N  handshakes admitted at once (default 1)\n", self);
+}
+
+int main(int argc, char** argv)
+{
+    static const struct option longOpts[] = {
+        { "slaves",   required_argument, nullptr, 'n' },
+        { "procs",    required_argument, nullptr, 'P' },
+        { "props",    required_argument, nullptr, 'p' },
+        { "duration", required_argument, nullptr, 'd' },
+        { "poll-hz",  required_argument, nullptr, 'r' },
+        { "set-hz",   required_argument, nullptr, 's' },
+        { "event-hz", required_argument, nullptr, 'e' },
+        { "churn-hz", required_argument, nullptr, 'c' },
+        { "lifetime", required_argument, nullptr, 'l' },
+        { "port",     required_argument, nullptr, 'o' },
+        { "handshake-rate",  required_argument, nullptr, 'R' },
+        { "handshake-burst", required_argument, nullptr, 'B' },
+        { "help",     no_argument,       nullptr, 'h' },
+        { nullptr, 0, nullptr, 0 }
+    };
+
+    int opt;
+    while ((opt = getopt_long(argc, argv, "h", longOpts, nullptr)) != -1) {
+        switch (opt) {
+        case 'n': g_opts.slaves = strtoul(optarg, nullptr, 10); break;
+        case 'P': g_opts.procs = strtoul(optarg, nullptr, 10); break;
+        case 'p': g_opts.props = strtoul(optarg, nullptr, 10); break;
+        case 'd': g_opts.duration = strtoul(optarg, nullptr, 10); break;
+        case 'r': g_opts.pollHz = atof(optarg); break;
+        case 's': g_opts.setHz = atof(optarg); break;
+        case 'e': g_opts.eventHz = atof(optarg); break;
+        case 'c': g_opts.churnHz = atof(optarg); break;
+        case 'l': g_opts.lifetime = atof(optarg); break;
+        case 'o': g_opts.port = strtoul(optarg, nullptr, 10); break;
+        case 'R': g_opts.handshakeRate = strtoul(optarg, nullptr, 10); break;
+        case 'B': g_opts.handshakeBurst = strtoul(optarg, nullptr, 10); break;
+        default: usage(argv[0]); return opt == 'h' ? 0 : 1;
+        }
+    }
+
+    if (g_opts.procs == 0 || g_opts.procs > 255 || g_opts.props == 0 || g_opts.props > 127
+        || g_opts.slaves / g_opts.procs > 0xFFFF) {
+        usage(argv[0]);
+        return 1;
+    }
+
+    signal(SIGPIPE, SIG_IGN);
+
+    int listenFd = socket(AF_INET, SOCK_STREAM, 0);
+    struct sockaddr_in addr;
+    memset(&addr, 0, sizeof(addr));
+    addr.sin_family = AF_INET;
+    addr.sin_addr.s_addr = htonl(INADDR_LOOPBACK);
+    addr.sin_port = htons(g_opts.port);
+    socklen_t len = sizeof(addr);
+    const int reuse = 1;
+    setsockopt(listenFd, SOL_SOCKET, SO_REUSEADDR, &reuse, sizeof(reuse));
+    if (listenFd < 0
+        || bind(listenFd, (struct sockaddr*)&addr, sizeof(addr)) != 0
+        || listen(listenFd, SOMAXCONN) != 0
+        || getsockname(listenFd, (struct sockaddr*)&addr, &len) != 0) {
+        fprintf(stderr, "Error: %s\n", strerror(errno));
+        return 1;
+    }
+    g_opts.port = ntohs(addr.sin_port);
+    printf("Listening on 127.0.0.1:%u\n", g_opts.port);
+    fflush(stdout);
+
+    for (unsigned p = 0; p < g_opts.procs; ++p) {
+        const unsigned count = g_opts.slaves / g_opts.procs + (p < g_opts.slaves % g_opts.procs ? 1 : 0);
+        pid_t pid = fork();
+        if (pid == 0) {
+            ::close(listenFd);
+            runSlaveProcess(p, count);
+        } else if (pid < 0) {
+            fprintf(stderr, "Error: fork failed: %s\n", strerror(errno));
+            return 1;
+        }
+    }
+
+    runMaster(listenFd);
+    ::close(listenFd);
+    return 0;
+}